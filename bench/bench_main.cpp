@@ -0,0 +1,237 @@
+#include "CLI11.hpp"
+#include "json.hpp"
+#include "synthetic_model.h"
+
+#include "gltf_bounds.h"
+#include "gltf_compress.h"
+#include "gltf_dedup.h"
+#include "gltf_flatten.h"
+#include "gltf_join.h"
+#include "gltf_prune.h"
+#include "gltf_simplify.h"
+#include "gltf_weld.h"
+#include "pipeline_profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using gltfu::bench::SyntheticModelOptions;
+
+struct BenchCase {
+    std::string name;
+    std::function<bool(tinygltf::Model&)> run;
+};
+
+struct BenchResult {
+    std::string name;
+    bool ok = true;
+    std::vector<double> samplesMs;
+    double minMs = 0.0;
+    double medianMs = 0.0;
+    double meanMs = 0.0;
+    size_t vertices = 0;
+    size_t bufferBytes = 0;
+};
+
+std::vector<BenchCase> makeCases() {
+    std::vector<BenchCase> cases;
+    cases.push_back({"dedupe", [](tinygltf::Model& model) {
+        gltfu::GltfDedup deduper;
+        return deduper.process(model, gltfu::DedupOptions());
+    }});
+    cases.push_back({"flatten", [](tinygltf::Model& model) {
+        gltfu::GltfFlatten::process(model, true);
+        return true;
+    }});
+    cases.push_back({"join", [](tinygltf::Model& model) {
+        gltfu::GltfJoin joiner;
+        return joiner.process(model, gltfu::JoinOptions());
+    }});
+    cases.push_back({"weld", [](tinygltf::Model& model) {
+        gltfu::GltfWeld welder;
+        return welder.process(model, gltfu::WeldOptions());
+    }});
+    cases.push_back({"prune", [](tinygltf::Model& model) {
+        gltfu::GltfPrune pruner;
+        return pruner.process(model, gltfu::PruneOptions());
+    }});
+    cases.push_back({"simplify", [](tinygltf::Model& model) {
+        gltfu::GltfSimplify simplifier;
+        gltfu::SimplifyOptions options;
+        options.ratio = 0.25f;
+        options.error = 0.01f;
+        return simplifier.process(model, options);
+    }});
+    cases.push_back({"bounds", [](tinygltf::Model& model) {
+        gltfu::GltfBounds::computeAllBounds(model);
+        return true;
+    }});
+#ifdef GLTFU_ENABLE_DRACO
+    cases.push_back({"compress", [](tinygltf::Model& model) {
+        gltfu::GltfCompress compressor;
+        return compressor.process(model, gltfu::CompressOptions());
+    }});
+    cases.push_back({"compress-setup", [](tinygltf::Model& model) {
+        return gltfu::GltfCompress::buildMeshes(model) > 0;
+    }});
+    cases.push_back({"compress-setup-pervertex", [](tinygltf::Model& model) {
+        return gltfu::GltfCompress::buildMeshes(model, true) > 0;
+    }});
+#endif
+    return cases;
+}
+
+bool selected(const std::string& name, const std::vector<std::string>& filters) {
+    return filters.empty() || std::find(filters.begin(), filters.end(), name) != filters.end();
+}
+
+BenchResult runCase(const BenchCase& benchCase, const SyntheticModelOptions& modelOptions, int iterations) {
+    BenchResult result;
+    result.name = benchCase.name;
+
+    for (int i = 0; i < iterations; ++i) {
+        // Generation is not timed; every iteration gets a pristine model.
+        tinygltf::Model model = gltfu::bench::generateSyntheticModel(modelOptions);
+        const gltfu::ModelCounts counts = gltfu::ModelCounts::from(model);
+        result.vertices = counts.vertices;
+        result.bufferBytes = counts.bufferBytes;
+
+        const auto start = std::chrono::steady_clock::now();
+        const bool ok = benchCase.run(model);
+        const auto end = std::chrono::steady_clock::now();
+
+        result.ok = result.ok && ok;
+        result.samplesMs.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    std::vector<double> sorted = result.samplesMs;
+    std::sort(sorted.begin(), sorted.end());
+    result.minMs = sorted.front();
+    result.medianMs = sorted[sorted.size() / 2];
+    double total = 0.0;
+    for (double sample : sorted) {
+        total += sample;
+    }
+    result.meanMs = total / static_cast<double>(sorted.size());
+    return result;
+}
+
+double perSecond(double amount, double ms) {
+    return ms > 0.0 ? amount / (ms / 1000.0) : 0.0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    CLI::App app{"gltfu_bench - Benchmark gltfu passes on synthetic models"};
+
+    SyntheticModelOptions modelOptions;
+    int iterations = 5;
+    std::vector<std::string> filters;
+    std::string jsonOutput;
+
+    app.add_option("--meshes", modelOptions.meshes, "Number of meshes")
+        ->check(CLI::PositiveNumber);
+    app.add_option("--vertices", modelOptions.verticesPerMesh, "Grid vertices per mesh")
+        ->check(CLI::PositiveNumber);
+    app.add_option("--duplicate-meshes", modelOptions.duplicateMeshRatio,
+                   "Fraction of meshes duplicating another mesh")
+        ->check(CLI::Range(0.0f, 1.0f));
+    app.add_option("--split-vertices", modelOptions.splitVertexRatio,
+                   "Fraction of grid cells with unshared vertices")
+        ->check(CLI::Range(0.0f, 1.0f));
+    app.add_option("--depth", modelOptions.hierarchyDepth, "Transform nodes above each mesh")
+        ->check(CLI::NonNegativeNumber);
+    app.add_option("--textures", modelOptions.textures, "Number of textures")
+        ->check(CLI::NonNegativeNumber);
+    app.add_option("--duplicate-textures", modelOptions.duplicateTextureRatio,
+                   "Fraction of textures duplicating another texture")
+        ->check(CLI::Range(0.0f, 1.0f));
+    app.add_option("--texture-size", modelOptions.textureSize, "Texture width and height")
+        ->check(CLI::PositiveNumber);
+    app.add_option("--seed", modelOptions.seed, "Random seed");
+    app.add_option("-n,--iterations", iterations, "Timed runs per benchmark")
+        ->check(CLI::PositiveNumber);
+    app.add_option("--filter", filters, "Only run the named benchmarks");
+    app.add_option("--json", jsonOutput, "Write results as JSON to this file ('-' for stdout)");
+
+    try {
+        app.parse(argc, argv);
+    } catch (const CLI::ParseError& e) {
+        return app.exit(e);
+    }
+
+    const bool jsonToStdout = jsonOutput == "-";
+    std::ostream& log = jsonToStdout ? std::cerr : std::cout;
+
+    std::vector<BenchResult> results;
+    for (const auto& benchCase : makeCases()) {
+        if (!selected(benchCase.name, filters)) {
+            continue;
+        }
+        results.push_back(runCase(benchCase, modelOptions, iterations));
+
+        const BenchResult& result = results.back();
+        log << std::left << std::setw(10) << result.name << std::right << std::fixed << std::setprecision(2)
+            << " median " << std::setw(10) << result.medianMs << " ms"
+            << "  min " << std::setw(10) << result.minMs << " ms"
+            << "  " << std::setw(8) << perSecond(static_cast<double>(result.vertices), result.medianMs) / 1e6 << " Mvert/s"
+            << "  " << std::setw(8) << perSecond(static_cast<double>(result.bufferBytes) / (1 << 20), result.medianMs) << " MB/s"
+            << (result.ok ? "" : "  (failed)") << std::endl;
+    }
+
+    if (!jsonOutput.empty()) {
+        nlohmann::json report;
+        report["model"] = {
+            {"meshes", modelOptions.meshes},
+            {"verticesPerMesh", modelOptions.verticesPerMesh},
+            {"duplicateMeshRatio", modelOptions.duplicateMeshRatio},
+            {"splitVertexRatio", modelOptions.splitVertexRatio},
+            {"hierarchyDepth", modelOptions.hierarchyDepth},
+            {"textures", modelOptions.textures},
+            {"duplicateTextureRatio", modelOptions.duplicateTextureRatio},
+            {"textureSize", modelOptions.textureSize},
+            {"seed", modelOptions.seed},
+        };
+        report["iterations"] = iterations;
+        report["results"] = nlohmann::json::array();
+        for (const auto& result : results) {
+            report["results"].push_back({
+                {"name", result.name},
+                {"ok", result.ok},
+                {"minMs", result.minMs},
+                {"medianMs", result.medianMs},
+                {"meanMs", result.meanMs},
+                {"samplesMs", result.samplesMs},
+                {"vertices", result.vertices},
+                {"bufferBytes", result.bufferBytes},
+                {"verticesPerSec", perSecond(static_cast<double>(result.vertices), result.medianMs)},
+                {"megabytesPerSec", perSecond(static_cast<double>(result.bufferBytes) / (1 << 20), result.medianMs)},
+            });
+        }
+
+        if (jsonToStdout) {
+            std::cout << report.dump(2) << std::endl;
+        } else {
+            std::ofstream file(jsonOutput);
+            if (!file) {
+                std::cerr << "Error: failed to open " << jsonOutput << std::endl;
+                return 1;
+            }
+            file << report.dump(2) << std::endl;
+        }
+    }
+
+    const bool allOk = std::all_of(results.begin(), results.end(),
+                                   [](const BenchResult& result) { return result.ok; });
+    return allOk ? 0 : 1;
+}
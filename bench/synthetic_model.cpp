@@ -0,0 +1,237 @@
+#include "synthetic_model.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace gltfu {
+namespace bench {
+namespace {
+
+struct Vertex {
+    float position[3];
+    float normal[3];
+    float uv[2];
+};
+
+struct MeshData {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+};
+
+// Height field with a per-mesh phase so that distinct meshes never hash equal.
+MeshData buildGrid(int side, float phase, float splitRatio, std::mt19937& rng) {
+    MeshData mesh;
+    const float step = 1.0f / static_cast<float>(side - 1);
+
+    auto makeVertex = [&](int x, int z) {
+        const float fx = static_cast<float>(x) * step;
+        const float fz = static_cast<float>(z) * step;
+        const float height = 0.1f * std::sin(6.0f * fx + phase) * std::cos(6.0f * fz - phase);
+        const float dx = 0.6f * std::cos(6.0f * fx + phase) * std::cos(6.0f * fz - phase);
+        const float dz = -0.6f * std::sin(6.0f * fx + phase) * std::sin(6.0f * fz - phase);
+        const float length = std::sqrt(dx * dx + 1.0f + dz * dz);
+
+        Vertex vertex{};
+        vertex.position[0] = fx;
+        vertex.position[1] = height;
+        vertex.position[2] = fz;
+        vertex.normal[0] = -dx / length;
+        vertex.normal[1] = 1.0f / length;
+        vertex.normal[2] = -dz / length;
+        vertex.uv[0] = fx;
+        vertex.uv[1] = fz;
+        return vertex;
+    };
+
+    mesh.vertices.reserve(static_cast<size_t>(side) * side);
+    for (int z = 0; z < side; ++z) {
+        for (int x = 0; x < side; ++x) {
+            mesh.vertices.push_back(makeVertex(x, z));
+        }
+    }
+
+    std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+    mesh.indices.reserve(static_cast<size_t>(side - 1) * (side - 1) * 6);
+    for (int z = 0; z + 1 < side; ++z) {
+        for (int x = 0; x + 1 < side; ++x) {
+            uint32_t corners[4] = {
+                static_cast<uint32_t>(z * side + x),
+                static_cast<uint32_t>(z * side + x + 1),
+                static_cast<uint32_t>((z + 1) * side + x),
+                static_cast<uint32_t>((z + 1) * side + x + 1),
+            };
+            if (chance(rng) < splitRatio) {
+                // Emit private copies of the corners; weld should merge them back.
+                for (auto& corner : corners) {
+                    const Vertex copy = mesh.vertices[corner];
+                    corner = static_cast<uint32_t>(mesh.vertices.size());
+                    mesh.vertices.push_back(copy);
+                }
+            }
+            mesh.indices.insert(mesh.indices.end(), {corners[0], corners[2], corners[1],
+                                                     corners[1], corners[2], corners[3]});
+        }
+    }
+    return mesh;
+}
+
+int appendView(tinygltf::Model& model, const void* data, size_t size, int target) {
+    auto& buffer = model.buffers[0].data;
+    const size_t offset = buffer.size();
+    buffer.resize(offset + size);
+    std::memcpy(buffer.data() + offset, data, size);
+
+    tinygltf::BufferView view;
+    view.buffer = 0;
+    view.byteOffset = offset;
+    view.byteLength = size;
+    view.target = target;
+    model.bufferViews.push_back(view);
+    return static_cast<int>(model.bufferViews.size() - 1);
+}
+
+int appendAccessor(tinygltf::Model& model, int view, int componentType, int type, size_t count) {
+    tinygltf::Accessor accessor;
+    accessor.bufferView = view;
+    accessor.componentType = componentType;
+    accessor.type = type;
+    accessor.count = count;
+    model.accessors.push_back(accessor);
+    return static_cast<int>(model.accessors.size() - 1);
+}
+
+int appendMesh(tinygltf::Model& model, const MeshData& data, int material) {
+    const size_t count = data.vertices.size();
+    std::vector<float> positions(count * 3);
+    std::vector<float> normals(count * 3);
+    std::vector<float> uvs(count * 2);
+    for (size_t i = 0; i < count; ++i) {
+        std::copy(data.vertices[i].position, data.vertices[i].position + 3, positions.begin() + i * 3);
+        std::copy(data.vertices[i].normal, data.vertices[i].normal + 3, normals.begin() + i * 3);
+        std::copy(data.vertices[i].uv, data.vertices[i].uv + 2, uvs.begin() + i * 2);
+    }
+
+    tinygltf::Primitive primitive;
+    primitive.mode = TINYGLTF_MODE_TRIANGLES;
+    primitive.material = material;
+    primitive.attributes["POSITION"] = appendAccessor(
+        model, appendView(model, positions.data(), positions.size() * sizeof(float), TINYGLTF_TARGET_ARRAY_BUFFER),
+        TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC3, count);
+    primitive.attributes["NORMAL"] = appendAccessor(
+        model, appendView(model, normals.data(), normals.size() * sizeof(float), TINYGLTF_TARGET_ARRAY_BUFFER),
+        TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC3, count);
+    primitive.attributes["TEXCOORD_0"] = appendAccessor(
+        model, appendView(model, uvs.data(), uvs.size() * sizeof(float), TINYGLTF_TARGET_ARRAY_BUFFER),
+        TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC2, count);
+    primitive.indices = appendAccessor(
+        model, appendView(model, data.indices.data(), data.indices.size() * sizeof(uint32_t),
+                          TINYGLTF_TARGET_ELEMENT_ARRAY_BUFFER),
+        TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT, TINYGLTF_TYPE_SCALAR, data.indices.size());
+
+    tinygltf::Mesh mesh;
+    mesh.primitives.push_back(std::move(primitive));
+    model.meshes.push_back(std::move(mesh));
+    return static_cast<int>(model.meshes.size() - 1);
+}
+
+void appendTextures(tinygltf::Model& model, const SyntheticModelOptions& options, std::mt19937& rng) {
+    std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+    std::uniform_int_distribution<int> byte(0, 255);
+    const int size = std::max(1, options.textureSize);
+
+    model.samplers.emplace_back();
+    for (int i = 0; i < options.textures; ++i) {
+        tinygltf::Image image;
+        image.width = size;
+        image.height = size;
+        image.component = 4;
+        image.bits = 8;
+        image.pixel_type = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+        image.mimeType = "image/png";
+        if (i > 0 && chance(rng) < options.duplicateTextureRatio) {
+            image.image = model.images[std::uniform_int_distribution<int>(0, i - 1)(rng)].image;
+        } else {
+            image.image.resize(static_cast<size_t>(size) * size * 4);
+            for (auto& value : image.image) {
+                value = static_cast<unsigned char>(byte(rng));
+            }
+        }
+        model.images.push_back(std::move(image));
+
+        tinygltf::Texture texture;
+        texture.source = i;
+        texture.sampler = 0;
+        model.textures.push_back(texture);
+    }
+}
+
+} // namespace
+
+tinygltf::Model generateSyntheticModel(const SyntheticModelOptions& options) {
+    tinygltf::Model model;
+    model.asset.version = "2.0";
+    model.asset.generator = "gltfu_bench";
+    model.buffers.emplace_back();
+
+    std::mt19937 rng(options.seed);
+    std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+
+    appendTextures(model, options, rng);
+
+    const int side = std::max(2, static_cast<int>(std::lround(std::sqrt(std::max(4, options.verticesPerMesh)))));
+    std::vector<MeshData> originals;
+    std::vector<int> originalMaterials;
+
+    tinygltf::Scene scene;
+    for (int i = 0; i < options.meshes; ++i) {
+        const MeshData* data = nullptr;
+        tinygltf::Material material;
+        material.pbrMetallicRoughness.baseColorFactor = {1.0, 1.0, 1.0, 1.0};
+
+        if (!originals.empty() && chance(rng) < options.duplicateMeshRatio) {
+            const size_t source = std::uniform_int_distribution<size_t>(0, originals.size() - 1)(rng);
+            data = &originals[source];
+            material = model.materials[originalMaterials[source]];
+        } else {
+            originals.push_back(buildGrid(side, static_cast<float>(originals.size()) * 0.37f,
+                                          options.splitVertexRatio, rng));
+            data = &originals.back();
+            material.pbrMetallicRoughness.baseColorFactor = {chance(rng), chance(rng), chance(rng), 1.0};
+            if (options.textures > 0) {
+                material.pbrMetallicRoughness.baseColorTexture.index = i % options.textures;
+            }
+            originalMaterials.push_back(static_cast<int>(model.materials.size()));
+        }
+
+        model.materials.push_back(material);
+        const int mesh = appendMesh(model, *data, static_cast<int>(model.materials.size() - 1));
+
+        // Chain of translated transform nodes ending in the mesh node.
+        int parent = -1;
+        for (int depth = 0; depth <= options.hierarchyDepth; ++depth) {
+            tinygltf::Node node;
+            node.translation = {static_cast<double>(i % 16) * 1.1, 0.0, static_cast<double>(depth + i / 16) * 1.1};
+            if (depth == options.hierarchyDepth) {
+                node.mesh = mesh;
+            }
+            const int nodeIdx = static_cast<int>(model.nodes.size());
+            model.nodes.push_back(std::move(node));
+            if (parent < 0) {
+                scene.nodes.push_back(nodeIdx);
+            } else {
+                model.nodes[parent].children.push_back(nodeIdx);
+            }
+            parent = nodeIdx;
+        }
+    }
+
+    model.scenes.push_back(std::move(scene));
+    model.defaultScene = 0;
+    return model;
+}
+
+} // namespace bench
+} // namespace gltfu
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "tiny_gltf.h"
+
+#include <cstdint>
+
+namespace gltfu {
+namespace bench {
+
+/**
+ * Controls the shape of a procedurally generated model.
+ */
+struct SyntheticModelOptions {
+    int meshes = 64;                    // Number of meshes (one primitive each)
+    int verticesPerMesh = 16384;        // Shared grid vertices per mesh (rounded to a square grid)
+    float duplicateMeshRatio = 0.25f;   // Fraction of meshes that byte-copy another mesh's geometry
+    float splitVertexRatio = 0.25f;     // Fraction of grid cells emitted with unshared vertices
+    int hierarchyDepth = 3;             // Transform nodes above each mesh node
+    int textures = 8;                   // Number of images/textures
+    float duplicateTextureRatio = 0.25f;// Fraction of images that copy another image's pixels
+    int textureSize = 64;               // Width and height of generated images
+    uint32_t seed = 1;                  // Random seed, identical seeds give identical models
+};
+
+/**
+ * Generate a self-contained model in memory.
+ *
+ * Meshes are height-field grids with POSITION, NORMAL and TEXCOORD_0
+ * attributes stored in a single buffer, each under its own chain of
+ * translated nodes. Duplicate meshes, materials and images are exact byte
+ * copies so dedupe has work to do, and split cells give weld work.
+ */
+tinygltf::Model generateSyntheticModel(const SyntheticModelOptions& options);
+
+} // namespace bench
+} // namespace gltfu
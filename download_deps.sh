@@ -32,6 +32,7 @@ echo "Downloading meshoptimizer ${MESHOPT_VERSION}..."
 curl -L https://raw.githubusercontent.com/zeux/meshoptimizer/${MESHOPT_VERSION}/src/meshoptimizer.h -o "$THIRD_PARTY_DIR/meshoptimizer.h"
 curl -L https://raw.githubusercontent.com/zeux/meshoptimizer/${MESHOPT_VERSION}/src/simplifier.cpp -o "$THIRD_PARTY_DIR/meshoptimizer_simplifier.cpp"
 curl -L https://raw.githubusercontent.com/zeux/meshoptimizer/${MESHOPT_VERSION}/src/allocator.cpp -o "$THIRD_PARTY_DIR/meshoptimizer_allocator.cpp"
+curl -L https://raw.githubusercontent.com/zeux/meshoptimizer/${MESHOPT_VERSION}/src/clusterizer.cpp -o "$THIRD_PARTY_DIR/meshoptimizer_clusterizer.cpp"
 
 echo "Downloading xxHash ${XXHASH_VERSION}..."
 curl -L https://raw.githubusercontent.com/Cyan4973/xxHash/${XXHASH_VERSION}/xxhash.h -o "$THIRD_PARTY_DIR/xxhash.h"
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "tiny_gltf.h"
+
+#include <cstring>
+#include <vector>
+
+namespace gltfu {
+
+/**
+ * Stages data that a pass appends to a buffer and splices it in with a single copy.
+ *
+ * Appending blob by blob to a buffer that already holds hundreds of megabytes
+ * reallocates and copies the whole buffer every time its capacity runs out.
+ * The arena collects the blobs in a side vector instead and grows the target
+ * buffer exactly once in commit().
+ *
+ * Views returned by append() already carry their final byteOffset, but their
+ * bytes only become visible in the model after commit(). Nothing else may
+ * write to the target buffer while the arena is open.
+ */
+class BufferArena {
+public:
+    explicit BufferArena(tinygltf::Model& model, int bufferIdx = 0)
+        : model_(model), bufferIdx_(bufferIdx) {
+        const size_t current = bufferIdx_ < static_cast<int>(model_.buffers.size())
+            ? model_.buffers[bufferIdx_].data.size() : 0;
+        base_ = align(current);
+    }
+
+    ~BufferArena() {
+        // Keep the model consistent if a pass bailed out before committing
+        try {
+            commit();
+        } catch (...) {
+        }
+    }
+
+    BufferArena(const BufferArena&) = delete;
+    BufferArena& operator=(const BufferArena&) = delete;
+
+    /**
+     * Stage bytes at the next 4-byte aligned offset and create a bufferView for them.
+     * @return Index of the new bufferView
+     */
+    int append(const void* data, size_t size, int target, size_t byteStride = 0) {
+        const size_t offset = align(staged_.size());
+        staged_.resize(offset + size);
+        if (size > 0) {
+            std::memcpy(staged_.data() + offset, data, size);
+        }
+
+        tinygltf::BufferView view;
+        view.buffer = bufferIdx_;
+        view.byteOffset = base_ + offset;
+        view.byteLength = size;
+        view.byteStride = byteStride;
+        view.target = target;
+        model_.bufferViews.push_back(view);
+        return static_cast<int>(model_.bufferViews.size() - 1);
+    }
+
+    /** Bytes staged so far (including alignment padding). */
+    size_t size() const { return staged_.size(); }
+
+    /** Splice all staged bytes into the target buffer. Safe to call more than once. */
+    void commit() {
+        if (staged_.empty()) {
+            return;
+        }
+        while (static_cast<int>(model_.buffers.size()) <= bufferIdx_) {
+            model_.buffers.emplace_back();
+        }
+
+        auto& data = model_.buffers[bufferIdx_].data;
+        data.reserve(base_ + staged_.size());
+        data.resize(base_);
+        data.insert(data.end(), staged_.begin(), staged_.end());
+
+        base_ += align(staged_.size());
+        staged_.clear();
+        staged_.shrink_to_fit();
+    }
+
+private:
+    static size_t align(size_t value) { return (value + 3) & ~size_t(3); }
+
+    tinygltf::Model& model_;
+    int bufferIdx_;
+    size_t base_ = 0;
+    std::vector<unsigned char> staged_;
+};
+
+} // namespace gltfu
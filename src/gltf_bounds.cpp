@@ -77,4 +77,33 @@ bool GltfBounds::computeAccessorBounds(tinygltf::Model& model, int accessorIdx)
     return true;
 }
 
+bool GltfBounds::computeMeshBounds(tinygltf::Model& model, int meshIdx, Vector3& min, Vector3& max) {
+    if (meshIdx < 0 || meshIdx >= static_cast<int>(model.meshes.size())) {
+        return false;
+    }
+
+    bool found = false;
+    for (const auto& primitive : model.meshes[meshIdx].primitives) {
+        auto posIt = primitive.attributes.find("POSITION");
+        if (posIt == primitive.attributes.end() || posIt->second < 0 ||
+            posIt->second >= static_cast<int>(model.accessors.size())) {
+            continue;
+        }
+
+        const auto& accessor = model.accessors[posIt->second];
+        if ((accessor.minValues.size() < 3 || accessor.maxValues.size() < 3) &&
+            !computeAccessorBounds(model, posIt->second)) {
+            continue;
+        }
+
+        for (size_t axis = 0; axis < 3; ++axis) {
+            min[axis] = found ? std::min(min[axis], accessor.minValues[axis]) : accessor.minValues[axis];
+            max[axis] = found ? std::max(max[axis], accessor.maxValues[axis]) : accessor.maxValues[axis];
+        }
+        found = true;
+    }
+
+    return found;
+}
+
 } // namespace gltfu
@@ -1,4 +1,5 @@
 #pragma once
+#include "math_utils.h"
 #include "tiny_gltf.h"
 
 namespace gltfu {
@@ -22,6 +23,16 @@ public:
      * @return true if successful, false otherwise
      */
     static bool computeAccessorBounds(tinygltf::Model& model, int accessorIdx);
+
+    /**
+     * @brief Local bounds of a mesh as the union of its POSITION accessor bounds
+     * @param model The GLTF model (missing accessor bounds are computed and stored)
+     * @param meshIdx The mesh index
+     * @param min Receives the minimum corner
+     * @param max Receives the maximum corner
+     * @return true if any primitive contributed bounds
+     */
+    static bool computeMeshBounds(tinygltf::Model& model, int meshIdx, Vector3& min, Vector3& max);
 };
 
 } // namespace gltfu
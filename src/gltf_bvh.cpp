@@ -0,0 +1,303 @@
+#include "gltf_bvh.h"
+#include "buffer_arena.h"
+#include "gltf_bounds.h"
+#include "gltf_flatten.h"
+#include "math_utils.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+namespace gltfu {
+namespace {
+
+// Serialized tree node, 32 bytes
+struct BvhNode {
+    float min[3];
+    uint32_t a;
+    float max[3];
+    uint32_t count;
+};
+
+struct BvhItem {
+    Vector3 min;
+    Vector3 max;
+    Vector3 centroid;
+    uint32_t node;
+};
+
+// Subtree still to be built; patch is the inner node whose second-child index it fills in
+struct BuildTask {
+    size_t begin;
+    size_t end;
+    int patch;
+    int depth;
+};
+
+struct Box {
+    Vector3 min{std::numeric_limits<double>::max(), std::numeric_limits<double>::max(),
+                std::numeric_limits<double>::max()};
+    Vector3 max{std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest(),
+                std::numeric_limits<double>::lowest()};
+
+    void grow(const Vector3& lo, const Vector3& hi) {
+        for (size_t axis = 0; axis < 3; ++axis) {
+            min[axis] = std::min(min[axis], lo[axis]);
+            max[axis] = std::max(max[axis], hi[axis]);
+        }
+    }
+
+    double area() const {
+        const double dx = std::max(0.0, max[0] - min[0]);
+        const double dy = std::max(0.0, max[1] - min[1]);
+        const double dz = std::max(0.0, max[2] - min[2]);
+        return 2.0 * (dx * dy + dy * dz + dz * dx);
+    }
+};
+
+float roundDown(double value) {
+    float result = static_cast<float>(value);
+    if (static_cast<double>(result) > value) {
+        result = std::nextafter(result, -std::numeric_limits<float>::infinity());
+    }
+    return result;
+}
+
+float roundUp(double value) {
+    float result = static_cast<float>(value);
+    if (static_cast<double>(result) < value) {
+        result = std::nextafter(result, std::numeric_limits<float>::infinity());
+    }
+    return result;
+}
+
+std::vector<int> sceneNodes(const tinygltf::Model& model, int& sceneIdx) {
+    std::vector<int> nodes;
+    if (model.scenes.empty()) {
+        sceneIdx = -1;
+        for (size_t i = 0; i < model.nodes.size(); ++i) {
+            nodes.push_back(static_cast<int>(i));
+        }
+        return nodes;
+    }
+
+    sceneIdx = model.defaultScene >= 0 && model.defaultScene < static_cast<int>(model.scenes.size())
+                   ? model.defaultScene
+                   : 0;
+    std::vector<char> visited(model.nodes.size(), 0);
+    std::vector<int> stack(model.scenes[sceneIdx].nodes.rbegin(), model.scenes[sceneIdx].nodes.rend());
+    while (!stack.empty()) {
+        const int nodeIdx = stack.back();
+        stack.pop_back();
+        if (nodeIdx < 0 || nodeIdx >= static_cast<int>(model.nodes.size()) || visited[nodeIdx]) {
+            continue;
+        }
+        visited[nodeIdx] = 1;
+        nodes.push_back(nodeIdx);
+        const auto& children = model.nodes[nodeIdx].children;
+        stack.insert(stack.end(), children.rbegin(), children.rend());
+    }
+    return nodes;
+}
+
+} // namespace
+
+bool GltfBvh::process(tinygltf::Model& model, const BvhOptions& options) {
+    error_.clear();
+    stats_.clear();
+
+    if (options.maxLeafSize < 1 || options.bins < 2) {
+        error_ = "maxLeafSize must be at least 1 and bins at least 2";
+        return false;
+    }
+
+    TraceScope traceScope("bvh", "build");
+
+    int sceneIdx = -1;
+    const std::vector<int> nodes = sceneNodes(model, sceneIdx);
+    const std::vector<Matrix4> world = GltfFlatten::computeWorldMatrices(model);
+
+    std::vector<char> meshValid(model.meshes.size(), 0);
+    std::vector<Vector3> meshMin(model.meshes.size());
+    std::vector<Vector3> meshMax(model.meshes.size());
+    for (size_t meshIdx = 0; meshIdx < model.meshes.size(); ++meshIdx) {
+        meshValid[meshIdx] = GltfBounds::computeMeshBounds(model, static_cast<int>(meshIdx), meshMin[meshIdx],
+                                                           meshMax[meshIdx]);
+    }
+
+    std::vector<BvhItem> items;
+    for (const int nodeIdx : nodes) {
+        const int meshIdx = model.nodes[nodeIdx].mesh;
+        if (meshIdx < 0 || meshIdx >= static_cast<int>(model.meshes.size()) || !meshValid[meshIdx]) {
+            continue;
+        }
+        BvhItem item;
+        transformBounds(world[nodeIdx], meshMin[meshIdx], meshMax[meshIdx], item.min, item.max);
+        for (size_t axis = 0; axis < 3; ++axis) {
+            item.centroid[axis] = 0.5 * (item.min[axis] + item.max[axis]);
+        }
+        item.node = static_cast<uint32_t>(nodeIdx);
+        items.push_back(item);
+    }
+
+    if (items.empty()) {
+        stats_ = "No mesh nodes to index";
+        return true;
+    }
+
+    std::vector<BvhNode> tree;
+    tree.reserve(items.size() * 2);
+    size_t leaves = 0;
+    int maxDepth = 0;
+
+    const size_t binCount = static_cast<size_t>(options.bins);
+    std::vector<Box> binBoxes(binCount);
+    std::vector<size_t> binCounts(binCount);
+    std::vector<double> rightArea(binCount);
+    std::vector<size_t> rightCount(binCount);
+
+    std::vector<BuildTask> stack{{0, items.size(), -1, 0}};
+    while (!stack.empty()) {
+        const BuildTask task = stack.back();
+        stack.pop_back();
+
+        const uint32_t nodeIdx = static_cast<uint32_t>(tree.size());
+        if (task.patch >= 0) {
+            tree[task.patch].a = nodeIdx;
+        }
+        maxDepth = std::max(maxDepth, task.depth);
+
+        Box bounds;
+        Box centroids;
+        for (size_t i = task.begin; i < task.end; ++i) {
+            bounds.grow(items[i].min, items[i].max);
+            centroids.grow(items[i].centroid, items[i].centroid);
+        }
+
+        BvhNode node;
+        for (size_t axis = 0; axis < 3; ++axis) {
+            node.min[axis] = roundDown(bounds.min[axis]);
+            node.max[axis] = roundUp(bounds.max[axis]);
+        }
+        node.a = 0;
+        node.count = 0;
+
+        // Binned SAH: cost of a split relative to intersecting every item in this node
+        const size_t count = task.end - task.begin;
+        const double parentArea = bounds.area();
+        double bestCost = std::numeric_limits<double>::max();
+        int bestAxis = -1;
+        size_t bestBin = 0;
+        for (int axis = 0; axis < 3 && count > 1; ++axis) {
+            const double lo = centroids.min[axis];
+            const double extent = centroids.max[axis] - lo;
+            if (extent <= 0.0) {
+                continue;
+            }
+            const double scale = static_cast<double>(binCount) / extent;
+            std::fill(binBoxes.begin(), binBoxes.end(), Box());
+            std::fill(binCounts.begin(), binCounts.end(), 0);
+            for (size_t i = task.begin; i < task.end; ++i) {
+                const size_t bin = std::min(binCount - 1, static_cast<size_t>((items[i].centroid[axis] - lo) * scale));
+                binBoxes[bin].grow(items[i].min, items[i].max);
+                ++binCounts[bin];
+            }
+
+            Box right;
+            size_t rightItems = 0;
+            for (size_t bin = binCount - 1; bin > 0; --bin) {
+                right.grow(binBoxes[bin].min, binBoxes[bin].max);
+                rightItems += binCounts[bin];
+                rightArea[bin] = right.area();
+                rightCount[bin] = rightItems;
+            }
+
+            Box left;
+            size_t leftItems = 0;
+            for (size_t bin = 1; bin < binCount; ++bin) {
+                left.grow(binBoxes[bin - 1].min, binBoxes[bin - 1].max);
+                leftItems += binCounts[bin - 1];
+                if (leftItems == 0 || rightCount[bin] == 0) {
+                    continue;
+                }
+                const double cost = 1.0 + (left.area() * static_cast<double>(leftItems) +
+                                           rightArea[bin] * static_cast<double>(rightCount[bin])) /
+                                              std::max(parentArea, std::numeric_limits<double>::min());
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin = bin;
+                }
+            }
+        }
+
+        const bool fitsLeaf = count <= static_cast<size_t>(options.maxLeafSize);
+        if (count == 1 || (fitsLeaf && (bestAxis < 0 || bestCost >= static_cast<double>(count)))) {
+            node.a = static_cast<uint32_t>(task.begin);
+            node.count = static_cast<uint32_t>(count);
+            tree.push_back(node);
+            ++leaves;
+            continue;
+        }
+
+        size_t mid = task.begin + count / 2;
+        if (bestAxis >= 0) {
+            const double lo = centroids.min[bestAxis];
+            const double scale = static_cast<double>(binCount) / (centroids.max[bestAxis] - lo);
+            const auto split = std::partition(
+                items.begin() + task.begin, items.begin() + task.end, [&](const BvhItem& item) {
+                    return std::min(binCount - 1, static_cast<size_t>((item.centroid[bestAxis] - lo) * scale)) <
+                           bestBin;
+                });
+            mid = static_cast<size_t>(split - items.begin());
+        }
+        // Coincident centroids leave no SAH split; fall back to halving the range
+
+        tree.push_back(node);
+        stack.push_back({mid, task.end, static_cast<int>(nodeIdx), task.depth + 1});
+        stack.push_back({task.begin, mid, -1, task.depth + 1});
+    }
+
+    std::vector<uint32_t> itemNodes(items.size());
+    for (size_t i = 0; i < items.size(); ++i) {
+        itemNodes[i] = items[i].node;
+    }
+
+    BufferArena arena(model);
+    tinygltf::Value::Object nodesRef;
+    nodesRef["bufferView"] = tinygltf::Value(arena.append(tree.data(), tree.size() * sizeof(BvhNode), 0));
+    tinygltf::Value::Object itemsRef;
+    itemsRef["bufferView"] = tinygltf::Value(arena.append(itemNodes.data(), itemNodes.size() * sizeof(uint32_t), 0));
+    arena.commit();
+
+    tinygltf::Value::Object extension;
+    if (sceneIdx >= 0) {
+        extension["scene"] = tinygltf::Value(sceneIdx);
+    }
+    extension["nodeCount"] = tinygltf::Value(static_cast<int>(tree.size()));
+    extension["itemCount"] = tinygltf::Value(static_cast<int>(itemNodes.size()));
+    extension["nodes"] = tinygltf::Value(nodesRef);
+    extension["items"] = tinygltf::Value(itemsRef);
+    model.extensions[kSceneBvhExtension] = tinygltf::Value(extension);
+    if (std::find(model.extensionsUsed.begin(), model.extensionsUsed.end(), kSceneBvhExtension) ==
+        model.extensionsUsed.end()) {
+        model.extensionsUsed.push_back(kSceneBvhExtension);
+    }
+
+    std::ostringstream stream;
+    stream << "Scene BVH: " << items.size() << " nodes indexed, " << tree.size() << " tree nodes (" << leaves
+           << " leaves, depth " << maxDepth << ", "
+           << tree.size() * sizeof(BvhNode) + itemNodes.size() * sizeof(uint32_t) << " bytes)";
+    stats_ = stream.str();
+
+    if (options.verbose) {
+        std::cout << "[bvh] " << stats_ << std::endl;
+    }
+    return true;
+}
+
+} // namespace gltfu
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "tiny_gltf.h"
+#include <string>
+
+namespace gltfu {
+
+// Root extension holding the scene BVH bufferViews
+constexpr const char* kSceneBvhExtension = "GLTFU_scene_bvh";
+
+/**
+ * Options for the BVH operation.
+ */
+struct BvhOptions {
+    int maxLeafSize = 4;         // Nodes per leaf before the SAH is consulted
+    int bins = 16;               // SAH buckets evaluated per axis
+    bool verbose = false;        // Emit tree statistics
+};
+
+/**
+ * Bvh builds a surface-area-heuristic BVH over the world-space bounds of
+ * every mesh node in the default scene and stores it in the model, so
+ * runtimes can cull and pick without rebuilding it at load time.
+ *
+ * The model gets a GLTFU_scene_bvh root extension:
+ *
+ *   "GLTFU_scene_bvh": {
+ *     "scene": s, "nodeCount": N, "itemCount": M,
+ *     "nodes": { "bufferView": i },  // N x 32 bytes {float min[3]; uint32 a; float max[3]; uint32 count}
+ *     "items": { "bufferView": j }   // M x uint32 glTF node indices
+ *   }
+ *
+ * Tree nodes are stored depth first with the root at index 0. For an inner
+ * node count is 0, its first child directly follows it and a is the index of
+ * its second child. For a leaf, a is the first entry in items and count the
+ * number of entries. Bounds are rounded outwards to float.
+ *
+ * Items are glTF node indices, so the BVH must be built after any pass that
+ * removes, reorders or moves nodes.
+ */
+class GltfBvh {
+public:
+    GltfBvh() = default;
+
+    /**
+     * Build the scene BVH and attach it to the model.
+     * @param model The GLTF model to process
+     * @param options BVH options
+     * @return true if successful
+     */
+    bool process(tinygltf::Model& model, const BvhOptions& options = BvhOptions());
+    std::string getStats() const { return stats_; }
+    std::string getError() const { return error_; }
+
+private:
+    std::string stats_;
+    std::string error_;
+};
+
+} // namespace gltfu
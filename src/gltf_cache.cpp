@@ -0,0 +1,519 @@
+#include "gltf_cache.h"
+
+#include "gltf_bvh.h"
+#include "gltf_compress.h"
+#include "gltf_dedup.h"
+#include "gltf_join.h"
+#include "gltf_meshlets.h"
+#include "gltf_prune.h"
+#include "gltf_simplify.h"
+#include "gltf_split.h"
+#include "gltf_weld.h"
+
+#include "json.hpp"
+
+#define XXH_INLINE_ALL
+#include "xxhash.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <system_error>
+#include <utility>
+
+#ifndef GLTFU_VERSION
+#define GLTFU_VERSION "dev"
+#endif
+
+namespace gltfu {
+namespace {
+
+namespace fs = std::filesystem;
+
+// Bump whenever the on-disk entry layout or key derivation changes.
+constexpr const char* kCacheSchema = "gltfu-cache-1";
+
+constexpr size_t kReadChunkSize = 1 << 20;
+
+bool hashFile(XXH3_state_t* state, const fs::path& path, std::vector<char>& scratch, std::string& error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = "Failed to open " + path.string();
+        return false;
+    }
+
+    uint64_t total = 0;
+    while (file) {
+        file.read(scratch.data(), static_cast<std::streamsize>(scratch.size()));
+        const std::streamsize got = file.gcount();
+        if (got > 0) {
+            XXH3_128bits_update(state, scratch.data(), static_cast<size_t>(got));
+            total += static_cast<uint64_t>(got);
+        }
+    }
+    if (file.bad()) {
+        error = "Failed to read " + path.string();
+        return false;
+    }
+
+    // Length-prefix the next field so concatenated inputs cannot alias.
+    XXH3_128bits_update(state, &total, sizeof(total));
+    return true;
+}
+
+bool readJsonChunk(const fs::path& path, std::string& json) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    char magic[4] = {};
+    file.read(magic, 4);
+    if (file.gcount() == 4 && std::memcmp(magic, "glTF", 4) == 0) {
+        uint32_t header[2] = {};
+        uint32_t chunkHeader[2] = {};
+        file.read(reinterpret_cast<char*>(header), sizeof(header));
+        file.read(reinterpret_cast<char*>(chunkHeader), sizeof(chunkHeader));
+        if (!file || chunkHeader[1] != 0x4E4F534Au) {
+            return false;
+        }
+        json.resize(chunkHeader[0]);
+        file.read(json.data(), static_cast<std::streamsize>(json.size()));
+        return static_cast<size_t>(file.gcount()) == json.size();
+    }
+
+    file.clear();
+    file.seekg(0);
+    json.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+std::string decodeUri(const std::string& uri) {
+    std::string decoded;
+    decoded.reserve(uri.size());
+    for (size_t i = 0; i < uri.size(); ++i) {
+        if (uri[i] == '%' && i + 2 < uri.size()) {
+            const std::string hex = uri.substr(i + 1, 2);
+            char* end = nullptr;
+            const long value = std::strtol(hex.c_str(), &end, 16);
+            if (end == hex.c_str() + 2) {
+                decoded.push_back(static_cast<char>(value));
+                i += 2;
+                continue;
+            }
+        }
+        decoded.push_back(uri[i]);
+    }
+    return decoded;
+}
+
+// External resources are part of the input even though they live in other files.
+std::vector<std::string> collectExternalUris(const fs::path& path) {
+    std::vector<std::string> uris;
+    std::string text;
+    if (!readJsonChunk(path, text)) {
+        return uris;
+    }
+
+    const nlohmann::json document = nlohmann::json::parse(text, nullptr, false);
+    if (document.is_discarded()) {
+        return uris;
+    }
+
+    for (const char* key : {"buffers", "images"}) {
+        auto it = document.find(key);
+        if (it == document.end() || !it->is_array()) {
+            continue;
+        }
+        for (const auto& entry : *it) {
+            auto uriIt = entry.find("uri");
+            if (uriIt == entry.end() || !uriIt->is_string()) {
+                continue;
+            }
+            const std::string uri = uriIt->get<std::string>();
+            if (uri.rfind("data:", 0) != 0) {
+                uris.push_back(uri);
+            }
+        }
+    }
+    return uris;
+}
+
+// Rename into place so concurrent readers never see a partial entry.
+bool publishAtomically(const fs::path& temp, const fs::path& entry, std::error_code& ec) {
+    fs::rename(temp, entry, ec);
+    if (ec) {
+        std::error_code ignored;
+        fs::remove(temp, ignored);
+        return false;
+    }
+    return true;
+}
+
+fs::path temporaryPath(const fs::path& entry) {
+    fs::path temp = entry;
+    temp += ".tmp" + std::to_string(std::random_device{}());
+    return temp;
+}
+
+size_t componentCount(int type) {
+    switch (type) {
+        case TINYGLTF_TYPE_SCALAR: return 1;
+        case TINYGLTF_TYPE_VEC2: return 2;
+        case TINYGLTF_TYPE_VEC3: return 3;
+        case TINYGLTF_TYPE_VEC4: return 4;
+        case TINYGLTF_TYPE_MAT2: return 4;
+        case TINYGLTF_TYPE_MAT3: return 9;
+        case TINYGLTF_TYPE_MAT4: return 16;
+        default: return 0;
+    }
+}
+
+size_t componentSize(int componentType) {
+    switch (componentType) {
+        case TINYGLTF_COMPONENT_TYPE_BYTE:
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+            return 1;
+        case TINYGLTF_COMPONENT_TYPE_SHORT:
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+            return 2;
+        case TINYGLTF_COMPONENT_TYPE_INT:
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+        case TINYGLTF_COMPONENT_TYPE_FLOAT:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+// Hash the logical contents of an accessor, ignoring where it lives in the buffer.
+bool hashAccessor(XXH3_state_t* state, const tinygltf::Model& model, int accessorIdx) {
+    if (accessorIdx < 0 || accessorIdx >= static_cast<int>(model.accessors.size())) {
+        return false;
+    }
+    const auto& accessor = model.accessors[accessorIdx];
+    if (accessor.sparse.isSparse || accessor.bufferView < 0 ||
+        accessor.bufferView >= static_cast<int>(model.bufferViews.size())) {
+        return false;
+    }
+    const auto& view = model.bufferViews[accessor.bufferView];
+    if (view.buffer < 0 || view.buffer >= static_cast<int>(model.buffers.size())) {
+        return false;
+    }
+
+    const size_t elementSize = componentCount(accessor.type) * componentSize(accessor.componentType);
+    if (elementSize == 0) {
+        return false;
+    }
+    const size_t stride = view.byteStride > 0 ? static_cast<size_t>(view.byteStride) : elementSize;
+    const auto& data = model.buffers[view.buffer].data;
+    const size_t start = view.byteOffset + accessor.byteOffset;
+    if (accessor.count > 0 && start + stride * (accessor.count - 1) + elementSize > data.size()) {
+        return false;
+    }
+
+    const int64_t header[4] = {accessor.componentType, accessor.type,
+                               accessor.normalized ? 1 : 0, static_cast<int64_t>(accessor.count)};
+    XXH3_128bits_update(state, header, sizeof(header));
+
+    const unsigned char* base = data.data() + start;
+    if (stride == elementSize) {
+        XXH3_128bits_update(state, base, elementSize * accessor.count);
+    } else {
+        for (size_t i = 0; i < accessor.count; ++i) {
+            XXH3_128bits_update(state, base + i * stride, elementSize);
+        }
+    }
+    return true;
+}
+
+bool hashAttributes(XXH3_state_t* state, const tinygltf::Model& model, const std::map<std::string, int>& attributes) {
+    for (const auto& attribute : attributes) {
+        XXH3_128bits_update(state, attribute.first.data(), attribute.first.size() + 1);
+        if (!hashAccessor(state, model, attribute.second)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string toHex(const XXH128_hash_t& hash) {
+    char text[33];
+    std::snprintf(text, sizeof(text), "%016llx%016llx",
+                  static_cast<unsigned long long>(hash.high64),
+                  static_cast<unsigned long long>(hash.low64));
+    return text;
+}
+
+} // namespace
+
+CacheFingerprint& CacheFingerprint::add(const DedupOptions& options) {
+    return add("dedup.accessors", options.dedupAccessors)
+        .add("dedup.meshes", options.dedupMeshes)
+        .add("dedup.materials", options.dedupMaterials)
+        .add("dedup.textures", options.dedupTextures)
+        .add("dedup.keepUniqueNames", options.keepUniqueNames);
+}
+
+CacheFingerprint& CacheFingerprint::add(const JoinOptions& options) {
+    return add("join.keepMeshes", options.keepMeshes)
+        .add("join.keepNamed", options.keepNamed);
+}
+
+CacheFingerprint& CacheFingerprint::add(const WeldOptions& options) {
+    return add("weld.overwrite", options.overwrite);
+}
+
+CacheFingerprint& CacheFingerprint::add(const PruneOptions& options) {
+    return add("prune.keepLeaves", options.keepLeaves)
+        .add("prune.keepAttributes", options.keepAttributes)
+        .add("prune.keepExtras", options.keepExtras);
+}
+
+CacheFingerprint& CacheFingerprint::add(const SimplifyOptions& options) {
+    return add("simplify.ratio", options.ratio)
+        .add("simplify.error", options.error)
+        .add("simplify.errorMode", static_cast<int>(options.errorMode))
+        .add("simplify.viewDistance", options.viewDistance)
+        .add("simplify.fieldOfView", options.fieldOfView)
+        .add("simplify.viewportHeight", options.viewportHeight)
+        .add("simplify.lockBorder", options.lockBorder)
+        .add("simplify.triangleBudget", options.triangleBudget)
+        .add("simplify.budgetObjective", static_cast<int>(options.budgetObjective))
+        .add("simplify.normalWeight", options.normalWeight)
+        .add("simplify.texCoordWeight", options.texCoordWeight)
+        .add("simplify.colorWeight", options.colorWeight);
+}
+
+CacheFingerprint& CacheFingerprint::add(const CompressOptions& options) {
+    return add("compress.position", options.positionQuantizationBits)
+        .add("compress.normal", options.normalQuantizationBits)
+        .add("compress.texcoord", options.texCoordQuantizationBits)
+        .add("compress.color", options.colorQuantizationBits)
+        .add("compress.generic", options.genericQuantizationBits)
+        .add("compress.encodingSpeed", options.encodingSpeed)
+        .add("compress.decodingSpeed", options.decodingSpeed)
+        .add("compress.level", options.compressionLevel)
+        .add("compress.edgebreaker", options.useEdgebreaker)
+        .add("compress.auto", options.autoTune)
+        .add("compress.autoPositionError", options.autoMaxPositionError)
+        .add("compress.autoNormalError", options.autoMaxNormalError)
+        .add("compress.autoTargetRatio", options.autoTargetRatio);
+}
+
+CacheFingerprint& CacheFingerprint::add(const MeshletOptions& options) {
+    return add("meshlets.maxVertices", options.maxVertices)
+        .add("meshlets.maxTriangles", options.maxTriangles)
+        .add("meshlets.coneWeight", options.coneWeight);
+}
+
+CacheFingerprint& CacheFingerprint::add(const SplitOptions& options) {
+    return add("split.maxVertices", options.maxVertices)
+        .add("split.maxTriangles", options.maxTriangles);
+}
+
+CacheFingerprint& CacheFingerprint::add(const BvhOptions& options) {
+    return add("bvh.maxLeafSize", options.maxLeafSize)
+        .add("bvh.bins", options.bins);
+}
+
+GltfCache::GltfCache(std::string directory)
+    : directory_(std::move(directory)) {}
+
+bool GltfCache::computeKey(const std::vector<std::string>& inputs,
+                           const CacheFingerprint& fingerprint,
+                           std::string& key) {
+    XXH3_state_t* state = XXH3_createState();
+    if (!state) {
+        error_ = "Failed to allocate hash state";
+        return false;
+    }
+    XXH3_128bits_reset(state);
+
+    const std::string header = std::string(kCacheSchema) + ";" + GLTFU_VERSION + ";";
+    XXH3_128bits_update(state, header.data(), header.size());
+
+    std::vector<char> scratch(kReadChunkSize);
+    bool ok = true;
+    for (const auto& input : inputs) {
+        const fs::path inputPath(input);
+        if (!hashFile(state, inputPath, scratch, error_)) {
+            ok = false;
+            break;
+        }
+
+        for (const auto& uri : collectExternalUris(inputPath)) {
+            XXH3_128bits_update(state, uri.data(), uri.size());
+            if (!hashFile(state, inputPath.parent_path() / decodeUri(uri), scratch, error_)) {
+                ok = false;
+                break;
+            }
+        }
+        if (!ok) {
+            break;
+        }
+    }
+
+    if (ok) {
+        const std::string options = fingerprint.str();
+        XXH3_128bits_update(state, options.data(), options.size());
+        key = toHex(XXH3_128bits_digest(state));
+    }
+
+    XXH3_freeState(state);
+    return ok;
+}
+
+std::string GltfCache::entryPath(const std::string& key, const std::string& outputPath) const {
+    return (fs::path(directory_) / (key + fs::path(outputPath).extension().string())).string();
+}
+
+bool GltfCache::fetch(const std::string& key, const std::string& outputPath, bool link) {
+    const fs::path entry = entryPath(key, outputPath);
+    std::error_code ec;
+    if (!fs::is_regular_file(entry, ec)) {
+        return false;
+    }
+
+    releaseOutput(outputPath);
+
+    if (link) {
+        fs::create_hard_link(entry, outputPath, ec);
+        if (!ec) {
+            return true;
+        }
+    }
+
+    fs::copy_file(entry, outputPath, fs::copy_options::overwrite_existing, ec);
+    if (ec) {
+        error_ = "Failed to copy cache entry: " + ec.message();
+        return false;
+    }
+    return true;
+}
+
+void GltfCache::releaseOutput(const std::string& outputPath) {
+    // Never write through an existing hard link into the cache.
+    std::error_code ec;
+    fs::remove(outputPath, ec);
+}
+
+bool GltfCache::store(const std::string& key, const std::string& outputPath) {
+    std::error_code ec;
+    fs::create_directories(directory_, ec);
+    if (ec) {
+        error_ = "Failed to create cache directory: " + ec.message();
+        return false;
+    }
+
+    const fs::path entry = entryPath(key, outputPath);
+    const fs::path temp = temporaryPath(entry);
+    fs::copy_file(outputPath, temp, fs::copy_options::overwrite_existing, ec);
+    if (ec || !publishAtomically(temp, entry, ec)) {
+        error_ = "Failed to store cache entry: " + ec.message();
+        return false;
+    }
+    return true;
+}
+
+bool GltfCache::isSelfContained(const tinygltf::Model& model,
+                                bool embedImages,
+                                bool embedBuffers,
+                                bool writeBinary) {
+    if (!writeBinary && !embedBuffers && !model.buffers.empty()) {
+        return false;
+    }
+    if (embedImages) {
+        return true;
+    }
+    for (const auto& image : model.images) {
+        if (image.bufferView < 0 && image.uri.rfind("data:", 0) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+PrimitiveCache::PrimitiveCache(std::string directory)
+    : directory_(std::move(directory)) {}
+
+std::string PrimitiveCache::hashPrimitive(const tinygltf::Model& model,
+                                          const tinygltf::Primitive& primitive,
+                                          const CacheFingerprint& fingerprint) {
+    XXH3_state_t* state = XXH3_createState();
+    if (!state) {
+        return {};
+    }
+    XXH3_128bits_reset(state);
+
+    const std::string header = std::string(kCacheSchema) + ";" + GLTFU_VERSION + ";" + fingerprint.str();
+    XXH3_128bits_update(state, header.data(), header.size());
+    const int32_t mode = primitive.mode;
+    XXH3_128bits_update(state, &mode, sizeof(mode));
+
+    bool ok = primitive.indices < 0 || hashAccessor(state, model, primitive.indices);
+    ok = ok && hashAttributes(state, model, primitive.attributes);
+    for (size_t i = 0; ok && i < primitive.targets.size(); ++i) {
+        const uint64_t target = i;
+        XXH3_128bits_update(state, &target, sizeof(target));
+        ok = hashAttributes(state, model, primitive.targets[i]);
+    }
+
+    std::string key;
+    if (ok) {
+        key = toHex(XXH3_128bits_digest(state));
+    }
+    XXH3_freeState(state);
+    return key;
+}
+
+std::string PrimitiveCache::entryPath(const std::string& stage, const std::string& key) const {
+    // Fan out by key prefix so large caches do not end up in one directory.
+    return (fs::path(directory_) / stage / key.substr(0, 2) / key).string();
+}
+
+bool PrimitiveCache::load(const std::string& stage, const std::string& key, std::vector<uint8_t>& payload) {
+    std::ifstream file(entryPath(stage, key), std::ios::binary);
+    if (!file) {
+        ++misses_;
+        return false;
+    }
+
+    payload.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (file.bad()) {
+        payload.clear();
+        ++misses_;
+        return false;
+    }
+    ++hits_;
+    return true;
+}
+
+bool PrimitiveCache::store(const std::string& stage, const std::string& key, const std::vector<uint8_t>& payload) {
+    const fs::path entry = entryPath(stage, key);
+    std::error_code ec;
+    fs::create_directories(entry.parent_path(), ec);
+    if (ec) {
+        return false;
+    }
+
+    const fs::path temp = temporaryPath(entry);
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+        if (!file) {
+            file.close();
+            fs::remove(temp, ec);
+            return false;
+        }
+    }
+    return publishAtomically(temp, entry, ec);
+}
+
+} // namespace gltfu
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "tiny_gltf.h"
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace gltfu {
+
+struct DedupOptions;
+struct JoinOptions;
+struct WeldOptions;
+struct PruneOptions;
+struct SimplifyOptions;
+struct CompressOptions;
+struct MeshletOptions;
+struct SplitOptions;
+struct BvhOptions;
+
+/**
+ * Accumulates every option that influences a pipeline's output into a
+ * stable string, which becomes part of a cache key.
+ *
+ * Fields that only affect logging (verbose flags, progress reporters) are
+ * deliberately left out so that they do not cause cache misses.
+ */
+class CacheFingerprint {
+public:
+    template <typename T>
+    CacheFingerprint& add(const char* name, const T& value) {
+        stream_ << name << '=' << value << ';';
+        return *this;
+    }
+
+    CacheFingerprint& add(const DedupOptions& options);
+    CacheFingerprint& add(const JoinOptions& options);
+    CacheFingerprint& add(const WeldOptions& options);
+    CacheFingerprint& add(const PruneOptions& options);
+    CacheFingerprint& add(const SimplifyOptions& options);
+    CacheFingerprint& add(const CompressOptions& options);
+    CacheFingerprint& add(const MeshletOptions& options);
+    CacheFingerprint& add(const SplitOptions& options);
+    CacheFingerprint& add(const BvhOptions& options);
+
+    std::string str() const { return stream_.str(); }
+
+private:
+    std::ostringstream stream_ = makeStream();
+
+    static std::ostringstream makeStream() {
+        std::ostringstream stream;
+        stream.precision(17);
+        return stream;
+    }
+};
+
+/**
+ * Content-addressed cache of optimized outputs.
+ *
+ * Entries are keyed by an XXH3 digest of the input bytes (including external
+ * buffers and images referenced by the inputs) combined with an option
+ * fingerprint. A hit copies, or hard-links, the cached file into place so the
+ * pipeline can be skipped entirely.
+ */
+class GltfCache {
+public:
+    explicit GltfCache(std::string directory);
+
+    /**
+     * Compute the cache key for a set of input files.
+     * @param inputs Input files, in pipeline order
+     * @param fingerprint Fingerprint of all output-affecting options
+     * @param key Receives the hexadecimal key
+     * @return true if every input could be read
+     */
+    bool computeKey(const std::vector<std::string>& inputs,
+                    const CacheFingerprint& fingerprint,
+                    std::string& key);
+
+    /**
+     * Materialize a cached entry at outputPath.
+     * @param link Hard-link the entry instead of copying it (falls back to copy)
+     * @return true on a cache hit
+     */
+    bool fetch(const std::string& key, const std::string& outputPath, bool link = false);
+
+    /**
+     * Unlink outputPath before it is rewritten. An earlier linked hit may have
+     * left it as a hard link to an entry, and writing through it would
+     * replace that entry's contents.
+     */
+    static void releaseOutput(const std::string& outputPath);
+
+    /**
+     * Store a freshly written output under key.
+     * @return true if the entry was written
+     */
+    bool store(const std::string& key, const std::string& outputPath);
+
+    /**
+     * Check whether a model written with the given flags ends up in a single
+     * file. Outputs with external buffers or images are never cached.
+     */
+    static bool isSelfContained(const tinygltf::Model& model,
+                                bool embedImages,
+                                bool embedBuffers,
+                                bool writeBinary);
+
+    std::string getError() const { return error_; }
+
+private:
+    std::string entryPath(const std::string& key, const std::string& outputPath) const;
+
+    std::string directory_;
+    std::string error_;
+};
+
+/**
+ * Persistent store of per-primitive stage results.
+ *
+ * Keys digest a primitive's mode, index and attribute bytes (including morph
+ * targets) together with a stage fingerprint, so unchanged geometry is never
+ * reprocessed across runs. Payloads are opaque to the cache; each stage owns
+ * its own encoding.
+ */
+class PrimitiveCache {
+public:
+    explicit PrimitiveCache(std::string directory);
+
+    /**
+     * Digest a primitive's geometry combined with a stage fingerprint.
+     * @return Hexadecimal key, or an empty string if the primitive cannot be
+     *         hashed (sparse or buffer-less accessors)
+     */
+    static std::string hashPrimitive(const tinygltf::Model& model,
+                                     const tinygltf::Primitive& primitive,
+                                     const CacheFingerprint& fingerprint);
+
+    bool load(const std::string& stage, const std::string& key, std::vector<uint8_t>& payload);
+    bool store(const std::string& stage, const std::string& key, const std::vector<uint8_t>& payload);
+
+    size_t getHits() const { return hits_; }
+    size_t getMisses() const { return misses_; }
+
+private:
+    std::string entryPath(const std::string& stage, const std::string& key) const;
+
+    std::string directory_;
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+};
+
+} // namespace gltfu
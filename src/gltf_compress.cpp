@@ -1,17 +1,31 @@
 #include "gltf_compress.h"
 
+#include "gltf_cache.h"
+#include "gltf_flatten.h"
+#include "gltf_meshlets.h"
+#include "math_utils.h"
+#include "trace.h"
+
 #include <algorithm>
 #include <cfloat>
+#include <chrono>
+#include <cmath>
 #include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <limits>
 #include <map>
+#include <memory>
 #include <sstream>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #ifdef GLTFU_ENABLE_DRACO
+#include "draco/compression/decode.h"
 #include "draco/compression/encode.h"
+#include "draco/core/decoder_buffer.h"
 #include "draco/core/encoder_buffer.h"
 #include "draco/mesh/mesh.h"
 #endif
@@ -20,6 +34,7 @@ namespace gltfu {
 namespace {
 
 constexpr const char* kDracoExtension = "KHR_draco_mesh_compression";
+constexpr const char* kCacheStage = "draco";
 
 bool containsExtension(const std::vector<std::string>& list, const std::string& value) {
     return std::find(list.begin(), list.end(), value) != list.end();
@@ -86,8 +101,31 @@ struct PrimitiveRecord {
     size_t offset;
     size_t length;
     size_t original;
+    int source;      // Record whose encoding this primitive shares, or -1
 };
 
+// Primitives with the same index and attribute accessors encode to the same blob
+struct EncodingKey {
+    int indices = -1;
+    bool morphTargets = false;
+    double worldScale = 0.0;  // Auto mode tunes per world scale
+    std::vector<std::pair<std::string, int>> attributes;
+
+    bool operator<(const EncodingKey& other) const {
+        return std::tie(indices, morphTargets, worldScale, attributes) <
+               std::tie(other.indices, other.morphTargets, other.worldScale, other.attributes);
+    }
+};
+
+EncodingKey makeEncodingKey(const tinygltf::Primitive& primitive, double worldScale) {
+    EncodingKey key;
+    key.indices = primitive.indices;
+    key.worldScale = worldScale;
+    key.morphTargets = !primitive.targets.empty();
+    key.attributes.assign(primitive.attributes.begin(), primitive.attributes.end());
+    return key;
+}
+
 void ensurePositionBounds(tinygltf::Model& model, tinygltf::Primitive& primitive) {
     auto positionIt = primitive.attributes.find("POSITION");
     if (positionIt == primitive.attributes.end()) {
@@ -174,64 +212,67 @@ bool fetchAccessorInfo(const tinygltf::Model& model,
     return true;
 }
 
-bool compressPrimitive(tinygltf::Model& model,
-                       tinygltf::Mesh& mesh,
-                       size_t primitiveIndex,
-                       const CompressOptions& options,
-                       std::vector<uint8_t>& compressedData) {
-    auto& primitive = mesh.primitives[primitiveIndex];
+// Decode triangle indices with the component type resolved once, outside the loop
+template <typename T>
+void setFaces(draco::Mesh& mesh, const uint8_t* data, size_t stride, size_t faceCount) {
+    for (size_t face = 0; face < faceCount; ++face) {
+        draco::Mesh::Face dracoFace;
+        for (int corner = 0; corner < 3; ++corner) {
+            T idx;
+            std::memcpy(&idx, data + (face * 3 + corner) * stride, sizeof(T));
+            dracoFace[corner] = static_cast<uint32_t>(idx);
+        }
+        mesh.SetFace(draco::FaceIndex(static_cast<uint32_t>(face)), dracoFace);
+    }
+}
 
+// Build the Draco mesh for a primitive. Attribute data is copied in bulk when
+// tightly packed and de-strided in one pass otherwise; perVertex keeps the
+// reference SetAttributeValue path for benchmarking.
+std::unique_ptr<draco::Mesh> buildDracoMesh(const tinygltf::Model& model,
+                                            const tinygltf::Primitive& primitive,
+                                            bool perVertex,
+                                            std::map<std::string, int>& attributeIds) {
     if (primitive.mode != TINYGLTF_MODE_TRIANGLES) {
-        return false;
+        return nullptr;
     }
-    if (primitive.indices < 0 || primitive.attributes.count("POSITION") == 0) {
-        return false;
+    const auto positionIt = primitive.attributes.find("POSITION");
+    if (primitive.indices < 0 || positionIt == primitive.attributes.end() ||
+        positionIt->second < 0 || positionIt->second >= static_cast<int>(model.accessors.size())) {
+        return nullptr;
     }
 
-    const auto& positionAccessor = model.accessors[primitive.attributes["POSITION"]];
+    const auto& positionAccessor = model.accessors[positionIt->second];
     const size_t vertexCount = positionAccessor.count;
     if (vertexCount == 0) {
-        return false;
+        return nullptr;
     }
 
     AccessorInfo indexInfo;
     if (!fetchAccessorInfo(model, primitive.indices, indexInfo)) {
-        return false;
+        return nullptr;
     }
 
     auto dracoMesh = std::make_unique<draco::Mesh>();
     const auto& indexAccessor = model.accessors[primitive.indices];
     const size_t faceCount = indexAccessor.count / 3;
     dracoMesh->SetNumFaces(faceCount);
-    dracoMesh->set_num_points(vertexCount);
+    dracoMesh->set_num_points(static_cast<uint32_t>(vertexCount));
 
-    for (size_t face = 0; face < faceCount; ++face) {
-        draco::Mesh::Face dracoFace;
-        for (int corner = 0; corner < 3; ++corner) {
-            const uint8_t* ptr = indexInfo.data + (face * 3 + corner) * indexInfo.stride;
-            uint32_t idx = 0;
-            switch (indexAccessor.componentType) {
-                case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
-                    idx = *ptr;
-                    break;
-                case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
-                    idx = *reinterpret_cast<const uint16_t*>(ptr);
-                    break;
-                case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
-                    idx = *reinterpret_cast<const uint32_t*>(ptr);
-                    break;
-                default:
-                    return false;
-            }
-            dracoFace[corner] = idx;
-        }
-        dracoMesh->SetFace(draco::FaceIndex(face), dracoFace);
+    switch (indexAccessor.componentType) {
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+            setFaces<uint8_t>(*dracoMesh, indexInfo.data, indexInfo.stride, faceCount);
+            break;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+            setFaces<uint16_t>(*dracoMesh, indexInfo.data, indexInfo.stride, faceCount);
+            break;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+            setFaces<uint32_t>(*dracoMesh, indexInfo.data, indexInfo.stride, faceCount);
+            break;
+        default:
+            return nullptr;
     }
 
-    std::map<std::string, int> attributeIds;
-    const bool hasMorphTargets = !primitive.targets.empty();
-    const bool useSequential = !options.useEdgebreaker || hasMorphTargets;
-
     for (const auto& attributePair : primitive.attributes) {
         const std::string& name = attributePair.first;
         const int accessorIdx = attributePair.second;
@@ -269,20 +310,169 @@ bool compressPrimitive(tinygltf::Model& model,
         }
 
         const int components = componentCount(accessor.type);
+        const size_t elementSize = draco::DataTypeLength(dataType) * components;
         draco::GeometryAttribute attribute;
         attribute.Init(attrType, nullptr, components, dataType, accessor.normalized,
-                       draco::DataTypeLength(dataType) * components, 0);
+                       static_cast<int64_t>(elementSize), 0);
 
-        const int attributeId = dracoMesh->AddAttribute(attribute, true, vertexCount);
+        const int attributeId = dracoMesh->AddAttribute(attribute, true, static_cast<uint32_t>(vertexCount));
         attributeIds[name] = attributeId;
+        draco::PointAttribute* target = dracoMesh->attribute(attributeId);
+
+        if (perVertex) {
+            for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
+                target->SetAttributeValue(draco::AttributeValueIndex(static_cast<uint32_t>(vertex)),
+                                          info.data + vertex * info.stride);
+            }
+        } else if (info.stride == elementSize) {
+            target->buffer()->Write(0, info.data, vertexCount * elementSize);
+        } else {
+            std::vector<uint8_t> packed(vertexCount * elementSize);
+            for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
+                std::memcpy(packed.data() + vertex * elementSize, info.data + vertex * info.stride, elementSize);
+            }
+            target->buffer()->Write(0, packed.data(), packed.size());
+        }
+    }
+
+    return dracoMesh;
+}
+
+constexpr int kAutoMinPositionBits = 8;
+constexpr int kAutoMaxPositionBits = 20;
+constexpr int kAutoMinNormalBits = 4;
+constexpr int kAutoMaxNormalBits = 16;
+
+// Per-primitive auto-tuning inputs and the settings it settled on
+struct AutoChoice {
+    double worldScale = 1.0;
+    size_t targetBytes = 0;
+    int positionBits = 0;
+    int normalBits = 0;
+    int speed = 0;
+    bool metTarget = false;
+};
+
+// Largest axis scale of a world matrix, turning local errors into world units
+double maxAxisScale(const Matrix4& matrix) {
+    double scale = 0.0;
+    for (size_t col = 0; col < 3; ++col) {
+        const double x = matrix[col * 4];
+        const double y = matrix[col * 4 + 1];
+        const double z = matrix[col * 4 + 2];
+        scale = std::max(scale, std::sqrt(x * x + y * y + z * z));
+    }
+    return scale;
+}
+
+// Read a float attribute of the given type; empty when missing or not float
+std::vector<float> readFloatAttribute(const tinygltf::Model& model, const tinygltf::Primitive& primitive,
+                                      const char* name, int type) {
+    std::vector<float> values;
+    const auto it = primitive.attributes.find(name);
+    AccessorInfo info;
+    if (it == primitive.attributes.end() || !fetchAccessorInfo(model, it->second, info)) {
+        return values;
+    }
+    const auto& accessor = model.accessors[it->second];
+    if (accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT || accessor.type != type) {
+        return values;
+    }
+    const size_t components = static_cast<size_t>(componentCount(type));
+    values.resize(accessor.count * components);
+    for (size_t vertex = 0; vertex < accessor.count; ++vertex) {
+        std::memcpy(values.data() + vertex * components, info.data + vertex * info.stride,
+                    components * sizeof(float));
+    }
+    return values;
+}
+
+// Largest position error of Draco's quantizer at the given bits: one range
+// shared by all axes, values rounded to the nearest of 2^bits - 1 steps
+double positionQuantizationError(const std::vector<float>& positions, int bits) {
+    float minValue[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+    float maxValue[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    for (size_t i = 0; i < positions.size(); i += 3) {
+        for (size_t axis = 0; axis < 3; ++axis) {
+            minValue[axis] = std::min(minValue[axis], positions[i + axis]);
+            maxValue[axis] = std::max(maxValue[axis], positions[i + axis]);
+        }
+    }
+    double range = 0.0;
+    for (size_t axis = 0; axis < 3; ++axis) {
+        range = std::max(range, static_cast<double>(maxValue[axis]) - minValue[axis]);
+    }
+    if (range <= 0.0) {
+        return 0.0;
+    }
+
+    const double steps = static_cast<double>((1u << bits) - 1);
+    const double delta = range / steps;
+    double maxError = 0.0;
+    for (size_t i = 0; i < positions.size(); i += 3) {
+        double squared = 0.0;
+        for (size_t axis = 0; axis < 3; ++axis) {
+            const double value = positions[i + axis] - minValue[axis];
+            const double restored = std::floor(value / delta + 0.5) * delta;
+            squared += (restored - value) * (restored - value);
+        }
+        maxError = std::max(maxError, squared);
+    }
+    return std::sqrt(maxError);
+}
+
+// Largest angle, in degrees, between a normal and its octahedral quantization at the given bits
+double normalQuantizationError(const std::vector<float>& normals, int bits) {
+    const double center = static_cast<double>((1u << bits) - 2) / 2.0;
+    const auto sign = [](double value) { return value < 0.0 ? -1.0 : 1.0; };
+    double minCosine = 1.0;
+    for (size_t i = 0; i < normals.size(); i += 3) {
+        const double nx = normals[i];
+        const double ny = normals[i + 1];
+        const double nz = normals[i + 2];
+        const double length = std::sqrt(nx * nx + ny * ny + nz * nz);
+        const double l1 = std::fabs(nx) + std::fabs(ny) + std::fabs(nz);
+        if (length <= 0.0 || l1 <= 0.0) {
+            continue;
+        }
+
+        double s = nx / l1;
+        double t = ny / l1;
+        if (nz < 0.0) {
+            const double folded = (1.0 - std::fabs(t)) * sign(s);
+            t = (1.0 - std::fabs(s)) * sign(t);
+            s = folded;
+        }
+        s = std::floor(s * center + 0.5) / center;
+        t = std::floor(t * center + 0.5) / center;
+
+        double rz = 1.0 - std::fabs(s) - std::fabs(t);
+        double rx = s;
+        double ry = t;
+        if (rz < 0.0) {
+            rx = (1.0 - std::fabs(t)) * sign(s);
+            ry = (1.0 - std::fabs(s)) * sign(t);
+        }
+        const double restored = std::sqrt(rx * rx + ry * ry + rz * rz);
+        const double cosine = (nx * rx + ny * ry + nz * rz) / (length * restored);
+        minCosine = std::min(minCosine, cosine);
+    }
+    return std::acos(std::max(-1.0, std::min(1.0, minCosine))) * 180.0 / 3.14159265358979323846;
+}
 
-        for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
-            dracoMesh->attribute(attributeId)->SetAttributeValue(
-                draco::AttributeValueIndex(vertex),
-                info.data + vertex * info.stride);
+// Fewest bits whose error stays within maxError, or maxBits when none does
+template <typename ErrorFn>
+int searchBits(int minBits, int maxBits, double maxError, ErrorFn error) {
+    for (int bits = minBits; bits < maxBits; ++bits) {
+        if (error(bits) <= maxError) {
+            return bits;
         }
     }
+    return maxBits;
+}
 
+bool encodeDracoMesh(const draco::Mesh& dracoMesh, const CompressOptions& options, bool useSequential,
+                     std::vector<uint8_t>& compressedData) {
     draco::Encoder encoder;
     encoder.SetAttributeQuantization(draco::GeometryAttribute::POSITION, options.positionQuantizationBits);
     encoder.SetAttributeQuantization(draco::GeometryAttribute::NORMAL, options.normalQuantizationBits);
@@ -294,13 +484,262 @@ bool compressPrimitive(tinygltf::Model& model,
                                             : draco::MESH_EDGEBREAKER_ENCODING);
 
     draco::EncoderBuffer buffer;
-    const draco::Status status = encoder.EncodeMeshToBuffer(*dracoMesh, &buffer);
+    const draco::Status status = encoder.EncodeMeshToBuffer(dracoMesh, &buffer);
     if (!status.ok()) {
         return false;
     }
 
     compressedData.resize(buffer.size());
     std::memcpy(compressedData.data(), buffer.data(), buffer.size());
+    return true;
+}
+
+// Read every point of a decoded attribute as floats; empty when the attribute is missing
+std::vector<float> readDecodedAttribute(const draco::Mesh& dracoMesh, const tinygltf::Value& attributes,
+                                        const char* name, int components) {
+    std::vector<float> values;
+    if (!attributes.Has(name)) {
+        return values;
+    }
+    const draco::PointAttribute* attribute =
+        dracoMesh.GetAttributeByUniqueId(static_cast<uint32_t>(attributes.Get(name).GetNumberAsInt()));
+    if (!attribute || attribute->num_components() != components) {
+        return values;
+    }
+    values.resize(static_cast<size_t>(dracoMesh.num_points()) * components);
+    for (uint32_t point = 0; point < dracoMesh.num_points(); ++point) {
+        attribute->ConvertValue<float>(attribute->mapped_index(draco::PointIndex(point)),
+                                       static_cast<int8_t>(components), values.data() + point * components);
+    }
+    return values;
+}
+
+double normalAngle(const float* a, const float* b) {
+    const double lengthA = std::sqrt(double(a[0]) * a[0] + double(a[1]) * a[1] + double(a[2]) * a[2]);
+    const double lengthB = std::sqrt(double(b[0]) * b[0] + double(b[1]) * b[1] + double(b[2]) * b[2]);
+    if (lengthA <= 0.0 || lengthB <= 0.0) {
+        return 0.0;
+    }
+    const double cosine = (double(a[0]) * b[0] + double(a[1]) * b[1] + double(a[2]) * b[2]) / (lengthA * lengthB);
+    return std::acos(std::max(-1.0, std::min(1.0, cosine))) * 180.0 / 3.14159265358979323846;
+}
+
+// Running totals behind CompressVerification
+struct VerificationTotals {
+    double positionSquared = 0.0;
+    size_t positionSamples = 0;
+    double normalSquared = 0.0;
+    size_t normalSamples = 0;
+    double texCoordSquared = 0.0;
+    size_t texCoordSamples = 0;
+};
+
+// Decode a Draco blob and measure its error against the source accessors.
+// Draco reorders points, so each decoded point is matched to the nearest source
+// vertex on a grid one quantization step wide; seams with coincident positions
+// are told apart by the closest normal and UV.
+bool verifyPrimitive(const tinygltf::Model& model, const tinygltf::Primitive& primitive,
+                     const std::vector<uint8_t>& compressed, int positionBits,
+                     CompressVerification& verification, VerificationTotals& totals) {
+    const auto extensionIt = primitive.extensions.find(kDracoExtension);
+    if (extensionIt == primitive.extensions.end() || !extensionIt->second.Has("attributes")) {
+        return false;
+    }
+    const tinygltf::Value& attributeIds = extensionIt->second.Get("attributes");
+
+    const auto start = std::chrono::steady_clock::now();
+    draco::DecoderBuffer buffer;
+    buffer.Init(reinterpret_cast<const char*>(compressed.data()), compressed.size());
+    draco::Decoder decoder;
+    auto decoded = decoder.DecodeMeshFromBuffer(&buffer);
+    if (!decoded.ok()) {
+        return false;
+    }
+    const std::unique_ptr<draco::Mesh> dracoMesh = std::move(decoded).value();
+    verification.decodeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    verification.bytes += compressed.size();
+    verification.vertices += dracoMesh->num_points();
+    ++verification.primitives;
+
+    const std::vector<float> positions = readFloatAttribute(model, primitive, "POSITION", TINYGLTF_TYPE_VEC3);
+    const std::vector<float> decodedPositions = readDecodedAttribute(*dracoMesh, attributeIds, "POSITION", 3);
+    if (positions.empty() || decodedPositions.empty()) {
+        return true;
+    }
+    const std::vector<float> normals = readFloatAttribute(model, primitive, "NORMAL", TINYGLTF_TYPE_VEC3);
+    std::vector<float> decodedNormals = readDecodedAttribute(*dracoMesh, attributeIds, "NORMAL", 3);
+    const std::vector<float> texCoords = readFloatAttribute(model, primitive, "TEXCOORD_0", TINYGLTF_TYPE_VEC2);
+    std::vector<float> decodedTexCoords = readDecodedAttribute(*dracoMesh, attributeIds, "TEXCOORD_0", 2);
+    const size_t sourceCount = positions.size() / 3;
+    if (normals.size() != sourceCount * 3) {
+        decodedNormals.clear();
+    }
+    if (texCoords.size() != sourceCount * 2) {
+        decodedTexCoords.clear();
+    }
+
+    float minValue[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+    float maxValue[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    for (size_t i = 0; i < positions.size(); i += 3) {
+        for (size_t axis = 0; axis < 3; ++axis) {
+            minValue[axis] = std::min(minValue[axis], positions[i + axis]);
+            maxValue[axis] = std::max(maxValue[axis], positions[i + axis]);
+        }
+    }
+    double range = 0.0;
+    for (size_t axis = 0; axis < 3; ++axis) {
+        range = std::max(range, static_cast<double>(maxValue[axis]) - minValue[axis]);
+    }
+    const double cellSize = std::max(range / static_cast<double>((1u << positionBits) - 1), 1e-12);
+
+    const auto cellOf = [&](const float* position, size_t axis) {
+        return static_cast<int64_t>(std::floor((position[axis] - minValue[axis]) / cellSize));
+    };
+    const auto cellKey = [](int64_t x, int64_t y, int64_t z) {
+        return static_cast<uint64_t>(x) * 73856093ull ^ static_cast<uint64_t>(y) * 19349663ull ^
+               static_cast<uint64_t>(z) * 83492791ull;
+    };
+    std::unordered_map<uint64_t, std::vector<uint32_t>> grid;
+    for (size_t vertex = 0; vertex < sourceCount; ++vertex) {
+        const float* position = positions.data() + vertex * 3;
+        grid[cellKey(cellOf(position, 0), cellOf(position, 1), cellOf(position, 2))].push_back(
+            static_cast<uint32_t>(vertex));
+    }
+
+    const double tieTolerance = cellSize * cellSize * 1e-9;
+    std::vector<uint32_t> candidates;
+    for (uint32_t point = 0; point < dracoMesh->num_points(); ++point) {
+        const float* position = decodedPositions.data() + size_t(point) * 3;
+        candidates.clear();
+        const int64_t cx = cellOf(position, 0);
+        const int64_t cy = cellOf(position, 1);
+        const int64_t cz = cellOf(position, 2);
+        for (int64_t dx = -1; dx <= 1; ++dx) {
+            for (int64_t dy = -1; dy <= 1; ++dy) {
+                for (int64_t dz = -1; dz <= 1; ++dz) {
+                    const auto cellIt = grid.find(cellKey(cx + dx, cy + dy, cz + dz));
+                    if (cellIt != grid.end()) {
+                        candidates.insert(candidates.end(), cellIt->second.begin(), cellIt->second.end());
+                    }
+                }
+            }
+        }
+        if (candidates.empty()) {
+            for (size_t vertex = 0; vertex < sourceCount; ++vertex) {
+                candidates.push_back(static_cast<uint32_t>(vertex));
+            }
+        }
+
+        double bestDistance = std::numeric_limits<double>::max();
+        double bestAttributes = std::numeric_limits<double>::max();
+        uint32_t best = candidates.front();
+        for (const uint32_t vertex : candidates) {
+            double distance = 0.0;
+            for (size_t axis = 0; axis < 3; ++axis) {
+                const double delta = double(position[axis]) - positions[size_t(vertex) * 3 + axis];
+                distance += delta * delta;
+            }
+            if (distance > bestDistance + tieTolerance) {
+                continue;
+            }
+            double attributes = 0.0;
+            if (!decodedNormals.empty()) {
+                attributes += normalAngle(decodedNormals.data() + size_t(point) * 3, normals.data() + size_t(vertex) * 3);
+            }
+            for (size_t c = 0; c < 2 && !decodedTexCoords.empty(); ++c) {
+                attributes += std::fabs(double(decodedTexCoords[size_t(point) * 2 + c]) - texCoords[size_t(vertex) * 2 + c]);
+            }
+            if (distance < bestDistance - tieTolerance || attributes < bestAttributes) {
+                bestDistance = std::min(bestDistance, distance);
+                bestAttributes = attributes;
+                best = vertex;
+            }
+        }
+
+        verification.maxPositionError = std::max(verification.maxPositionError, std::sqrt(bestDistance));
+        totals.positionSquared += bestDistance;
+        ++totals.positionSamples;
+        if (!decodedNormals.empty()) {
+            const double angle = normalAngle(decodedNormals.data() + size_t(point) * 3, normals.data() + size_t(best) * 3);
+            verification.maxNormalError = std::max(verification.maxNormalError, angle);
+            totals.normalSquared += angle * angle;
+            ++totals.normalSamples;
+        }
+        if (!decodedTexCoords.empty()) {
+            const double du = double(decodedTexCoords[size_t(point) * 2]) - texCoords[size_t(best) * 2];
+            const double dv = double(decodedTexCoords[size_t(point) * 2 + 1]) - texCoords[size_t(best) * 2 + 1];
+            const double squared = du * du + dv * dv;
+            verification.maxTexCoordError = std::max(verification.maxTexCoordError, std::sqrt(squared));
+            totals.texCoordSquared += squared;
+            ++totals.texCoordSamples;
+        }
+    }
+    return true;
+}
+
+bool compressPrimitive(tinygltf::Model& model,
+                       tinygltf::Mesh& mesh,
+                       size_t primitiveIndex,
+                       const CompressOptions& options,
+                       std::vector<uint8_t>& compressedData,
+                       AutoChoice* autoChoice) {
+    auto& primitive = mesh.primitives[primitiveIndex];
+
+    std::map<std::string, int> attributeIds;
+    const std::unique_ptr<draco::Mesh> dracoMesh = buildDracoMesh(model, primitive, false, attributeIds);
+    if (!dracoMesh) {
+        return false;
+    }
+
+    const bool hasMorphTargets = !primitive.targets.empty();
+    const bool useSequential = !options.useEdgebreaker || hasMorphTargets;
+
+    if (!autoChoice) {
+        if (!encodeDracoMesh(*dracoMesh, options, useSequential, compressedData)) {
+            return false;
+        }
+    } else {
+        // Fewest bits within the error limits, then the fastest-decoding speed within the size target
+        CompressOptions tuned = options;
+        const std::vector<float> positions = readFloatAttribute(model, primitive, "POSITION", TINYGLTF_TYPE_VEC3);
+        if (!positions.empty()) {
+            const double maxError = options.autoMaxPositionError / std::max(autoChoice->worldScale, 1e-12);
+            tuned.positionQuantizationBits =
+                searchBits(kAutoMinPositionBits, kAutoMaxPositionBits, maxError,
+                           [&positions](int bits) { return positionQuantizationError(positions, bits); });
+        }
+        const std::vector<float> normals = readFloatAttribute(model, primitive, "NORMAL", TINYGLTF_TYPE_VEC3);
+        if (!normals.empty()) {
+            tuned.normalQuantizationBits =
+                searchBits(kAutoMinNormalBits, kAutoMaxNormalBits, options.autoMaxNormalError,
+                           [&normals](int bits) { return normalQuantizationError(normals, bits); });
+        }
+        autoChoice->positionBits = tuned.positionQuantizationBits;
+        autoChoice->normalBits = tuned.normalQuantizationBits;
+
+        std::vector<uint8_t> candidate;
+        compressedData.clear();
+        for (int speed = 10; speed >= 0; --speed) {
+            tuned.encodingSpeed = speed;
+            tuned.decodingSpeed = speed;
+            if (!encodeDracoMesh(*dracoMesh, tuned, useSequential, candidate)) {
+                continue;
+            }
+            if (candidate.size() <= autoChoice->targetBytes) {
+                compressedData.swap(candidate);
+                autoChoice->speed = speed;
+                autoChoice->metTarget = true;
+                break;
+            }
+            if (compressedData.empty() || candidate.size() < compressedData.size()) {
+                compressedData.swap(candidate);
+                autoChoice->speed = speed;
+            }
+        }
+        if (compressedData.empty()) {
+            return false;
+        }
+    }
 
     tinygltf::Value::Object dracoObject;
     tinygltf::Value::Object attributeMap;
@@ -312,10 +751,97 @@ bool compressPrimitive(tinygltf::Model& model,
 
     return true;
 }
+
+// Cache payload: [uint32 attribute count]{[uint32 name length][name][int32 id]}*[Draco blob]
+std::vector<uint8_t> encodeCachedPrimitive(const tinygltf::Primitive& primitive,
+                                           const std::vector<uint8_t>& compressedData) {
+    std::vector<uint8_t> payload;
+    auto append = [&payload](const void* data, size_t size) {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        payload.insert(payload.end(), bytes, bytes + size);
+    };
+
+    const auto& attributes = primitive.extensions.at(kDracoExtension).Get("attributes");
+    const auto keys = attributes.Keys();
+    const uint32_t count = static_cast<uint32_t>(keys.size());
+    append(&count, sizeof(count));
+    for (const auto& name : keys) {
+        const uint32_t length = static_cast<uint32_t>(name.size());
+        const int32_t id = attributes.Get(name).GetNumberAsInt();
+        append(&length, sizeof(length));
+        append(name.data(), name.size());
+        append(&id, sizeof(id));
+    }
+    append(compressedData.data(), compressedData.size());
+    return payload;
+}
+
+bool decodeCachedPrimitive(const std::vector<uint8_t>& payload,
+                           tinygltf::Primitive& primitive,
+                           std::vector<uint8_t>& compressedData) {
+    size_t cursor = 0;
+    auto read = [&payload, &cursor](void* data, size_t size) {
+        if (payload.size() - cursor < size) {
+            return false;
+        }
+        std::memcpy(data, payload.data() + cursor, size);
+        cursor += size;
+        return true;
+    };
+
+    uint32_t count = 0;
+    if (!read(&count, sizeof(count))) {
+        return false;
+    }
+
+    tinygltf::Value::Object attributeMap;
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t length = 0;
+        if (!read(&length, sizeof(length)) || payload.size() - cursor < length) {
+            return false;
+        }
+        std::string name(reinterpret_cast<const char*>(payload.data() + cursor), length);
+        cursor += length;
+        int32_t id = 0;
+        if (!read(&id, sizeof(id)) || primitive.attributes.count(name) == 0) {
+            return false;
+        }
+        attributeMap[name] = tinygltf::Value(static_cast<int>(id));
+    }
+    if (cursor == payload.size()) {
+        return false;
+    }
+
+    compressedData.assign(payload.begin() + static_cast<std::ptrdiff_t>(cursor), payload.end());
+
+    tinygltf::Value::Object dracoObject;
+    dracoObject["attributes"] = tinygltf::Value(attributeMap);
+    primitive.extensions[kDracoExtension] = tinygltf::Value(dracoObject);
+    return true;
+}
 #endif // GLTFU_ENABLE_DRACO
 
 } // namespace
 
+size_t GltfCompress::buildMeshes(const tinygltf::Model& model, bool perVertex) {
+#ifndef GLTFU_ENABLE_DRACO
+    (void)model;
+    (void)perVertex;
+    return 0;
+#else
+    size_t built = 0;
+    for (const auto& mesh : model.meshes) {
+        for (const auto& primitive : mesh.primitives) {
+            std::map<std::string, int> attributeIds;
+            if (buildDracoMesh(model, primitive, perVertex, attributeIds)) {
+                ++built;
+            }
+        }
+    }
+    return built;
+#endif
+}
+
 bool GltfCompress::process(tinygltf::Model& model, const CompressOptions& options) {
 #ifndef GLTFU_ENABLE_DRACO
     error_ = "Draco compression is not enabled. Rebuild with Draco support.";
@@ -324,6 +850,8 @@ bool GltfCompress::process(tinygltf::Model& model, const CompressOptions& option
 #else
     error_.clear();
     stats_.clear();
+    verification_ = CompressVerification();
+    VerificationTotals verificationTotals;
 
     addExtension(model.extensionsUsed, kDracoExtension);
     addExtension(model.extensionsRequired, kDracoExtension);
@@ -335,11 +863,61 @@ bool GltfCompress::process(tinygltf::Model& model, const CompressOptions& option
     size_t totalOriginal = 0;
     size_t totalCompressed = 0;
     int skipped = 0;
+    size_t reused = 0;
+    std::map<EncodingKey, size_t> encodings;
+
+    std::unique_ptr<PrimitiveCache> cache;
+    CacheFingerprint fingerprint;
+    if (!options.cacheDirectory.empty()) {
+        cache = std::make_unique<PrimitiveCache>(options.cacheDirectory);
+        fingerprint.add(options);
+    }
+
+    // Auto mode measures errors in world units at the largest scale each mesh is drawn at
+    std::vector<double> meshScales;
+    size_t tuned = 0;
+    size_t tunedMetTarget = 0;
+    int minPositionBits = kAutoMaxPositionBits;
+    int maxPositionBits = 0;
+    int minNormalBits = kAutoMaxNormalBits;
+    int maxNormalBits = 0;
+    int minSpeed = 10;
+    int maxSpeed = 0;
+    if (options.autoTune) {
+        meshScales.assign(model.meshes.size(), 0.0);
+        const std::vector<Matrix4> worldMatrices = GltfFlatten::computeWorldMatrices(model);
+        for (size_t nodeIdx = 0; nodeIdx < model.nodes.size(); ++nodeIdx) {
+            const int meshIdx = model.nodes[nodeIdx].mesh;
+            if (meshIdx >= 0 && meshIdx < static_cast<int>(model.meshes.size())) {
+                meshScales[meshIdx] = std::max(meshScales[meshIdx], maxAxisScale(worldMatrices[nodeIdx]));
+            }
+        }
+        for (double& scale : meshScales) {
+            if (scale <= 0.0) {
+                scale = 1.0;
+            }
+        }
+    }
 
     for (size_t meshIdx = 0; meshIdx < model.meshes.size(); ++meshIdx) {
         auto& mesh = model.meshes[meshIdx];
         for (size_t primIdx = 0; primIdx < mesh.primitives.size(); ++primIdx) {
             auto& primitive = mesh.primitives[primIdx];
+            TraceScope traceScope("compress", "primitive", static_cast<long long>(meshIdx),
+                                  static_cast<long long>(primIdx));
+
+            // Draco reorders vertices, which would invalidate the meshlet vertex lists
+            if (primitive.extensions.count(kMeshletsExtension) > 0) {
+                ++skipped;
+                continue;
+            }
+
+            // Only triangle lists are encoded; checked before the reuse lookup so a
+            // line or point primitive sharing accessors with a mesh is never given its encoding
+            if (primitive.mode != TINYGLTF_MODE_TRIANGLES) {
+                ++skipped;
+                continue;
+            }
 
             size_t original = 0;
             for (const auto& attribute : primitive.attributes) {
@@ -347,11 +925,79 @@ bool GltfCompress::process(tinygltf::Model& model, const CompressOptions& option
             }
             original += accessorByteLength(model, primitive.indices);
 
+            AutoChoice autoChoice;
+            if (options.autoTune) {
+                autoChoice.worldScale = meshScales[meshIdx];
+                autoChoice.targetBytes = static_cast<size_t>(static_cast<double>(original) * options.autoTargetRatio);
+            }
+
+            const EncodingKey encodingKey = makeEncodingKey(primitive, options.autoTune ? autoChoice.worldScale : 0.0);
+            const auto encodingIt = encodings.find(encodingKey);
+            if (encodingIt != encodings.end()) {
+                const auto& sourceRecord = records[encodingIt->second];
+                primitive.extensions[kDracoExtension] =
+                    model.meshes[sourceRecord.meshIdx].primitives[sourceRecord.primIdx].extensions.at(kDracoExtension);
+                records.push_back({meshIdx, primIdx, sourceRecord.offset, sourceRecord.length, original,
+                                   static_cast<int>(encodingIt->second)});
+                totalOriginal += original;
+                ++reused;
+                if (options.verbose) {
+                    std::cout << "  Reused encoding of primitive " << sourceRecord.meshIdx << ':'
+                              << sourceRecord.primIdx << " for " << meshIdx << ':' << primIdx << std::endl;
+                }
+                continue;
+            }
+
 #ifdef GLTFU_ENABLE_DRACO
             std::vector<uint8_t> compressed;
-            if (!compressPrimitive(model, mesh, primIdx, options, compressed)) {
-                ++skipped;
-                continue;
+            std::string cacheKey;
+            bool cached = false;
+            if (cache) {
+                CacheFingerprint scaledFingerprint;
+                if (options.autoTune) {
+                    scaledFingerprint.add(options).add("compress.autoScale", autoChoice.worldScale);
+                }
+                cacheKey = PrimitiveCache::hashPrimitive(model, primitive,
+                                                         options.autoTune ? scaledFingerprint : fingerprint);
+                std::vector<uint8_t> payload;
+                cached = !cacheKey.empty() && cache->load(kCacheStage, cacheKey, payload) &&
+                         decodeCachedPrimitive(payload, primitive, compressed);
+            }
+            if (!cached) {
+                if (!compressPrimitive(model, mesh, primIdx, options, compressed,
+                                       options.autoTune ? &autoChoice : nullptr)) {
+                    ++skipped;
+                    continue;
+                }
+                if (options.autoTune) {
+                    ++tuned;
+                    tunedMetTarget += autoChoice.metTarget ? 1 : 0;
+                    minPositionBits = std::min(minPositionBits, autoChoice.positionBits);
+                    maxPositionBits = std::max(maxPositionBits, autoChoice.positionBits);
+                    minNormalBits = std::min(minNormalBits, autoChoice.normalBits);
+                    maxNormalBits = std::max(maxNormalBits, autoChoice.normalBits);
+                    minSpeed = std::min(minSpeed, autoChoice.speed);
+                    maxSpeed = std::max(maxSpeed, autoChoice.speed);
+                    if (options.verbose) {
+                        std::cout << "  Auto " << meshIdx << ':' << primIdx << " position " << autoChoice.positionBits
+                                  << " bits, normal " << autoChoice.normalBits << " bits, speed " << autoChoice.speed
+                                  << (autoChoice.metTarget ? "" : " (size target missed)") << std::endl;
+                    }
+                }
+                if (cache && !cacheKey.empty()) {
+                    cache->store(kCacheStage, cacheKey, encodeCachedPrimitive(primitive, compressed));
+                }
+            }
+
+            if (options.verify) {
+                // Cached auto-tuned entries have unknown bits; the coarsest search bound keeps matching exact
+                int positionBits = options.positionQuantizationBits;
+                if (options.autoTune) {
+                    positionBits = cached ? kAutoMinPositionBits : autoChoice.positionBits;
+                }
+                if (!verifyPrimitive(model, primitive, compressed, positionBits, verification_, verificationTotals)) {
+                    ++verification_.failures;
+                }
             }
 #endif
 
@@ -359,7 +1005,8 @@ bool GltfCompress::process(tinygltf::Model& model, const CompressOptions& option
             compressedBufferData.insert(compressedBufferData.end(),
                                         compressed.begin(), compressed.end());
 
-            records.push_back({meshIdx, primIdx, offset, compressed.size(), original});
+            encodings.emplace(encodingKey, records.size());
+            records.push_back({meshIdx, primIdx, offset, compressed.size(), original, -1});
             totalOriginal += original;
             totalCompressed += compressed.size();
 
@@ -373,6 +1020,25 @@ bool GltfCompress::process(tinygltf::Model& model, const CompressOptions& option
         }
     }
 
+    if (verificationTotals.positionSamples > 0) {
+        verification_.rmsPositionError =
+            std::sqrt(verificationTotals.positionSquared / static_cast<double>(verificationTotals.positionSamples));
+    }
+    if (verificationTotals.normalSamples > 0) {
+        verification_.rmsNormalError =
+            std::sqrt(verificationTotals.normalSquared / static_cast<double>(verificationTotals.normalSamples));
+    }
+    if (verificationTotals.texCoordSamples > 0) {
+        verification_.rmsTexCoordError =
+            std::sqrt(verificationTotals.texCoordSquared / static_cast<double>(verificationTotals.texCoordSamples));
+    }
+    if (verification_.failures > 0) {
+        std::ostringstream stream;
+        stream << verification_.failures << " compressed primitives failed to decode";
+        error_ = stream.str();
+        return false;
+    }
+
     if (records.empty()) {
         if (skipped > 0) {
             std::ostringstream stream;
@@ -387,13 +1053,53 @@ bool GltfCompress::process(tinygltf::Model& model, const CompressOptions& option
     model.buffers.push_back(std::move(buffer));
     const int bufferIdx = static_cast<int>(model.buffers.size() - 1);
 
+    // Accessors still read by a primitive left uncompressed (lines, points, meshlets or a
+    // failed encode) keep their data; the spec allows Draco primitives to carry it as fallback
+    std::vector<std::vector<char>> compressedPrimitives(model.meshes.size());
+    for (size_t meshIdx = 0; meshIdx < model.meshes.size(); ++meshIdx) {
+        compressedPrimitives[meshIdx].assign(model.meshes[meshIdx].primitives.size(), 0);
+    }
     for (const auto& record : records) {
-        tinygltf::BufferView view;
-        view.buffer = bufferIdx;
-        view.byteOffset = record.offset;
-        view.byteLength = record.length;
-        model.bufferViews.push_back(std::move(view));
-        const int viewIdx = static_cast<int>(model.bufferViews.size() - 1);
+        compressedPrimitives[record.meshIdx][record.primIdx] = 1;
+    }
+    std::vector<char> keepAccessor(model.accessors.size(), 0);
+    const auto keep = [&](int accessorIdx) {
+        if (accessorIdx >= 0 && accessorIdx < static_cast<int>(keepAccessor.size())) {
+            keepAccessor[accessorIdx] = 1;
+        }
+    };
+    for (size_t meshIdx = 0; meshIdx < model.meshes.size(); ++meshIdx) {
+        const auto& primitives = model.meshes[meshIdx].primitives;
+        for (size_t primIdx = 0; primIdx < primitives.size(); ++primIdx) {
+            if (compressedPrimitives[meshIdx][primIdx]) {
+                continue;
+            }
+            keep(primitives[primIdx].indices);
+            for (const auto& attribute : primitives[primIdx].attributes) {
+                keep(attribute.second);
+            }
+            for (const auto& target : primitives[primIdx].targets) {
+                for (const auto& attribute : target) {
+                    keep(attribute.second);
+                }
+            }
+        }
+    }
+
+    std::vector<int> recordViews(records.size(), -1);
+    for (size_t recordIdx = 0; recordIdx < records.size(); ++recordIdx) {
+        const auto& record = records[recordIdx];
+        if (record.source >= 0) {
+            recordViews[recordIdx] = recordViews[record.source];
+        } else {
+            tinygltf::BufferView view;
+            view.buffer = bufferIdx;
+            view.byteOffset = record.offset;
+            view.byteLength = record.length;
+            model.bufferViews.push_back(std::move(view));
+            recordViews[recordIdx] = static_cast<int>(model.bufferViews.size() - 1);
+        }
+        const int viewIdx = recordViews[recordIdx];
 
         auto& primitive = model.meshes[record.meshIdx].primitives[record.primIdx];
         auto& extension = primitive.extensions[kDracoExtension];
@@ -404,11 +1110,13 @@ bool GltfCompress::process(tinygltf::Model& model, const CompressOptions& option
         ensurePositionBounds(model, primitive);
 
         for (const auto& attribute : primitive.attributes) {
-            if (attribute.second >= 0 && attribute.second < static_cast<int>(model.accessors.size())) {
+            if (attribute.second >= 0 && attribute.second < static_cast<int>(model.accessors.size()) &&
+                !keepAccessor[attribute.second]) {
                 model.accessors[attribute.second].bufferView = -1;
             }
         }
-        if (primitive.indices >= 0 && primitive.indices < static_cast<int>(model.accessors.size())) {
+        if (primitive.indices >= 0 && primitive.indices < static_cast<int>(model.accessors.size()) &&
+            !keepAccessor[primitive.indices]) {
             model.accessors[primitive.indices].bufferView = -1;
         }
     }
@@ -418,12 +1126,38 @@ bool GltfCompress::process(tinygltf::Model& model, const CompressOptions& option
     if (skipped > 0) {
         summary << " (skipped " << skipped << ")";
     }
+    if (tuned > 0) {
+        summary << "\nAuto settings: position " << minPositionBits << '-' << maxPositionBits << " bits, normal "
+                << minNormalBits << '-' << maxNormalBits << " bits, speed " << minSpeed << '-' << maxSpeed << " ("
+                << tunedMetTarget << '/' << tuned << " primitives within the size target)";
+    }
+    if (options.verify && verification_.primitives > 0) {
+        const double seconds = std::max(verification_.decodeSeconds, 1e-9);
+        summary << "\nVerified " << verification_.primitives << " primitives: decode "
+                << std::setprecision(1) << verification_.bytes / seconds / (1024.0 * 1024.0) << " MB/s, "
+                << std::setprecision(2) << verification_.vertices / seconds / 1e6 << " Mvertices/s";
+        summary << std::scientific << std::setprecision(3);
+        summary << "\nPosition error: max " << verification_.maxPositionError << ", RMS "
+                << verification_.rmsPositionError;
+        summary << "\nNormal error: max " << verification_.maxNormalError << " deg, RMS "
+                << verification_.rmsNormalError << " deg";
+        summary << "\nUV error: max " << verification_.maxTexCoordError << ", RMS "
+                << verification_.rmsTexCoordError;
+        summary << std::fixed;
+    }
+    if (reused > 0) {
+        summary << "\nShared encodings: " << reused << " primitives reuse an identical encoding";
+    }
     summary << "\nOriginal size: " << totalOriginal << " bytes";
     summary << "\nCompressed size: " << totalCompressed << " bytes";
     const size_t saved = totalOriginal > totalCompressed ? totalOriginal - totalCompressed : 0;
     const double ratio = totalOriginal ? (static_cast<double>(totalCompressed) / totalOriginal) * 100.0 : 0.0;
     summary << "\nCompression ratio: " << std::fixed << std::setprecision(1) << ratio << '%';
     summary << "\nSpace saved: " << saved << " bytes";
+    if (cache) {
+        summary << "\nPrimitive cache: " << cache->getHits() << " hits, "
+                << cache->getMisses() << " misses";
+    }
     stats_ = summary.str();
 
     return true;
@@ -39,16 +39,58 @@ struct CompressOptions {
     // Verbose output
     bool verbose = false;
     
+    // Pick quantization bits and speed per primitive instead of the fixed
+    // settings above: the fewest bits within the error limits, then the
+    // fastest-decoding speed whose output fits the size target
+    bool autoTune = false;
+    
+    // Auto: largest position error in world units
+    double autoMaxPositionError = 0.001;
+    
+    // Auto: largest normal error in degrees
+    double autoMaxNormalError = 1.0;
+    
+    // Auto: compressed size target as a fraction of the uncompressed size
+    double autoTargetRatio = 0.25;
+    
+    // Decode every encoding again and measure its error against the source
+    bool verify = false;
+    
+    // Persistent per-primitive encoding cache (empty = disabled)
+    std::string cacheDirectory;
+    
     // Constructor with default values
     CompressOptions() = default;
 };
 
+/**
+ * Round-trip error and decode speed measured by CompressOptions::verify.
+ * Errors compare each decoded point with the nearest source vertex; only
+ * float attributes (POSITION, NORMAL, TEXCOORD_0) are measured.
+ */
+struct CompressVerification {
+    size_t primitives = 0;
+    size_t vertices = 0;          // Decoded points
+    size_t bytes = 0;             // Draco bytes decoded
+    size_t failures = 0;          // Blobs that did not decode
+    double decodeSeconds = 0.0;
+    double maxPositionError = 0.0;  // Model units
+    double rmsPositionError = 0.0;
+    double maxNormalError = 0.0;    // Degrees
+    double rmsNormalError = 0.0;
+    double maxTexCoordError = 0.0;  // UV units
+    double rmsTexCoordError = 0.0;
+};
+
 /**
  * Class responsible for compressing glTF meshes using Draco compression
  * 
  * This class compresses mesh geometry using Google's Draco compression library,
  * significantly reducing file sizes while maintaining visual quality. It adds
  * the KHR_draco_mesh_compression extension to the glTF file.
+ *
+ * Primitives that reference the same index and attribute accessors (as left
+ * by dedupe for instanced content) are encoded once and share one bufferView.
  */
 class GltfCompress {
 public:
@@ -63,6 +105,15 @@ public:
      */
     bool process(tinygltf::Model& model, const CompressOptions& options = CompressOptions());
 
+    /**
+     * Build, without encoding, the Draco mesh of every compressible primitive.
+     * Lets gltfu_bench time attribute and index upload on their own.
+     * @param model The glTF model to read
+     * @param perVertex Upload attributes one vertex at a time instead of in bulk
+     * @return Number of Draco meshes built
+     */
+    static size_t buildMeshes(const tinygltf::Model& model, bool perVertex = false);
+
     /**
      * Get the last error message
      */
@@ -73,9 +124,15 @@ public:
      */
     const std::string& getStats() const { return stats_; }
 
+    /**
+     * Get the round-trip measurements of the last run with verify enabled
+     */
+    const CompressVerification& getVerification() const { return verification_; }
+
 private:
     std::string error_;
     std::string stats_;
+    CompressVerification verification_;
 };
 
 } // namespace gltfu
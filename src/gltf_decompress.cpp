@@ -0,0 +1,324 @@
+#include "gltf_decompress.h"
+#include "buffer_arena.h"
+#include "trace.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#ifdef GLTFU_ENABLE_DRACO
+#include "draco/compression/decode.h"
+#include "draco/core/decoder_buffer.h"
+#include "draco/mesh/mesh.h"
+#endif
+
+namespace gltfu {
+namespace {
+
+constexpr const char* kDracoExtension = "KHR_draco_mesh_compression";
+
+#ifdef GLTFU_ENABLE_DRACO
+
+// Primitives sharing a compressed bufferView and accessors, as compress writes reused
+// encodings, decode once and are repointed together
+struct DecodeKey {
+    int bufferView = -1;
+    int indices = -1;
+    std::vector<std::pair<std::string, int>> attributes;
+
+    bool operator<(const DecodeKey& other) const {
+        return std::tie(bufferView, indices, attributes) <
+               std::tie(other.bufferView, other.indices, other.attributes);
+    }
+};
+
+DecodeKey makeDecodeKey(const tinygltf::Primitive& primitive) {
+    DecodeKey key;
+    const tinygltf::Value& extension = primitive.extensions.at(kDracoExtension);
+    key.bufferView = extension.Has("bufferView") ? extension.Get("bufferView").GetNumberAsInt() : -1;
+    key.indices = primitive.indices;
+    key.attributes.assign(primitive.attributes.begin(), primitive.attributes.end());
+    return key;
+}
+
+// Decoded streams of one Draco blob, staged until every blob has decoded
+struct DecodedPrimitive {
+    size_t meshIdx = 0;         // First primitive using the blob; it is the one decoded
+    size_t primIdx = 0;
+    std::vector<std::pair<size_t, size_t>> shared;  // Other primitives with the same key
+    size_t points = 0;
+    size_t faces = 0;
+    int indexComponentType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT;
+    std::vector<uint8_t> indices;
+    std::vector<std::pair<std::string, std::vector<uint8_t>>> attributes;
+    std::string error;
+};
+
+template <typename T>
+void writeIndices(const draco::Mesh& mesh, std::vector<uint8_t>& out) {
+    out.resize(static_cast<size_t>(mesh.num_faces()) * 3 * sizeof(T));
+    T* dst = reinterpret_cast<T*>(out.data());
+    for (uint32_t face = 0; face < mesh.num_faces(); ++face) {
+        const auto& corners = mesh.face(draco::FaceIndex(face));
+        for (size_t corner = 0; corner < 3; ++corner) {
+            dst[size_t(face) * 3 + corner] = static_cast<T>(corners[corner].value());
+        }
+    }
+}
+
+template <typename T>
+bool writeAttribute(const draco::PointAttribute& attribute, uint32_t points, int components,
+                    std::vector<uint8_t>& out) {
+    out.resize(static_cast<size_t>(points) * components * sizeof(T));
+    T* dst = reinterpret_cast<T*>(out.data());
+    for (uint32_t point = 0; point < points; ++point) {
+        if (!attribute.ConvertValue<T>(attribute.mapped_index(draco::PointIndex(point)),
+                                       static_cast<int8_t>(components), dst + size_t(point) * components)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool convertAttribute(const draco::PointAttribute& attribute, uint32_t points, const tinygltf::Accessor& accessor,
+                      std::vector<uint8_t>& out) {
+    const int components = tinygltf::GetNumComponentsInType(static_cast<uint32_t>(accessor.type));
+    if (components <= 0) {
+        return false;
+    }
+    switch (accessor.componentType) {
+        case TINYGLTF_COMPONENT_TYPE_BYTE: return writeAttribute<int8_t>(attribute, points, components, out);
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: return writeAttribute<uint8_t>(attribute, points, components, out);
+        case TINYGLTF_COMPONENT_TYPE_SHORT: return writeAttribute<int16_t>(attribute, points, components, out);
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: return writeAttribute<uint16_t>(attribute, points, components, out);
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT: return writeAttribute<uint32_t>(attribute, points, components, out);
+        case TINYGLTF_COMPONENT_TYPE_FLOAT: return writeAttribute<float>(attribute, points, components, out);
+        default: return false;
+    }
+}
+
+void decodePrimitive(const tinygltf::Model& model, DecodedPrimitive& decoded) {
+    const auto& primitive = model.meshes[decoded.meshIdx].primitives[decoded.primIdx];
+    const tinygltf::Value& extension = primitive.extensions.at(kDracoExtension);
+    const int viewIdx = extension.Has("bufferView") ? extension.Get("bufferView").GetNumberAsInt() : -1;
+    if (viewIdx < 0 || viewIdx >= static_cast<int>(model.bufferViews.size()) || !extension.Has("attributes")) {
+        decoded.error = "missing bufferView or attributes";
+        return;
+    }
+    const auto& view = model.bufferViews[viewIdx];
+    if (view.buffer < 0 || view.buffer >= static_cast<int>(model.buffers.size()) ||
+        view.byteOffset + view.byteLength > model.buffers[view.buffer].data.size()) {
+        decoded.error = "bufferView out of range";
+        return;
+    }
+
+    draco::DecoderBuffer buffer;
+    buffer.Init(reinterpret_cast<const char*>(model.buffers[view.buffer].data.data() + view.byteOffset),
+                view.byteLength);
+    draco::Decoder decoder;
+    auto result = decoder.DecodeMeshFromBuffer(&buffer);
+    if (!result.ok()) {
+        decoded.error = "Draco decode failed";
+        return;
+    }
+    const std::unique_ptr<draco::Mesh> mesh = std::move(result).value();
+    decoded.points = mesh->num_points();
+    decoded.faces = mesh->num_faces();
+
+    // Keep the index type unless the decoded point count no longer fits it
+    if (primitive.indices >= 0 && primitive.indices < static_cast<int>(model.accessors.size())) {
+        decoded.indexComponentType = model.accessors[primitive.indices].componentType;
+    }
+    if ((decoded.indexComponentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE && decoded.points > 0xffu) ||
+        (decoded.indexComponentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT && decoded.points > 0xffffu) ||
+        (decoded.indexComponentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE &&
+         decoded.indexComponentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)) {
+        decoded.indexComponentType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT;
+    }
+    switch (decoded.indexComponentType) {
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: writeIndices<uint8_t>(*mesh, decoded.indices); break;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: writeIndices<uint16_t>(*mesh, decoded.indices); break;
+        default: writeIndices<uint32_t>(*mesh, decoded.indices); break;
+    }
+
+    const tinygltf::Value& attributeIds = extension.Get("attributes");
+    for (const auto& name : attributeIds.Keys()) {
+        const auto accessorIt = primitive.attributes.find(name);
+        if (accessorIt == primitive.attributes.end() || accessorIt->second < 0 ||
+            accessorIt->second >= static_cast<int>(model.accessors.size())) {
+            continue;
+        }
+        const draco::PointAttribute* attribute =
+            mesh->GetAttributeByUniqueId(static_cast<uint32_t>(attributeIds.Get(name).GetNumberAsInt()));
+        std::vector<uint8_t> data;
+        if (!attribute || !convertAttribute(*attribute, mesh->num_points(), model.accessors[accessorIt->second], data)) {
+            decoded.error = "cannot convert attribute " + name;
+            return;
+        }
+        decoded.attributes.emplace_back(name, std::move(data));
+    }
+}
+
+#endif // GLTFU_ENABLE_DRACO
+
+} // namespace
+
+bool GltfDecompress::process(tinygltf::Model& model, const DecompressOptions& options) {
+    error_.clear();
+    stats_.clear();
+
+    std::vector<std::pair<size_t, size_t>> targets;
+    for (size_t meshIdx = 0; meshIdx < model.meshes.size(); ++meshIdx) {
+        const auto& primitives = model.meshes[meshIdx].primitives;
+        for (size_t primIdx = 0; primIdx < primitives.size(); ++primIdx) {
+            if (primitives[primIdx].extensions.count(kDracoExtension) > 0) {
+                targets.emplace_back(meshIdx, primIdx);
+            }
+        }
+    }
+
+    if (targets.empty()) {
+        stats_ = "No Draco-compressed primitives";
+        return true;
+    }
+
+#ifndef GLTFU_ENABLE_DRACO
+    (void)options;
+    error_ = "Draco decompression is not enabled. Rebuild with Draco support.";
+    return false;
+#else
+    std::vector<DecodedPrimitive> decoded;
+    std::map<DecodeKey, size_t> blobs;
+    for (const auto& target : targets) {
+        const DecodeKey key = makeDecodeKey(model.meshes[target.first].primitives[target.second]);
+        const auto inserted = blobs.emplace(key, decoded.size());
+        if (inserted.second) {
+            decoded.emplace_back();
+            decoded.back().meshIdx = target.first;
+            decoded.back().primIdx = target.second;
+        } else {
+            decoded[inserted.first->second].shared.push_back(target);
+        }
+    }
+
+    size_t jobs = options.jobs > 0 ? static_cast<size_t>(options.jobs)
+                                   : std::max(1u, std::thread::hardware_concurrency());
+    jobs = std::min(jobs, decoded.size());
+
+    {
+        TraceScope traceScope("decompress", "decode");
+        std::atomic<size_t> next{0};
+        auto worker = [&]() {
+            for (size_t idx = next++; idx < decoded.size(); idx = next++) {
+                TraceScope primitiveScope("decompress", "primitive", static_cast<long long>(decoded[idx].meshIdx),
+                                          static_cast<long long>(decoded[idx].primIdx));
+                decodePrimitive(model, decoded[idx]);
+            }
+        };
+        std::vector<std::thread> threads;
+        for (size_t t = 1; t < jobs; ++t) {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    for (const auto& primitive : decoded) {
+        if (!primitive.error.empty()) {
+            std::ostringstream stream;
+            stream << "Failed to decode primitive " << primitive.meshIdx << ':' << primitive.primIdx << ": "
+                   << primitive.error;
+            error_ = stream.str();
+            return false;
+        }
+    }
+
+    size_t totalPoints = 0;
+    size_t totalFaces = 0;
+    BufferArena arena(model);
+    for (auto& entry : decoded) {
+        auto& primitive = model.meshes[entry.meshIdx].primitives[entry.primIdx];
+
+        if (primitive.indices < 0 || primitive.indices >= static_cast<int>(model.accessors.size())) {
+            model.accessors.emplace_back();
+            primitive.indices = static_cast<int>(model.accessors.size() - 1);
+        }
+        auto& indexAccessor = model.accessors[primitive.indices];
+        indexAccessor.bufferView = arena.append(entry.indices.data(), entry.indices.size(),
+                                                TINYGLTF_TARGET_ELEMENT_ARRAY_BUFFER);
+        indexAccessor.byteOffset = 0;
+        indexAccessor.componentType = entry.indexComponentType;
+        indexAccessor.type = TINYGLTF_TYPE_SCALAR;
+        indexAccessor.count = entry.faces * 3;
+        indexAccessor.sparse.isSparse = false;
+
+        for (const auto& attribute : entry.attributes) {
+            auto& accessor = model.accessors[primitive.attributes.at(attribute.first)];
+            accessor.bufferView = arena.append(attribute.second.data(), attribute.second.size(),
+                                               TINYGLTF_TARGET_ARRAY_BUFFER);
+            accessor.byteOffset = 0;
+            accessor.count = entry.points;
+            accessor.sparse.isSparse = false;
+
+            if (attribute.first == "POSITION" && accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT &&
+                accessor.type == TINYGLTF_TYPE_VEC3 && entry.points > 0) {
+                const float* positions = reinterpret_cast<const float*>(attribute.second.data());
+                std::vector<double> minValues(3, std::numeric_limits<double>::max());
+                std::vector<double> maxValues(3, std::numeric_limits<double>::lowest());
+                for (size_t point = 0; point < entry.points; ++point) {
+                    for (size_t axis = 0; axis < 3; ++axis) {
+                        minValues[axis] = std::min(minValues[axis], double(positions[point * 3 + axis]));
+                        maxValues[axis] = std::max(maxValues[axis], double(positions[point * 3 + axis]));
+                    }
+                }
+                accessor.minValues = minValues;
+                accessor.maxValues = maxValues;
+            }
+        }
+
+        primitive.extensions.erase(kDracoExtension);
+        totalPoints += entry.points;
+        totalFaces += entry.faces;
+
+        // Sharers already point at the same accessors; only a synthesized index accessor differs
+        for (const auto& other : entry.shared) {
+            auto& sharer = model.meshes[other.first].primitives[other.second];
+            sharer.indices = primitive.indices;
+            sharer.extensions.erase(kDracoExtension);
+        }
+
+        if (options.verbose) {
+            std::cout << "[decompress] Primitive " << entry.meshIdx << ':' << entry.primIdx << ": " << entry.points
+                      << " points, " << entry.faces << " triangles";
+            if (!entry.shared.empty()) {
+                std::cout << " (shared by " << entry.shared.size() << " more)";
+            }
+            std::cout << std::endl;
+        }
+    }
+    arena.commit();
+
+    auto removeExtension = [](std::vector<std::string>& list) {
+        list.erase(std::remove(list.begin(), list.end(), kDracoExtension), list.end());
+    };
+    removeExtension(model.extensionsUsed);
+    removeExtension(model.extensionsRequired);
+
+    std::ostringstream stream;
+    stream << "Decompressed " << targets.size() << " primitives from " << decoded.size() << " Draco streams ("
+           << totalPoints << " vertices, " << totalFaces << " triangles) on " << jobs << " threads";
+    stats_ = stream.str();
+    return true;
+#endif
+}
+
+} // namespace gltfu
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "tiny_gltf.h"
+#include <string>
+
+namespace gltfu {
+
+/**
+ * Options for the decompress operation.
+ */
+struct DecompressOptions {
+    int jobs = 0;                // Decoder threads (0 = hardware concurrency)
+    bool verbose = false;        // Emit per-primitive point and face counts
+};
+
+/**
+ * Decompress decodes KHR_draco_mesh_compression primitives back into plain
+ * accessors, so weld, join, simplify and dedupe can work on third-party
+ * compressed assets.
+ *
+ * Primitives are decoded in parallel. Primitives that share the compressed
+ * bufferView and accessors, as compress writes reused encodings, are decoded
+ * once and repointed together. Each decoded index and attribute stream
+ * is converted to its accessor's component type and appended to buffer 0 as
+ * a regular bufferView. The accessors are repointed at these views, and POSITION
+ * min/max is recomputed from the decoded values. The extension is then removed
+ * from the primitives and from extensionsUsed/extensionsRequired. The
+ * compressed bufferViews are left unreferenced for prune to remove.
+ *
+ * Nothing is changed unless every primitive decodes.
+ */
+class GltfDecompress {
+public:
+    GltfDecompress() = default;
+
+    /**
+     * Decode every Draco-compressed primitive in the model.
+     * @param model The GLTF model to process
+     * @param options Decompress options
+     * @return true if successful
+     */
+    bool process(tinygltf::Model& model, const DecompressOptions& options = DecompressOptions());
+    std::string getStats() const { return stats_; }
+    std::string getError() const { return error_; }
+
+private:
+    std::string stats_;
+    std::string error_;
+};
+
+} // namespace gltfu
@@ -76,8 +76,67 @@ void setNodeMatrix(tinygltf::Node& node, const Matrix4& matrix) {
     node.scale.clear();
 }
 
+// Parent, world matrix, depth and root of every node
+struct NodeHierarchy {
+    std::vector<int> parent;
+    std::vector<Matrix4> world;
+    std::vector<int> depth;
+    std::vector<int> root;
+};
+
+NodeHierarchy buildHierarchy(const tinygltf::Model& model) {
+    const size_t totalNodes = model.nodes.size();
+    NodeHierarchy hierarchy;
+    hierarchy.parent.assign(totalNodes, -1);
+    for (size_t parent = 0; parent < totalNodes; ++parent) {
+        for (int child : model.nodes[parent].children) {
+            if (child >= 0 && child < static_cast<int>(totalNodes)) {
+                hierarchy.parent[child] = static_cast<int>(parent);
+            }
+        }
+    }
+
+    hierarchy.world.assign(totalNodes, kIdentityMatrix);
+    hierarchy.depth.assign(totalNodes, 0);
+    hierarchy.root.assign(totalNodes, -1);
+    std::vector<char> state(totalNodes, 0); // 0 = pending, 1 = in progress, 2 = done
+
+    std::function<void(int)> computeWorld = [&](int nodeIdx) {
+        if (state[nodeIdx] != 0) {
+            return;
+        }
+        state[nodeIdx] = 1;
+
+        const Matrix4 local = getNodeMatrix(model.nodes[nodeIdx]);
+        const int parent = hierarchy.parent[nodeIdx];
+        if (parent >= 0) {
+            computeWorld(parent);
+        }
+        // A parent still in progress means a malformed cycle; cut it here and treat the node as a root
+        if (parent >= 0 && state[parent] == 2) {
+            hierarchy.world[nodeIdx] = multiply(hierarchy.world[parent], local);
+            hierarchy.depth[nodeIdx] = hierarchy.depth[parent] + 1;
+            hierarchy.root[nodeIdx] = hierarchy.root[parent];
+        } else {
+            hierarchy.world[nodeIdx] = local;
+            hierarchy.depth[nodeIdx] = 0;
+            hierarchy.root[nodeIdx] = nodeIdx;
+        }
+        state[nodeIdx] = 2;
+    };
+
+    for (int nodeIdx = 0; nodeIdx < static_cast<int>(totalNodes); ++nodeIdx) {
+        computeWorld(nodeIdx);
+    }
+    return hierarchy;
+}
+
 } // namespace
 
+std::vector<Matrix4> GltfFlatten::computeWorldMatrices(const tinygltf::Model& model) {
+    return buildHierarchy(model).world;
+}
+
 int GltfFlatten::process(tinygltf::Model& model, bool cleanup) {
     (void)cleanup; // Reserved for future pruning logic.
 
@@ -88,15 +147,12 @@ int GltfFlatten::process(tinygltf::Model& model, bool cleanup) {
 
     const bool debug = std::getenv("GLTFU_DEBUG_FLATTEN") != nullptr;
 
-    // Build parent lookup once.
-    std::vector<int> parentMap(totalNodes, -1);
-    for (size_t parent = 0; parent < totalNodes; ++parent) {
-        for (int child : model.nodes[parent].children) {
-            if (child >= 0 && child < static_cast<int>(totalNodes)) {
-                parentMap[child] = static_cast<int>(parent);
-            }
-        }
-    }
+    // Parent lookup, world matrices and depth for every node.
+    NodeHierarchy hierarchy = buildHierarchy(model);
+    std::vector<int>& parentMap = hierarchy.parent;
+    const std::vector<Matrix4>& worldMatrix = hierarchy.world;
+    const std::vector<int>& depth = hierarchy.depth;
+    const std::vector<int>& rootNode = hierarchy.root;
 
     // Mark joints and animated nodes (and their descendants) as off-limits.
     std::vector<bool> skip(totalNodes, false);
@@ -145,37 +201,6 @@ int GltfFlatten::process(tinygltf::Model& model, bool cleanup) {
         }
     }
 
-    // Compute world matrices and depth for every node.
-    std::vector<Matrix4> worldMatrix(totalNodes, kIdentityMatrix);
-    std::vector<char> worldComputed(totalNodes, 0);
-    std::vector<int> depth(totalNodes, 0);
-    std::vector<int> rootNode(totalNodes, -1);
-
-    std::function<void(int)> computeWorld = [&](int nodeIdx) {
-        if (worldComputed[nodeIdx]) {
-            return;
-        }
-
-        Matrix4 local = getNodeMatrix(model.nodes[nodeIdx]);
-        const int parent = parentMap[nodeIdx];
-        if (parent >= 0) {
-            computeWorld(parent);
-            worldMatrix[nodeIdx] = multiply(worldMatrix[parent], local);
-            depth[nodeIdx] = depth[parent] + 1;
-            rootNode[nodeIdx] = rootNode[parent];
-        } else {
-            worldMatrix[nodeIdx] = local;
-            depth[nodeIdx] = 0;
-            rootNode[nodeIdx] = nodeIdx;
-        }
-
-        worldComputed[nodeIdx] = 1;
-    };
-
-    for (int nodeIdx = 0; nodeIdx < static_cast<int>(totalNodes); ++nodeIdx) {
-        computeWorld(nodeIdx);
-    }
-
     // Collect flatten candidates (non-root, non-constrained).
     std::vector<int> candidates;
     candidates.reserve(totalNodes);
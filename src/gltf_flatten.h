@@ -1,4 +1,5 @@
 #pragma once
+#include "math_utils.h"
 #include "tiny_gltf.h"
 #include <string>
 #include <vector>
@@ -21,6 +22,14 @@ public:
      * @return Number of nodes flattened
      */
     static int process(tinygltf::Model& model, bool cleanup = true);
+
+    /**
+     * Compute the world matrix of every node from the node hierarchy.
+     *
+     * @param model The GLTF model
+     * @return One column-major matrix per node, indexed like model.nodes
+     */
+    static std::vector<Matrix4> computeWorldMatrices(const tinygltf::Model& model);
 };
 
 } // namespace gltfu
@@ -1,15 +1,46 @@
 #include "gltf_merger.h"
 
+#include "trace.h"
+
+#include "json.hpp"
+
+#define XXH_INLINE_ALL
+#include "xxhash.h"
+
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cctype>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <numeric>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 namespace gltfu {
 namespace {
 
+namespace fs = std::filesystem;
+
 bool hasGlbExtension(const std::string& filename) {
     auto dot = filename.find_last_of('.');
     if (dot == std::string::npos) {
@@ -23,6 +54,31 @@ bool hasGlbExtension(const std::string& filename) {
     return ext == "glb";
 }
 
+// Parse one file; safe to call concurrently as long as each thread owns its loader
+bool loadModel(tinygltf::TinyGLTF& loader, const std::string& filename, tinygltf::Model& model,
+               std::string& error, std::string& warning) {
+    TraceScope loadScope("merge", "load");
+
+    std::string err;
+    bool ok = false;
+    if (hasGlbExtension(filename)) {
+        ok = loader.LoadBinaryFromFile(&model, &err, &warning, filename);
+    } else {
+        ok = loader.LoadASCIIFromFile(&model, &err, &warning, filename);
+    }
+
+    if (!ok || !err.empty()) {
+        error = err.empty() ? ("Failed to load " + filename)
+                            : ("Error loading " + filename + ": " + err);
+        return false;
+    }
+
+    for (auto& buffer : model.buffers) {
+        buffer.uri.clear();
+    }
+    return true;
+}
+
 struct MergeOffsets {
     int nodes = 0;
     int meshes = 0;
@@ -36,6 +92,11 @@ struct MergeOffsets {
     int cameras = 0;
 };
 
+// Merged buffers start on 4-byte boundaries so every accessor keeps its alignment
+size_t align4(size_t value) {
+    return (value + 3) & ~size_t(3);
+}
+
 struct MergeCounts {
     size_t nodes = 0;
     size_t meshes = 0;
@@ -47,8 +108,80 @@ struct MergeCounts {
     size_t bufferViews = 0;
     size_t animations = 0;
     size_t skins = 0;
+    size_t cameras = 0;
+    size_t bufferBytes = 0;
 };
 
+// Grow geometrically; reserving the exact size per merged file would copy everything merged so far every time
+template <typename T>
+void reserveAppend(std::vector<T>& values, size_t extra) {
+    const size_t required = values.size() + extra;
+    if (required > values.capacity()) {
+        values.reserve(std::max(required, values.capacity() * 2));
+    }
+}
+
+// Read element counts and buffer sizes from a file's JSON without loading its binary data
+bool scanInput(const std::string& filename, MergeCounts& counts, std::string& error) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        error = "Failed to open " + filename;
+        return false;
+    }
+
+    std::string text;
+    if (hasGlbExtension(filename)) {
+        // magic, version, length, then the JSON chunk's length and type
+        uint32_t header[5] = {};
+        if (!file.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != 0x46546C67u ||
+            header[4] != 0x4E4F534Au) {
+            error = "Invalid GLB header in " + filename;
+            return false;
+        }
+        text.resize(header[3]);
+        if (!file.read(&text[0], static_cast<std::streamsize>(text.size()))) {
+            error = "Truncated GLB JSON chunk in " + filename;
+            return false;
+        }
+    } else {
+        text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    const nlohmann::json document = nlohmann::json::parse(text, nullptr, false);
+    if (document.is_discarded() || !document.is_object()) {
+        error = "Failed to parse JSON in " + filename;
+        return false;
+    }
+
+    auto arraySize = [&document](const char* key) -> size_t {
+        const auto it = document.find(key);
+        return it != document.end() && it->is_array() ? it->size() : 0;
+    };
+    counts.nodes = arraySize("nodes");
+    counts.meshes = arraySize("meshes");
+    counts.materials = arraySize("materials");
+    counts.textures = arraySize("textures");
+    counts.images = arraySize("images");
+    counts.samplers = arraySize("samplers");
+    counts.accessors = arraySize("accessors");
+    counts.bufferViews = arraySize("bufferViews");
+    counts.animations = arraySize("animations");
+    counts.skins = arraySize("skins");
+    counts.cameras = arraySize("cameras");
+
+    counts.bufferBytes = 0;
+    const auto buffers = document.find("buffers");
+    if (buffers != document.end() && buffers->is_array()) {
+        for (const auto& buffer : *buffers) {
+            const auto byteLength = buffer.find("byteLength");
+            if (byteLength != buffer.end() && byteLength->is_number_unsigned()) {
+                counts.bufferBytes += align4(byteLength->get<size_t>());
+            }
+        }
+    }
+    return true;
+}
+
 void adjustNodes(tinygltf::Model& model, const MergeOffsets& offsets, const MergeCounts& counts) {
     if (counts.nodes == 0) {
         return;
@@ -237,53 +370,606 @@ void applyOffsets(tinygltf::Model& model, const MergeOffsets& offsets, const Mer
     adjustSkins(model, offsets, counts);
 }
 
+// Read a spill file into data; mapped on POSIX so the copy is the only pass over it
+bool readSpill(const std::string& path, size_t size, std::vector<unsigned char>& data) {
+    data.clear();
+    if (size == 0) {
+        return true;
+    }
+#ifdef _WIN32
+    std::ifstream file(path, std::ios::binary);
+    data.resize(size);
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(size)));
+#else
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+    madvise(mapped, size, MADV_SEQUENTIAL);
+    const auto* bytes = static_cast<const unsigned char*>(mapped);
+    data.assign(bytes, bytes + size);
+    munmap(mapped, size);
+    return true;
+#endif
+}
+
+void writeUint32(std::ostream& out, uint32_t value) {
+    const unsigned char bytes[4] = {static_cast<unsigned char>(value), static_cast<unsigned char>(value >> 8),
+                                    static_cast<unsigned char>(value >> 16), static_cast<unsigned char>(value >> 24)};
+    out.write(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+}
+
+struct ContentKey {
+    uint64_t low = 0;
+    uint64_t high = 0;
+
+    bool operator==(const ContentKey& other) const { return low == other.low && high == other.high; }
+};
+
+struct ContentKeyHash {
+    size_t operator()(const ContentKey& key) const { return static_cast<size_t>(key.low); }
+};
+
+ContentKey digest(XXH3_state_t* state) {
+    const XXH128_hash_t hash = XXH3_128bits_digest(state);
+    return ContentKey{hash.low64, hash.high64};
+}
+
+// Bytes of the bufferView, or null when it does not resolve
+const unsigned char* viewBytes(const tinygltf::Model& model, int viewIdx) {
+    if (viewIdx < 0 || viewIdx >= static_cast<int>(model.bufferViews.size())) {
+        return nullptr;
+    }
+    const auto& view = model.bufferViews[viewIdx];
+    if (view.buffer < 0 || view.buffer >= static_cast<int>(model.buffers.size()) ||
+        view.byteOffset + view.byteLength > model.buffers[view.buffer].data.size()) {
+        return nullptr;
+    }
+    return model.buffers[view.buffer].data.data() + view.byteOffset;
+}
+
+// Identity of a plain accessor: layout, the target of its view and its element bytes
+bool accessorKey(const tinygltf::Model& model, const tinygltf::Accessor& accessor, XXH3_state_t* state,
+                 ContentKey& key) {
+    if (accessor.sparse.isSparse || accessor.bufferView < 0) {
+        return false;
+    }
+    const unsigned char* bytes = viewBytes(model, accessor.bufferView);
+    const auto& view = model.bufferViews[accessor.bufferView];
+    const size_t componentSize = tinygltf::GetComponentSizeInBytes(accessor.componentType);
+    const size_t componentCount = tinygltf::GetNumComponentsInType(accessor.type);
+    if (!bytes || componentSize == 0 || componentCount == 0 || accessor.count == 0) {
+        return false;
+    }
+    const size_t elementSize = componentSize * componentCount;
+    const size_t stride = view.byteStride > 0 ? view.byteStride : elementSize;
+    if (accessor.byteOffset + stride * (accessor.count - 1) + elementSize > view.byteLength) {
+        return false;
+    }
+
+    const int64_t header[5] = {accessor.componentType, accessor.type, accessor.normalized ? 1 : 0,
+                               static_cast<int64_t>(accessor.count), view.target};
+    XXH3_128bits_reset(state);
+    XXH3_128bits_update(state, header, sizeof(header));
+    bytes += accessor.byteOffset;
+    if (stride == elementSize) {
+        XXH3_128bits_update(state, bytes, elementSize * accessor.count);
+    } else {
+        for (size_t i = 0; i < accessor.count; ++i) {
+            XXH3_128bits_update(state, bytes + i * stride, elementSize);
+        }
+    }
+    key = digest(state);
+    return true;
+}
+
+// Identity of an image: its encoded bytes when stored in a bufferView, plus location and decoded pixels
+ContentKey imageKey(const tinygltf::Model& model, const tinygltf::Image& image, XXH3_state_t* state) {
+    const int64_t header[4] = {image.width, image.height, image.component, image.bits};
+    XXH3_128bits_reset(state);
+    XXH3_128bits_update(state, header, sizeof(header));
+    XXH3_128bits_update(state, image.mimeType.data(), image.mimeType.size() + 1);
+    XXH3_128bits_update(state, image.uri.data(), image.uri.size() + 1);
+    if (const unsigned char* bytes = viewBytes(model, image.bufferView)) {
+        XXH3_128bits_update(state, bytes, model.bufferViews[image.bufferView].byteLength);
+    }
+    if (!image.image.empty()) {
+        XXH3_128bits_update(state, image.image.data(), image.image.size());
+    }
+    return digest(state);
+}
+
+uint64_t materialBucket(const tinygltf::Material& material) {
+    const auto& pbr = material.pbrMetallicRoughness;
+    const double values[10] = {pbr.baseColorFactor.size() == 4 ? pbr.baseColorFactor[0] : 0.0,
+                               pbr.baseColorFactor.size() == 4 ? pbr.baseColorFactor[1] : 0.0,
+                               pbr.baseColorFactor.size() == 4 ? pbr.baseColorFactor[2] : 0.0,
+                               pbr.metallicFactor,
+                               pbr.roughnessFactor,
+                               static_cast<double>(pbr.baseColorTexture.index),
+                               static_cast<double>(material.normalTexture.index),
+                               static_cast<double>(material.emissiveTexture.index),
+                               material.alphaCutoff,
+                               material.doubleSided ? 1.0 : 0.0};
+    return XXH64(values, sizeof(values), std::hash<std::string>()(material.alphaMode));
+}
+
+void remapIndex(const std::vector<int>& remap, int& idx) {
+    if (idx >= 0 && idx < static_cast<int>(remap.size())) {
+        idx = remap[idx];
+    }
+}
+
+// Visit every "bufferView" index held in extension objects (e.g. KHR_draco_mesh_compression)
+template <typename Visit>
+void visitExtensionBufferViews(tinygltf::Value& value, const Visit& visit) {
+    if (value.IsObject()) {
+        for (auto& entry : value.Get<tinygltf::Value::Object>()) {
+            if (entry.first == "bufferView" && entry.second.IsInt()) {
+                int idx = entry.second.Get<int>();
+                visit(idx);
+                entry.second = tinygltf::Value(idx);
+            } else {
+                visitExtensionBufferViews(entry.second, visit);
+            }
+        }
+    } else if (value.IsArray()) {
+        for (auto& element : value.Get<tinygltf::Value::Array>()) {
+            visitExtensionBufferViews(element, visit);
+        }
+    }
+}
+
+template <typename Visit>
+void visitExtensionBufferViews(tinygltf::Model& model, const Visit& visit) {
+    auto visitMap = [&](tinygltf::ExtensionMap& extensions) {
+        for (auto& extension : extensions) {
+            visitExtensionBufferViews(extension.second, visit);
+        }
+    };
+    for (auto& mesh : model.meshes) {
+        visitMap(mesh.extensions);
+        for (auto& primitive : mesh.primitives) {
+            visitMap(primitive.extensions);
+        }
+    }
+    for (auto& node : model.nodes) {
+        visitMap(node.extensions);
+    }
+}
+
 std::vector<size_t> computeBufferOffsets(const std::vector<tinygltf::Buffer>& buffers) {
     std::vector<size_t> offsets;
     offsets.reserve(buffers.size());
     size_t running = 0;
     for (const auto& buffer : buffers) {
         offsets.push_back(running);
-        running += buffer.data.size();
+        running += align4(buffer.data.size());
     }
     return offsets;
 }
 
 } // namespace
 
+// Content of everything merged so far, keyed for dedup-aware merging
+struct MergeDedupIndex {
+    std::unordered_map<ContentKey, int, ContentKeyHash> accessors;
+    std::unordered_map<ContentKey, int, ContentKeyHash> images;
+    std::map<std::array<int, 4>, int> samplers;
+    std::map<std::pair<int, int>, int> textures;
+    std::unordered_multimap<uint64_t, int> materials;
+
+    size_t reusedAccessors = 0;
+    size_t reusedImages = 0;
+    size_t reusedSamplers = 0;
+    size_t reusedTextures = 0;
+    size_t reusedMaterials = 0;
+    size_t skippedBytes = 0;
+
+    void addCounts(const MergeDedupIndex& other) {
+        reusedAccessors += other.reusedAccessors;
+        reusedImages += other.reusedImages;
+        reusedSamplers += other.reusedSamplers;
+        reusedTextures += other.reusedTextures;
+        reusedMaterials += other.reusedMaterials;
+        skippedBytes += other.skippedBytes;
+    }
+};
+
 GltfMerger::GltfMerger() = default;
 
-GltfMerger::~GltfMerger() = default;
+GltfMerger::~GltfMerger() {
+    closeSpill();
+}
 
 bool GltfMerger::loadAndMergeFile(const std::string& filename,
                                   bool keepScenesIndependent,
                                   bool defaultScenesOnly) {
+    TraceScope fileScope("merge", filename.substr(filename.find_last_of("/\\") + 1));
+
     tinygltf::Model model;
-    std::string err;
     std::string warn;
-
-    const bool isGlb = hasGlbExtension(filename);
-    bool ok = false;
-    if (isGlb) {
-        ok = loader_.LoadBinaryFromFile(&model, &err, &warn, filename);
-    } else {
-        ok = loader_.LoadASCIIFromFile(&model, &err, &warn, filename);
-    }
+    const bool ok = loadModel(loader_, filename, model, errorMsg_, warn);
 
     if (!warn.empty()) {
         std::cerr << "Warning loading " << filename << ": " << warn << std::endl;
     }
 
-    if (!ok || !err.empty()) {
-        errorMsg_ = err.empty() ? ("Failed to load " + filename)
-                                : ("Error loading " + filename + ": " + err);
+    if (!ok) {
         return false;
     }
 
-    for (auto& buffer : model.buffers) {
-        buffer.uri.clear();
+    return mergeModelStreaming(std::move(model), keepScenesIndependent, defaultScenesOnly);
+}
+
+bool GltfMerger::mergeFiles(const std::vector<std::string>& filenames,
+                            const MergeOptions& options,
+                            const std::function<void(size_t)>& onMerge) {
+    size_t jobs = options.jobs > 0 ? static_cast<size_t>(options.jobs)
+                                   : std::max(1u, std::thread::hardware_concurrency());
+    jobs = std::min(jobs, filenames.size());
+
+    if (options.dedup && !dedup_) {
+        dedup_ = std::make_unique<MergeDedupIndex>();
     }
 
-    return mergeModelStreaming(std::move(model), keepScenesIndependent, defaultScenesOnly);
+    if (options.tree) {
+        if (!options.spillDirectory.empty()) {
+            errorMsg_ = "Tree merge does not support spilling to disk";
+            return false;
+        }
+        return mergeTree(filenames, options, std::max<size_t>(jobs, 1), onMerge);
+    }
+
+    // Open the spill file first so presize does not reserve buffer bytes that will go to disk
+    if (!options.spillDirectory.empty() && !spillFile_.is_open() && !openSpill(options.spillDirectory)) {
+        return false;
+    }
+
+    if (options.presize && !presize(filenames, jobs)) {
+        return false;
+    }
+
+    if (jobs <= 1) {
+        for (size_t i = 0; i < filenames.size(); ++i) {
+            if (onMerge) {
+                onMerge(i);
+            }
+            if (!loadAndMergeFile(filenames[i], options.keepScenesIndependent, options.defaultScenesOnly)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const size_t window = std::max(jobs, options.prefetch > 0 ? static_cast<size_t>(options.prefetch) : 2 * jobs);
+
+    struct Slot {
+        tinygltf::Model model;
+        std::string error;
+        std::string warning;
+        bool ok = false;
+        bool ready = false;
+    };
+    std::vector<Slot> slots(filenames.size());
+
+    std::mutex mutex;
+    std::condition_variable readyCv;
+    std::condition_variable windowCv;
+    size_t nextToLoad = 0;
+    size_t mergedCount = 0;
+    bool stop = false;
+
+    // Each loader claims the next file once it falls inside the look-ahead window
+    auto loaderMain = [&](size_t threadIdx) {
+        Tracer::setThreadName("loader " + std::to_string(threadIdx));
+        tinygltf::TinyGLTF loader;
+        for (;;) {
+            size_t idx = 0;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                windowCv.wait(lock, [&] {
+                    return stop || nextToLoad >= filenames.size() || nextToLoad < mergedCount + window;
+                });
+                if (stop || nextToLoad >= filenames.size()) {
+                    return;
+                }
+                idx = nextToLoad++;
+            }
+
+            tinygltf::Model model;
+            std::string error;
+            std::string warning;
+            const bool ok = loadModel(loader, filenames[idx], model, error, warning);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                Slot& slot = slots[idx];
+                slot.model = std::move(model);
+                slot.error = std::move(error);
+                slot.warning = std::move(warning);
+                slot.ok = ok;
+                slot.ready = true;
+            }
+            readyCv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> loaders;
+    loaders.reserve(jobs);
+    for (size_t t = 0; t < jobs; ++t) {
+        loaders.emplace_back(loaderMain, t);
+    }
+
+    auto joinLoaders = [&]() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        windowCv.notify_all();
+        for (auto& thread : loaders) {
+            thread.join();
+        }
+    };
+
+    for (size_t i = 0; i < filenames.size(); ++i) {
+        Slot slot;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            readyCv.wait(lock, [&] { return slots[i].ready; });
+            slot = std::move(slots[i]);
+            slots[i] = Slot();
+        }
+
+        if (!slot.warning.empty()) {
+            std::cerr << "Warning loading " << filenames[i] << ": " << slot.warning << std::endl;
+        }
+        if (!slot.ok) {
+            errorMsg_ = slot.error;
+            joinLoaders();
+            return false;
+        }
+
+        if (onMerge) {
+            onMerge(i);
+        }
+
+        bool merged = false;
+        {
+            TraceScope fileScope("merge", filenames[i].substr(filenames[i].find_last_of("/\\") + 1));
+            merged = mergeModelStreaming(std::move(slot.model), options.keepScenesIndependent,
+                                         options.defaultScenesOnly);
+        }
+        if (!merged) {
+            joinLoaders();
+            return false;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            mergedCount = i + 1;
+        }
+        windowCv.notify_all();
+    }
+
+    joinLoaders();
+    return true;
+}
+
+bool GltfMerger::mergeTree(const std::vector<std::string>& filenames,
+                           const MergeOptions& options,
+                           size_t jobs,
+                           const std::function<void(size_t)>& onMerge) {
+    if (filenames.empty()) {
+        return true;
+    }
+
+    // Run task(0..count-1) on up to jobs threads, the calling thread included
+    auto parallelFor = [jobs](size_t count, const std::function<void(size_t)>& task) {
+        std::atomic<size_t> next{0};
+        auto worker = [&]() {
+            for (size_t idx = next++; idx < count; idx = next++) {
+                task(idx);
+            }
+        };
+        std::vector<std::thread> threads;
+        for (size_t t = 1; t < std::min(jobs, count); ++t) {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    };
+
+    // More groups than threads so uneven input sizes still balance
+    const size_t groupCount = std::min(filenames.size(), jobs * 4);
+    std::vector<std::unique_ptr<GltfMerger>> partials(groupCount);
+    std::vector<std::string> errors(groupCount);
+    std::mutex callbackMutex;
+
+    {
+        TraceScope groupsScope("merge", "tree groups");
+        parallelFor(groupCount, [&](size_t group) {
+            const size_t begin = filenames.size() * group / groupCount;
+            const size_t end = filenames.size() * (group + 1) / groupCount;
+            auto partial = std::make_unique<GltfMerger>();
+            if (dedup_) {
+                partial->dedup_ = std::make_unique<MergeDedupIndex>();
+            }
+            for (size_t i = begin; i < end; ++i) {
+                if (onMerge) {
+                    std::lock_guard<std::mutex> lock(callbackMutex);
+                    onMerge(i);
+                }
+                if (!partial->loadAndMergeFile(filenames[i], options.keepScenesIndependent,
+                                               options.defaultScenesOnly)) {
+                    errors[group] = partial->getError();
+                    return;
+                }
+            }
+            partials[group] = std::move(partial);
+        });
+    }
+
+    for (const auto& error : errors) {
+        if (!error.empty()) {
+            errorMsg_ = error;
+            return false;
+        }
+    }
+
+    // Partial models already hold only the requested scenes, so combine all of them
+    for (size_t level = 0; partials.size() > 1; ++level) {
+        TraceScope levelScope("merge", "tree level", static_cast<long long>(level));
+        const size_t pairs = partials.size() / 2;
+        std::vector<std::string> pairErrors(pairs);
+        parallelFor(pairs, [&](size_t pair) {
+            GltfMerger& left = *partials[2 * pair];
+            GltfMerger& right = *partials[2 * pair + 1];
+            if (!left.mergeModelStreaming(std::move(right.mergedModel_), options.keepScenesIndependent, false)) {
+                pairErrors[pair] = left.getError();
+                return;
+            }
+            if (left.dedup_) {
+                left.dedup_->addCounts(*right.dedup_);
+            }
+            right.clear();
+        });
+
+        for (const auto& error : pairErrors) {
+            if (!error.empty()) {
+                errorMsg_ = error;
+                return false;
+            }
+        }
+
+        std::vector<std::unique_ptr<GltfMerger>> next;
+        next.reserve(pairs + 1);
+        for (size_t idx = 0; idx < partials.size(); idx += 2) {
+            next.push_back(std::move(partials[idx]));
+        }
+        partials = std::move(next);
+    }
+
+    GltfMerger& result = *partials[0];
+    if (firstModel_) {
+        mergedModel_ = std::move(result.mergedModel_);
+        dedup_ = std::move(result.dedup_);
+        firstModel_ = false;
+        return true;
+    }
+    if (!mergeModelStreaming(std::move(result.mergedModel_), options.keepScenesIndependent, false)) {
+        return false;
+    }
+    if (dedup_) {
+        dedup_->addCounts(*result.dedup_);
+    }
+    return true;
+}
+
+bool GltfMerger::presize(const std::vector<std::string>& filenames, size_t jobs) {
+    TraceScope scanScope("merge", "presize");
+
+    std::vector<MergeCounts> counts(filenames.size());
+    std::vector<std::string> errors(filenames.size());
+    std::atomic<size_t> next{0};
+    auto scanMain = [&]() {
+        for (size_t idx = next++; idx < filenames.size(); idx = next++) {
+            scanInput(filenames[idx], counts[idx], errors[idx]);
+        }
+    };
+
+    std::vector<std::thread> scanners;
+    for (size_t t = 1; t < jobs; ++t) {
+        scanners.emplace_back(scanMain);
+    }
+    scanMain();
+    for (auto& thread : scanners) {
+        thread.join();
+    }
+
+    MergeCounts totals;
+    for (size_t idx = 0; idx < filenames.size(); ++idx) {
+        if (!errors[idx].empty()) {
+            errorMsg_ = errors[idx];
+            return false;
+        }
+        totals.nodes += counts[idx].nodes;
+        totals.meshes += counts[idx].meshes;
+        totals.materials += counts[idx].materials;
+        totals.textures += counts[idx].textures;
+        totals.images += counts[idx].images;
+        totals.samplers += counts[idx].samplers;
+        totals.accessors += counts[idx].accessors;
+        totals.bufferViews += counts[idx].bufferViews;
+        totals.animations += counts[idx].animations;
+        totals.skins += counts[idx].skins;
+        totals.cameras += counts[idx].cameras;
+        totals.bufferBytes += counts[idx].bufferBytes;
+    }
+
+    if (mergedModel_.buffers.empty()) {
+        mergedModel_.buffers.emplace_back();
+        mergedModel_.buffers.back().name = "merged_buffer";
+    }
+    if (!spillFile_.is_open()) {
+        auto& data = mergedModel_.buffers[0].data;
+        data.reserve(align4(data.size()) + totals.bufferBytes);
+    }
+    mergedModel_.nodes.reserve(mergedModel_.nodes.size() + totals.nodes);
+    mergedModel_.meshes.reserve(mergedModel_.meshes.size() + totals.meshes);
+    mergedModel_.materials.reserve(mergedModel_.materials.size() + totals.materials);
+    mergedModel_.textures.reserve(mergedModel_.textures.size() + totals.textures);
+    mergedModel_.images.reserve(mergedModel_.images.size() + totals.images);
+    mergedModel_.samplers.reserve(mergedModel_.samplers.size() + totals.samplers);
+    mergedModel_.accessors.reserve(mergedModel_.accessors.size() + totals.accessors);
+    mergedModel_.bufferViews.reserve(mergedModel_.bufferViews.size() + totals.bufferViews);
+    mergedModel_.animations.reserve(mergedModel_.animations.size() + totals.animations);
+    mergedModel_.skins.reserve(mergedModel_.skins.size() + totals.skins);
+    mergedModel_.cameras.reserve(mergedModel_.cameras.size() + totals.cameras);
+    return true;
+}
+
+bool GltfMerger::openSpill(const std::string& directory) {
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+    const fs::path path = fs::path(directory) / ("gltfu-merge-" + std::to_string(std::random_device{}()) + ".bin");
+    spillFile_.open(path, std::ios::binary | std::ios::trunc);
+    if (!spillFile_) {
+        errorMsg_ = "Failed to create spill file: " + path.string();
+        return false;
+    }
+    spillPath_ = path.string();
+    spillSize_ = 0;
+
+    // Data merged before spilling was enabled moves to the file as well
+    // and its capacity is released even when empty (a reservation alone can be large)
+    if (!mergedModel_.buffers.empty()) {
+        auto& data = mergedModel_.buffers[0].data;
+        if (!data.empty()) {
+            spillFile_.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+            spillSize_ = data.size();
+        }
+        std::vector<unsigned char>().swap(data);
+    }
+    return true;
+}
+
+void GltfMerger::closeSpill() {
+    if (spillPath_.empty()) {
+        return;
+    }
+    spillFile_.close();
+    std::error_code ec;
+    fs::remove(spillPath_, ec);
+    spillPath_.clear();
+    spillSize_ = 0;
 }
 
 bool GltfMerger::mergeModelStreaming(tinygltf::Model&& model,
@@ -293,8 +979,10 @@ bool GltfMerger::mergeModelStreaming(tinygltf::Model&& model,
         mergedModel_.asset = model.asset;
         mergedModel_.extensionsUsed = model.extensionsUsed;
         mergedModel_.extensionsRequired = model.extensionsRequired;
-        mergedModel_.buffers.emplace_back();
-        mergedModel_.buffers.back().name = "merged_buffer";
+        if (mergedModel_.buffers.empty()) {
+            mergedModel_.buffers.emplace_back();
+            mergedModel_.buffers.back().name = "merged_buffer";
+        }
         firstModel_ = false;
     } else {
         mergedModel_.extensionsUsed.insert(mergedModel_.extensionsUsed.end(),
@@ -305,6 +993,10 @@ bool GltfMerger::mergeModelStreaming(tinygltf::Model&& model,
                                                model.extensionsRequired.end());
     }
 
+    if (dedup_) {
+        return mergeDeduplicated(std::move(model), keepScenesIndependent, defaultScenesOnly);
+    }
+
     MergeOffsets offsets;
     offsets.nodes = static_cast<int>(mergedModel_.nodes.size());
     offsets.meshes = static_cast<int>(mergedModel_.meshes.size());
@@ -329,29 +1021,51 @@ bool GltfMerger::mergeModelStreaming(tinygltf::Model&& model,
     counts.animations = model.animations.size();
     counts.skins = model.skins.size();
 
-    const size_t currentBufferSize = mergedModel_.buffers[0].data.size();
+    auto& mergedData = mergedModel_.buffers[0].data;
+    const bool spilling = spillFile_.is_open();
+    const size_t currentBufferSize = align4(spilling ? spillSize_ : mergedData.size());
     const auto bufferOffsets = computeBufferOffsets(model.buffers);
     size_t appendedBytes = bufferOffsets.empty()
                                ? 0
                                : bufferOffsets.back() + model.buffers.back().data.size();
-    mergedModel_.buffers[0].data.reserve(currentBufferSize + appendedBytes);
-    for (auto& buffer : model.buffers) {
-        mergedModel_.buffers[0].data.insert(mergedModel_.buffers[0].data.end(),
-                                            std::make_move_iterator(buffer.data.begin()),
-                                            std::make_move_iterator(buffer.data.end()));
-    }
-
-    mergedModel_.bufferViews.reserve(mergedModel_.bufferViews.size() + model.bufferViews.size());
-    mergedModel_.accessors.reserve(mergedModel_.accessors.size() + model.accessors.size());
-    mergedModel_.samplers.reserve(mergedModel_.samplers.size() + model.samplers.size());
-    mergedModel_.images.reserve(mergedModel_.images.size() + model.images.size());
-    mergedModel_.textures.reserve(mergedModel_.textures.size() + model.textures.size());
-    mergedModel_.materials.reserve(mergedModel_.materials.size() + model.materials.size());
-    mergedModel_.meshes.reserve(mergedModel_.meshes.size() + model.meshes.size());
-    mergedModel_.skins.reserve(mergedModel_.skins.size() + model.skins.size());
-    mergedModel_.cameras.reserve(mergedModel_.cameras.size() + model.cameras.size());
-    mergedModel_.nodes.reserve(mergedModel_.nodes.size() + model.nodes.size());
-    mergedModel_.animations.reserve(mergedModel_.animations.size() + model.animations.size());
+    if (spilling) {
+        TraceScope spillScope("merge", "spill");
+        static const char padding[4] = {};
+        for (size_t idx = 0; idx < model.buffers.size(); ++idx) {
+            auto& buffer = model.buffers[idx];
+            const size_t start = currentBufferSize + bufferOffsets[idx];
+            spillFile_.write(padding, static_cast<std::streamsize>(start - spillSize_));
+            spillFile_.write(reinterpret_cast<const char*>(buffer.data.data()),
+                             static_cast<std::streamsize>(buffer.data.size()));
+            spillSize_ = start + buffer.data.size();
+            std::vector<unsigned char>().swap(buffer.data);
+        }
+        if (!spillFile_.flush()) {
+            errorMsg_ = "Failed to write spill file: " + spillPath_;
+            return false;
+        }
+    } else {
+        reserveAppend(mergedData, currentBufferSize + appendedBytes - mergedData.size());
+        for (size_t idx = 0; idx < model.buffers.size(); ++idx) {
+            auto& buffer = model.buffers[idx];
+            mergedData.resize(currentBufferSize + bufferOffsets[idx]);
+            mergedData.insert(mergedData.end(),
+                              std::make_move_iterator(buffer.data.begin()),
+                              std::make_move_iterator(buffer.data.end()));
+        }
+    }
+
+    reserveAppend(mergedModel_.bufferViews, model.bufferViews.size());
+    reserveAppend(mergedModel_.accessors, model.accessors.size());
+    reserveAppend(mergedModel_.samplers, model.samplers.size());
+    reserveAppend(mergedModel_.images, model.images.size());
+    reserveAppend(mergedModel_.textures, model.textures.size());
+    reserveAppend(mergedModel_.materials, model.materials.size());
+    reserveAppend(mergedModel_.meshes, model.meshes.size());
+    reserveAppend(mergedModel_.skins, model.skins.size());
+    reserveAppend(mergedModel_.cameras, model.cameras.size());
+    reserveAppend(mergedModel_.nodes, model.nodes.size());
+    reserveAppend(mergedModel_.animations, model.animations.size());
 
     for (size_t idx = 0; idx < model.bufferViews.size(); ++idx) {
         auto view = model.bufferViews[idx];
@@ -398,20 +1112,288 @@ bool GltfMerger::mergeModelStreaming(tinygltf::Model&& model,
 
     applyOffsets(mergedModel_, offsets, counts);
 
+    appendScenes(model, offsets.nodes, keepScenesIndependent, defaultScenesOnly);
+    return true;
+}
+
+bool GltfMerger::mergeDeduplicated(tinygltf::Model&& model,
+                                   bool keepScenesIndependent,
+                                   bool defaultScenesOnly) {
+    TraceScope dedupScope("merge", "dedup");
+    MergeDedupIndex& index = *dedup_;
+    XXH3_state_t* state = XXH3_createState();
+
+    const int nodeOffset = static_cast<int>(mergedModel_.nodes.size());
+    const int meshOffset = static_cast<int>(mergedModel_.meshes.size());
+    const int skinOffset = static_cast<int>(mergedModel_.skins.size());
+    const int cameraOffset = static_cast<int>(mergedModel_.cameras.size());
+
+    // Samplers, images, textures and materials: reuse a merged entry or append a new one
+    std::vector<int> samplerRemap(model.samplers.size());
+    for (size_t idx = 0; idx < model.samplers.size(); ++idx) {
+        const auto& sampler = model.samplers[idx];
+        const std::array<int, 4> key = {sampler.magFilter, sampler.minFilter, sampler.wrapS, sampler.wrapT};
+        const auto found = index.samplers.find(key);
+        if (found != index.samplers.end() && sampler.extensions.empty()) {
+            samplerRemap[idx] = found->second;
+            ++index.reusedSamplers;
+            continue;
+        }
+        samplerRemap[idx] = static_cast<int>(mergedModel_.samplers.size());
+        if (sampler.extensions.empty()) {
+            index.samplers.emplace(key, samplerRemap[idx]);
+        }
+        mergedModel_.samplers.push_back(std::move(model.samplers[idx]));
+    }
+
+    // Images are appended after the bufferViews, so only their indices are assigned here
+    std::vector<int> imageRemap(model.images.size());
+    std::vector<size_t> newImages;
+    for (size_t idx = 0; idx < model.images.size(); ++idx) {
+        const ContentKey key = imageKey(model, model.images[idx], state);
+        const int next = static_cast<int>(mergedModel_.images.size() + newImages.size());
+        const auto inserted = index.images.emplace(key, next);
+        if (!inserted.second) {
+            imageRemap[idx] = inserted.first->second;
+            ++index.reusedImages;
+            continue;
+        }
+        imageRemap[idx] = next;
+        newImages.push_back(idx);
+    }
+
+    std::vector<int> textureRemap(model.textures.size());
+    for (size_t idx = 0; idx < model.textures.size(); ++idx) {
+        auto& texture = model.textures[idx];
+        remapIndex(imageRemap, texture.source);
+        remapIndex(samplerRemap, texture.sampler);
+        const std::pair<int, int> key(texture.source, texture.sampler);
+        const auto found = index.textures.find(key);
+        if (found != index.textures.end() && texture.extensions.empty()) {
+            textureRemap[idx] = found->second;
+            ++index.reusedTextures;
+            continue;
+        }
+        textureRemap[idx] = static_cast<int>(mergedModel_.textures.size());
+        if (texture.extensions.empty()) {
+            index.textures.emplace(key, textureRemap[idx]);
+        }
+        mergedModel_.textures.push_back(std::move(texture));
+    }
+
+    std::vector<int> materialRemap(model.materials.size());
+    for (size_t idx = 0; idx < model.materials.size(); ++idx) {
+        auto& material = model.materials[idx];
+        remapIndex(textureRemap, material.pbrMetallicRoughness.baseColorTexture.index);
+        remapIndex(textureRemap, material.pbrMetallicRoughness.metallicRoughnessTexture.index);
+        remapIndex(textureRemap, material.normalTexture.index);
+        remapIndex(textureRemap, material.occlusionTexture.index);
+        remapIndex(textureRemap, material.emissiveTexture.index);
+
+        const uint64_t bucket = materialBucket(material);
+        int match = -1;
+        const auto candidates = index.materials.equal_range(bucket);
+        for (auto it = candidates.first; it != candidates.second && match < 0; ++it) {
+            tinygltf::Material probe = material;
+            probe.name = mergedModel_.materials[it->second].name;
+            if (probe == mergedModel_.materials[it->second]) {
+                match = it->second;
+            }
+        }
+        if (match >= 0) {
+            materialRemap[idx] = match;
+            ++index.reusedMaterials;
+            continue;
+        }
+        materialRemap[idx] = static_cast<int>(mergedModel_.materials.size());
+        index.materials.emplace(bucket, materialRemap[idx]);
+        mergedModel_.materials.push_back(std::move(material));
+    }
+
+    // Accessors: bufferViews are only kept for accessors, images and extensions that are not duplicates
+    std::vector<char> viewNeeded(model.bufferViews.size(), 0);
+    auto markView = [&viewNeeded](int viewIdx) {
+        if (viewIdx >= 0 && viewIdx < static_cast<int>(viewNeeded.size())) {
+            viewNeeded[viewIdx] = 1;
+        }
+    };
+
+    std::vector<int> accessorRemap(model.accessors.size());
+    std::vector<size_t> newAccessors;
+    for (size_t idx = 0; idx < model.accessors.size(); ++idx) {
+        const auto& accessor = model.accessors[idx];
+        const int next = static_cast<int>(mergedModel_.accessors.size() + newAccessors.size());
+        ContentKey key;
+        if (accessorKey(model, accessor, state, key)) {
+            const auto inserted = index.accessors.emplace(key, next);
+            if (!inserted.second) {
+                accessorRemap[idx] = inserted.first->second;
+                ++index.reusedAccessors;
+                continue;
+            }
+        }
+        accessorRemap[idx] = next;
+        newAccessors.push_back(idx);
+        markView(accessor.bufferView);
+        if (accessor.sparse.isSparse) {
+            markView(accessor.sparse.indices.bufferView);
+            markView(accessor.sparse.values.bufferView);
+        }
+    }
+    XXH3_freeState(state);
+
+    for (const size_t idx : newImages) {
+        markView(model.images[idx].bufferView);
+    }
+    visitExtensionBufferViews(model, [&markView](int& viewIdx) { markView(viewIdx); });
+
+    // Append the bytes of the surviving bufferViews only
+    std::vector<int> viewRemap(model.bufferViews.size(), -1);
+    for (size_t idx = 0; idx < model.bufferViews.size(); ++idx) {
+        auto& view = model.bufferViews[idx];
+        if (!viewNeeded[idx]) {
+            index.skippedBytes += view.byteLength;
+            continue;
+        }
+        const unsigned char* bytes = viewBytes(model, static_cast<int>(idx));
+        viewRemap[idx] = static_cast<int>(mergedModel_.bufferViews.size());
+        view.buffer = 0;
+        view.byteOffset = appendBinary(bytes, bytes ? view.byteLength : 0);
+        mergedModel_.bufferViews.push_back(std::move(view));
+    }
+    if (spillFile_.is_open() && !spillFile_.flush()) {
+        errorMsg_ = "Failed to write spill file: " + spillPath_;
+        return false;
+    }
+    for (auto& buffer : model.buffers) {
+        std::vector<unsigned char>().swap(buffer.data);
+    }
+
+    for (const size_t idx : newImages) {
+        auto& image = model.images[idx];
+        remapIndex(viewRemap, image.bufferView);
+        mergedModel_.images.push_back(std::move(image));
+    }
+
+    for (const size_t idx : newAccessors) {
+        auto& accessor = model.accessors[idx];
+        remapIndex(viewRemap, accessor.bufferView);
+        if (accessor.sparse.isSparse) {
+            remapIndex(viewRemap, accessor.sparse.indices.bufferView);
+            remapIndex(viewRemap, accessor.sparse.values.bufferView);
+        }
+        mergedModel_.accessors.push_back(std::move(accessor));
+    }
+
+    // Everything else is appended with its references rewritten
+    visitExtensionBufferViews(model, [&viewRemap](int& viewIdx) { remapIndex(viewRemap, viewIdx); });
+
+    reserveAppend(mergedModel_.meshes, model.meshes.size());
+    for (auto& mesh : model.meshes) {
+        for (auto& primitive : mesh.primitives) {
+            remapIndex(materialRemap, primitive.material);
+            remapIndex(accessorRemap, primitive.indices);
+            for (auto& attribute : primitive.attributes) {
+                remapIndex(accessorRemap, attribute.second);
+            }
+            for (auto& target : primitive.targets) {
+                for (auto& attribute : target) {
+                    remapIndex(accessorRemap, attribute.second);
+                }
+            }
+        }
+        mergedModel_.meshes.push_back(std::move(mesh));
+    }
+
+    reserveAppend(mergedModel_.skins, model.skins.size());
+    for (auto& skin : model.skins) {
+        remapIndex(accessorRemap, skin.inverseBindMatrices);
+        if (skin.skeleton >= 0) {
+            skin.skeleton += nodeOffset;
+        }
+        for (int& joint : skin.joints) {
+            joint += nodeOffset;
+        }
+        mergedModel_.skins.push_back(std::move(skin));
+    }
+
+    mergedModel_.cameras.insert(mergedModel_.cameras.end(),
+                                std::make_move_iterator(model.cameras.begin()),
+                                std::make_move_iterator(model.cameras.end()));
+
+    reserveAppend(mergedModel_.nodes, model.nodes.size());
+    for (auto& node : model.nodes) {
+        for (int& child : node.children) {
+            child += nodeOffset;
+        }
+        if (node.mesh >= 0) {
+            node.mesh += meshOffset;
+        }
+        if (node.skin >= 0) {
+            node.skin += skinOffset;
+        }
+        if (node.camera >= 0) {
+            node.camera += cameraOffset;
+        }
+        mergedModel_.nodes.push_back(std::move(node));
+    }
+
+    reserveAppend(mergedModel_.animations, model.animations.size());
+    for (auto& animation : model.animations) {
+        for (auto& sampler : animation.samplers) {
+            remapIndex(accessorRemap, sampler.input);
+            remapIndex(accessorRemap, sampler.output);
+        }
+        for (auto& channel : animation.channels) {
+            if (channel.target_node >= 0) {
+                channel.target_node += nodeOffset;
+            }
+        }
+        mergedModel_.animations.push_back(std::move(animation));
+    }
+
+    appendScenes(model, nodeOffset, keepScenesIndependent, defaultScenesOnly);
+    return true;
+}
+
+size_t GltfMerger::appendBinary(const unsigned char* data, size_t size) {
+    if (spillFile_.is_open()) {
+        static const char padding[4] = {};
+        const size_t offset = align4(spillSize_);
+        spillFile_.write(padding, static_cast<std::streamsize>(offset - spillSize_));
+        spillFile_.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+        spillSize_ = offset + size;
+        return offset;
+    }
+
+    auto& buffer = mergedModel_.buffers[0].data;
+    const size_t offset = align4(buffer.size());
+    reserveAppend(buffer, offset + size - buffer.size());
+    buffer.resize(offset);
+    if (size > 0) {
+        buffer.insert(buffer.end(), data, data + size);
+    }
+    return offset;
+}
+
+void GltfMerger::appendScenes(const tinygltf::Model& model,
+                              int nodeOffset,
+                              bool keepScenesIndependent,
+                              bool defaultScenesOnly) {
     if (keepScenesIndependent) {
         if (defaultScenesOnly) {
             const int sceneIdx = model.defaultScene >= 0 ? model.defaultScene : 0;
             if (sceneIdx >= 0 && sceneIdx < static_cast<int>(model.scenes.size())) {
                 auto scene = model.scenes[sceneIdx];
                 for (int& node : scene.nodes) {
-                    node += offsets.nodes;
+                    node += nodeOffset;
                 }
                 mergedModel_.scenes.push_back(std::move(scene));
             }
         } else {
             for (auto scene : model.scenes) {
                 for (int& node : scene.nodes) {
-                    node += offsets.nodes;
+                    node += nodeOffset;
                 }
                 mergedModel_.scenes.push_back(std::move(scene));
             }
@@ -433,19 +1415,18 @@ bool GltfMerger::mergeModelStreaming(tinygltf::Model&& model,
             if (sceneIdx >= 0 && sceneIdx < static_cast<int>(model.scenes.size())) {
                 const auto& scene = model.scenes[sceneIdx];
                 for (const int node : scene.nodes) {
-                    mergedModel_.scenes[0].nodes.push_back(node + offsets.nodes);
+                    mergedModel_.scenes[0].nodes.push_back(node + nodeOffset);
                 }
             }
         } else {
             for (const auto& scene : model.scenes) {
                 for (const int node : scene.nodes) {
-                    mergedModel_.scenes[0].nodes.push_back(node + offsets.nodes);
+                    mergedModel_.scenes[0].nodes.push_back(node + nodeOffset);
                 }
             }
         }
     }
 
-    return true;
 }
 
 bool GltfMerger::save(const std::string& filename,
@@ -458,6 +1439,10 @@ bool GltfMerger::save(const std::string& filename,
         return false;
     }
 
+    if (spillFile_.is_open()) {
+        return saveSpilled(filename, embedImages, embedBuffers, prettyPrint, writeBinary);
+    }
+
     if (writeBinary) {
         for (auto& buffer : mergedModel_.buffers) {
             buffer.uri.clear();
@@ -487,11 +1472,128 @@ bool GltfMerger::save(const std::string& filename,
     return true;
 }
 
+bool GltfMerger::saveSpilled(const std::string& filename,
+                             bool embedImages,
+                             bool embedBuffers,
+                             bool prettyPrint,
+                             bool writeBinary) {
+    TraceScope saveScope("merge", "save spilled");
+
+    // Embedding would pull the whole spill file back into memory as base64
+    if (embedBuffers && !writeBinary) {
+        errorMsg_ = "Embedded buffers are not supported with a spill directory; write .glb or an external .bin";
+        return false;
+    }
+
+    // Write the JSON as save() would, so images stay external unless embedImages;
+    // buffer 0 is empty while spilled and is pointed at the spilled bytes below
+    if (!loader_.WriteGltfSceneToFile(&mergedModel_, filename, embedImages, true, false, false)) {
+        errorMsg_ = "Failed to write file: " + filename;
+        return false;
+    }
+    nlohmann::json document;
+    {
+        std::ifstream written(filename, std::ios::binary);
+        document = nlohmann::json::parse(written, nullptr, false);
+    }
+    if (document.is_discarded() || !document.is_object()) {
+        errorMsg_ = "Failed to serialize merged model";
+        return false;
+    }
+
+    const fs::path outputPath(filename);
+    fs::path binPath = outputPath;
+    binPath.replace_extension(".bin");
+    if (spillSize_ > 0) {
+        nlohmann::json buffer = {{"byteLength", spillSize_}};
+        if (!mergedModel_.buffers[0].name.empty()) {
+            buffer["name"] = mergedModel_.buffers[0].name;
+        }
+        if (!writeBinary) {
+            buffer["uri"] = binPath.filename().string();
+        }
+        document["buffers"] = nlohmann::json::array({buffer});
+    } else {
+        document.erase("buffers");
+    }
+
+    std::ifstream spill(spillPath_, std::ios::binary);
+    if (!spill) {
+        errorMsg_ = "Failed to read spill file: " + spillPath_;
+        return false;
+    }
+
+    if (!writeBinary) {
+        std::ofstream json(outputPath, std::ios::binary | std::ios::trunc);
+        json << document.dump(prettyPrint ? 2 : -1);
+        if (!json) {
+            errorMsg_ = "Failed to write file: " + filename;
+            return false;
+        }
+        if (spillSize_ > 0) {
+            std::ofstream bin(binPath, std::ios::binary | std::ios::trunc);
+            bin << spill.rdbuf();
+            if (!bin) {
+                errorMsg_ = "Failed to write file: " + binPath.string();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // GLB: header, JSON chunk padded with spaces, BIN chunk copied from the spill file
+    std::string text = document.dump();
+    text.resize(align4(text.size()), ' ');
+    const size_t binLength = align4(spillSize_);
+    const size_t totalLength = 12 + 8 + text.size() + (spillSize_ > 0 ? 8 + binLength : 0);
+    if (totalLength > std::numeric_limits<uint32_t>::max()) {
+        errorMsg_ = "Merged model exceeds the 4 GiB GLB limit; write .gltf instead";
+        return false;
+    }
+
+    std::ofstream out(outputPath, std::ios::binary | std::ios::trunc);
+    writeUint32(out, 0x46546C67u);
+    writeUint32(out, 2);
+    writeUint32(out, static_cast<uint32_t>(totalLength));
+    writeUint32(out, static_cast<uint32_t>(text.size()));
+    writeUint32(out, 0x4E4F534Au);
+    out.write(text.data(), static_cast<std::streamsize>(text.size()));
+    if (spillSize_ > 0) {
+        static const char padding[4] = {};
+        writeUint32(out, static_cast<uint32_t>(binLength));
+        writeUint32(out, 0x004E4942u);
+        out << spill.rdbuf();
+        out.write(padding, static_cast<std::streamsize>(binLength - spillSize_));
+    }
+    if (!out) {
+        errorMsg_ = "Failed to write file: " + filename;
+        return false;
+    }
+    return true;
+}
+
 tinygltf::Model GltfMerger::getMergedModel() const {
-    return mergedModel_;
+    tinygltf::Model model = mergedModel_;
+    if (!spillPath_.empty() && !readSpill(spillPath_, spillSize_, model.buffers[0].data)) {
+        std::cerr << "Failed to map spill file: " << spillPath_ << std::endl;
+    }
+    return model;
+}
+
+std::string GltfMerger::getStats() const {
+    if (!dedup_) {
+        return "";
+    }
+    std::ostringstream stream;
+    stream << "Merge dedup: reused " << dedup_->reusedAccessors << " accessors, " << dedup_->reusedImages
+           << " images, " << dedup_->reusedSamplers << " samplers, " << dedup_->reusedTextures << " textures, "
+           << dedup_->reusedMaterials << " materials (" << dedup_->skippedBytes << " bytes not appended)";
+    return stream.str();
 }
 
 void GltfMerger::clear() {
+    closeSpill();
+    dedup_.reset();
     mergedModel_ = tinygltf::Model();
     loader_ = tinygltf::TinyGLTF();
     firstModel_ = true;
@@ -2,10 +2,31 @@
 #define GLTF_MERGER_H
 
 #include "tiny_gltf.h"
+#include <cstddef>
+#include <fstream>
+#include <functional>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace gltfu {
 
+/**
+ * @brief Options for merging a list of files
+ */
+struct MergeOptions {
+    bool keepScenesIndependent = false; // Keep scenes separate instead of merging into one
+    bool defaultScenesOnly = false;     // Merge only the default scene of each file
+    int jobs = 0;                       // Loader threads (0 = hardware concurrency, 1 = serial)
+    int prefetch = 0;                   // Parsed inputs held ahead of the merge (0 = 2 x jobs)
+    bool presize = false;               // Scan every input's header first and allocate the merged model once
+    std::string spillDirectory;         // Non-empty: append binary data to a temporary file here instead of memory
+    bool tree = false;                  // Merge groups of inputs in parallel, then combine them pairwise
+    bool dedup = false;                 // Reuse identical accessors, images, samplers, textures and materials
+};
+
+struct MergeDedupIndex;
+
 /**
  * @brief GLTF Merger - Combines multiple GLTF files and scenes into one
  * 
@@ -29,6 +50,53 @@ public:
      */
     bool loadAndMergeFile(const std::string& filename, bool keepScenesIndependent = false, bool defaultScenesOnly = false);
 
+    /**
+     * @brief Load and merge a list of files, parsing upcoming inputs on loader threads
+     *
+     * Loader threads parse at most options.prefetch files ahead of the merge,
+     * which bounds the number of parsed models held in memory. Models are
+     * merged on the calling thread in input order, so the result is identical
+     * to calling loadAndMergeFile for each file in turn.
+     *
+     * With options.presize, every input's JSON (or GLB JSON chunk) is scanned
+     * first to total its elements and buffer bytes, so the merged arrays and
+     * buffer are allocated once instead of regrowing while merging. When
+     * spilling, only the arrays are reserved; buffer bytes go to the file.
+     *
+     * With options.spillDirectory, binary data is appended to a temporary
+     * file in that directory as each input is merged, and only the JSON-level
+     * structures stay in memory. save() then streams the file into the output
+     * and getMergedModel() maps it back in. Images are written as without
+     * spilling; embedded buffers need .glb output, since a .gltf would have to
+     * hold the spilled bytes as base64.
+     *
+     * With options.tree, contiguous groups of inputs are merged into
+     * intermediate models on options.jobs threads, and neighbouring models
+     * are then combined pairwise, also in parallel, until one remains. Each
+     * element's offsets are fixed up once per level instead of the whole
+     * list being folded on one thread; the result is still identical to the
+     * serial merge. presize is ignored and spillDirectory is not supported
+     * in this mode.
+     *
+     * With options.dedup, the merger keeps content-hash indices of the
+     * accessors, images, samplers, textures and materials merged so far.
+     * Later duplicates are mapped to the existing entries, and bufferViews
+     * left without a user are never appended, so repeated library assets cost
+     * memory once. Accessor and image data are identified by a 128-bit hash
+     * of their bytes; materials are compared field by field. Names are not
+     * part of the identity.
+     *
+     * @param filenames Paths to the GLTF files, in merge order
+     * @param options Merge options
+     * @param onMerge Called before each file is merged, with its index; on the calling
+     *                thread, except in tree mode where calls come from worker threads,
+     *                one at a time and out of order
+     * @return true if successful, false otherwise
+     */
+    bool mergeFiles(const std::vector<std::string>& filenames,
+                    const MergeOptions& options = MergeOptions(),
+                    const std::function<void(size_t)>& onMerge = nullptr);
+
     /**
      * @brief Save the merged model to a file
      * @param filename Output filename
@@ -50,8 +118,17 @@ public:
      */
     std::string getError() const { return errorMsg_; }
 
+    /**
+     * @brief Get a summary of what dedup-aware merging reused
+     * @return Stats string, empty unless options.dedup was set
+     */
+    std::string getStats() const;
+
     /**
      * @brief Get a copy of the merged model for further processing
+     *
+     * Spilled binary data is mapped back into the copy's buffer.
+     *
      * @return Copy of the merged model
      */
     tinygltf::Model getMergedModel() const;
@@ -62,13 +139,32 @@ public:
     void clear();
 
 private:
+    bool presize(const std::vector<std::string>& filenames, size_t jobs);
+    bool mergeTree(const std::vector<std::string>& filenames, const MergeOptions& options, size_t jobs,
+                   const std::function<void(size_t)>& onMerge);
+    bool openSpill(const std::string& directory);
+    void closeSpill();
+    bool saveSpilled(const std::string& filename, bool embedImages, bool embedBuffers, bool prettyPrint,
+                     bool writeBinary);
     bool mergeModelStreaming(tinygltf::Model&& model,
                              bool keepScenesIndependent,
                              bool defaultScenesOnly);
+    bool mergeDeduplicated(tinygltf::Model&& model,
+                           bool keepScenesIndependent,
+                           bool defaultScenesOnly);
+    void appendScenes(const tinygltf::Model& model,
+                      int nodeOffset,
+                      bool keepScenesIndependent,
+                      bool defaultScenesOnly);
+    size_t appendBinary(const unsigned char* data, size_t size);
 
     tinygltf::Model mergedModel_;
     tinygltf::TinyGLTF loader_;
     bool firstModel_ = true;
+    std::string spillPath_;
+    std::ofstream spillFile_;
+    size_t spillSize_ = 0;
+    std::unique_ptr<MergeDedupIndex> dedup_;
     std::string errorMsg_;
 };
 
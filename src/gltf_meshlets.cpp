@@ -0,0 +1,260 @@
+#include "gltf_meshlets.h"
+#include "buffer_arena.h"
+#include "meshoptimizer.h"
+#include "trace.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace gltfu {
+namespace {
+
+// GPU-friendly bounds record: 12 floats so every record starts on a 16-byte boundary
+struct MeshletBounds {
+    float center[3];
+    float radius;
+    float coneApex[3];
+    float coneAxis[3];
+    float coneCutoff;
+    float padding;
+};
+
+bool containsExtension(const std::vector<std::string>& list, const std::string& value) {
+    return std::find(list.begin(), list.end(), value) != list.end();
+}
+
+const unsigned char* accessorData(const tinygltf::Model& model, const tinygltf::Accessor& accessor,
+                                  size_t elementSize, size_t& stride) {
+    if (accessor.sparse.isSparse || accessor.bufferView < 0 ||
+        accessor.bufferView >= static_cast<int>(model.bufferViews.size())) {
+        return nullptr;
+    }
+    const auto& view = model.bufferViews[accessor.bufferView];
+    if (view.buffer < 0 || view.buffer >= static_cast<int>(model.buffers.size())) {
+        return nullptr;
+    }
+    const auto& data = model.buffers[view.buffer].data;
+    stride = view.byteStride != 0 ? view.byteStride : elementSize;
+    const size_t offset = view.byteOffset + accessor.byteOffset;
+    if (accessor.count == 0 || offset + (accessor.count - 1) * stride + elementSize > data.size()) {
+        return nullptr;
+    }
+    return data.data() + offset;
+}
+
+bool readIndices(const tinygltf::Model& model, int accessorIdx, std::vector<unsigned int>& indices) {
+    if (accessorIdx < 0 || accessorIdx >= static_cast<int>(model.accessors.size())) {
+        return false;
+    }
+    const auto& accessor = model.accessors[accessorIdx];
+    size_t componentBytes = 0;
+    switch (accessor.componentType) {
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: componentBytes = 1; break;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: componentBytes = 2; break;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT: componentBytes = 4; break;
+        default: return false;
+    }
+
+    size_t stride = 0;
+    const unsigned char* src = accessorData(model, accessor, componentBytes, stride);
+    if (!src) {
+        return false;
+    }
+
+    indices.resize(accessor.count);
+    for (size_t i = 0; i < accessor.count; ++i) {
+        const unsigned char* element = src + i * stride;
+        if (componentBytes == 1) {
+            indices[i] = element[0];
+        } else if (componentBytes == 2) {
+            uint16_t value;
+            std::memcpy(&value, element, sizeof(value));
+            indices[i] = value;
+        } else {
+            std::memcpy(&indices[i], element, sizeof(uint32_t));
+        }
+    }
+    return true;
+}
+
+tinygltf::Value bufferViewRef(int bufferView) {
+    tinygltf::Value::Object object;
+    object["bufferView"] = tinygltf::Value(bufferView);
+    return tinygltf::Value(object);
+}
+
+} // namespace
+
+bool GltfMeshlets::process(tinygltf::Model& model, const MeshletOptions& options) {
+    error_.clear();
+    stats_.clear();
+
+    if (options.maxVertices < 3 || options.maxVertices > 255 ||
+        options.maxTriangles < 1 || options.maxTriangles > 512 || options.maxTriangles % 4 != 0) {
+        error_ = "maxVertices must be 3-255 and maxTriangles a multiple of 4 up to 512";
+        return false;
+    }
+
+    size_t processed = 0;
+    size_t skipped = 0;
+    size_t totalMeshlets = 0;
+    size_t totalTriangles = 0;
+    size_t totalBytes = 0;
+
+    // Meshlet arrays are staged and spliced into buffer 0 once at the end
+    BufferArena arena(model);
+
+    for (size_t meshIdx = 0; meshIdx < model.meshes.size(); ++meshIdx) {
+        auto& mesh = model.meshes[meshIdx];
+        for (size_t primIdx = 0; primIdx < mesh.primitives.size(); ++primIdx) {
+            auto& prim = mesh.primitives[primIdx];
+            TraceScope traceScope("meshlets", "primitive", static_cast<long long>(meshIdx),
+                                  static_cast<long long>(primIdx));
+
+            std::string reason;
+            const auto posIt = prim.attributes.find("POSITION");
+            std::vector<unsigned int> indices;
+            const unsigned char* positions = nullptr;
+            size_t positionStride = 0;
+            size_t vertexCount = 0;
+
+            if (prim.mode != TINYGLTF_MODE_TRIANGLES) {
+                reason = "not a triangle list";
+            } else if (prim.extensions.count("KHR_draco_mesh_compression") > 0) {
+                reason = "Draco compressed";
+            } else if (posIt == prim.attributes.end() || posIt->second < 0 ||
+                       posIt->second >= static_cast<int>(model.accessors.size())) {
+                reason = "missing POSITION attribute";
+            } else if (!readIndices(model, prim.indices, indices) || indices.empty() || indices.size() % 3 != 0) {
+                reason = "missing or invalid indices";
+            } else {
+                const auto& posAccessor = model.accessors[posIt->second];
+                if (posAccessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT ||
+                    posAccessor.type != TINYGLTF_TYPE_VEC3) {
+                    reason = "POSITION is not float3";
+                } else {
+                    positions = accessorData(model, posAccessor, 3 * sizeof(float), positionStride);
+                    vertexCount = posAccessor.count;
+                    if (!positions) {
+                        reason = "POSITION data out of range";
+                    } else if (std::any_of(indices.begin(), indices.end(),
+                                           [vertexCount](unsigned int index) { return index >= vertexCount; })) {
+                        reason = "index out of range";
+                    }
+                }
+            }
+
+            if (!reason.empty()) {
+                ++skipped;
+                if (options.verbose) {
+                    std::cout << "[meshlets] Skipped primitive " << meshIdx << ':' << primIdx
+                              << " - " << reason << std::endl;
+                }
+                continue;
+            }
+
+            const auto* vertexPositions = reinterpret_cast<const float*>(positions);
+            const size_t maxMeshlets = meshopt_buildMeshletsBound(indices.size(), options.maxVertices,
+                                                                  options.maxTriangles);
+            std::vector<meshopt_Meshlet> meshlets(maxMeshlets);
+            std::vector<unsigned int> meshletVertices(maxMeshlets * options.maxVertices);
+            std::vector<unsigned char> meshletTriangles(maxMeshlets * options.maxTriangles * 3);
+
+            const size_t meshletCount = meshopt_buildMeshlets(
+                meshlets.data(), meshletVertices.data(), meshletTriangles.data(),
+                indices.data(), indices.size(),
+                vertexPositions, vertexCount, positionStride,
+                options.maxVertices, options.maxTriangles, options.coneWeight);
+            if (meshletCount == 0) {
+                ++skipped;
+                continue;
+            }
+
+            // Trim to the used ranges; triangle arrays are padded to 4 bytes per meshlet
+            const meshopt_Meshlet& last = meshlets[meshletCount - 1];
+            meshlets.resize(meshletCount);
+            meshletVertices.resize(last.vertex_offset + last.vertex_count);
+            meshletTriangles.resize(last.triangle_offset + ((last.triangle_count * 3 + 3) & ~3u));
+
+            std::vector<MeshletBounds> bounds(meshletCount);
+            std::vector<uint32_t> records(meshletCount * 4);
+            for (size_t i = 0; i < meshletCount; ++i) {
+                const meshopt_Meshlet& meshlet = meshlets[i];
+                const meshopt_Bounds b = meshopt_computeMeshletBounds(
+                    &meshletVertices[meshlet.vertex_offset], &meshletTriangles[meshlet.triangle_offset],
+                    meshlet.triangle_count, vertexPositions, vertexCount, positionStride);
+
+                auto& out = bounds[i];
+                std::copy(b.center, b.center + 3, out.center);
+                out.radius = b.radius;
+                std::copy(b.cone_apex, b.cone_apex + 3, out.coneApex);
+                std::copy(b.cone_axis, b.cone_axis + 3, out.coneAxis);
+                out.coneCutoff = b.cone_cutoff;
+                out.padding = 0.0f;
+
+                records[i * 4 + 0] = meshlet.vertex_offset;
+                records[i * 4 + 1] = meshlet.triangle_offset;
+                records[i * 4 + 2] = meshlet.vertex_count;
+                records[i * 4 + 3] = meshlet.triangle_count;
+                totalTriangles += meshlet.triangle_count;
+            }
+
+            tinygltf::Value::Object extension;
+            extension["count"] = tinygltf::Value(static_cast<int>(meshletCount));
+            extension["maxVertices"] = tinygltf::Value(options.maxVertices);
+            extension["maxTriangles"] = tinygltf::Value(options.maxTriangles);
+            extension["meshlets"] = bufferViewRef(
+                arena.append(records.data(), records.size() * sizeof(uint32_t), 0));
+            extension["vertices"] = bufferViewRef(
+                arena.append(meshletVertices.data(), meshletVertices.size() * sizeof(unsigned int), 0));
+            extension["triangles"] = bufferViewRef(
+                arena.append(meshletTriangles.data(), meshletTriangles.size(), 0));
+            extension["bounds"] = bufferViewRef(
+                arena.append(bounds.data(), bounds.size() * sizeof(MeshletBounds), 0));
+            prim.extensions[kMeshletsExtension] = tinygltf::Value(extension);
+
+            const size_t bytes = records.size() * sizeof(uint32_t) + meshletVertices.size() * sizeof(unsigned int) +
+                                 meshletTriangles.size() + bounds.size() * sizeof(MeshletBounds);
+            ++processed;
+            totalMeshlets += meshletCount;
+            totalBytes += bytes;
+
+            if (options.verbose) {
+                std::cout << "[meshlets] Primitive " << meshIdx << ':' << primIdx << ": " << meshletCount
+                          << " meshlets for " << indices.size() / 3 << " triangles (" << bytes << " bytes)"
+                          << std::endl;
+            }
+        }
+    }
+
+    arena.commit();
+
+    if (processed > 0 && !containsExtension(model.extensionsUsed, kMeshletsExtension)) {
+        model.extensionsUsed.push_back(kMeshletsExtension);
+    }
+
+    std::ostringstream stream;
+    if (processed == 0) {
+        stream << "No primitives converted to meshlets";
+    } else {
+        stream << "Primitives with meshlets: " << processed << '\n'
+               << "Meshlets: " << totalMeshlets << " (" << totalTriangles << " triangles, "
+               << std::fixed;
+        stream.precision(1);
+        stream << static_cast<double>(totalTriangles) / static_cast<double>(totalMeshlets)
+               << " per meshlet, " << totalBytes << " bytes)";
+    }
+    if (skipped > 0) {
+        stream << "\nSkipped: " << skipped;
+    }
+    stats_ = stream.str();
+
+    if (options.verbose) {
+        std::cout << "[meshlets] " << stats_ << std::endl;
+    }
+    return true;
+}
+
+} // namespace gltfu
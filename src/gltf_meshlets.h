@@ -0,0 +1,60 @@
+#pragma once
+
+#include "tiny_gltf.h"
+#include <string>
+
+namespace gltfu {
+
+// Primitive extension holding the meshlet bufferViews
+constexpr const char* kMeshletsExtension = "GLTFU_meshlets";
+
+/**
+ * Options for the meshlets operation.
+ */
+struct MeshletOptions {
+    int maxVertices = 64;        // Vertices per meshlet (mesh shader output limit)
+    int maxTriangles = 124;      // Triangles per meshlet, must be a multiple of 4 up to 512
+    float coneWeight = 0.25f;    // 0 = spatially tight meshlets, 1 = tight normal cones for backface culling
+    bool verbose = false;        // Emit per-primitive meshlet counts
+};
+
+/**
+ * Meshlets partitions indexed triangle primitives into meshlets with
+ * meshoptimizer and stores them next to the regular index buffer, so
+ * cluster-culling and mesh-shader runtimes can upload them directly.
+ *
+ * Each processed primitive gets a GLTFU_meshlets extension:
+ *
+ *   "GLTFU_meshlets": {
+ *     "count": N, "maxVertices": 64, "maxTriangles": 124,
+ *     "meshlets":  { "bufferView": i },  // N x uint32 {vertexOffset, triangleOffset, vertexCount, triangleCount}
+ *     "vertices":  { "bufferView": j },  // uint32 vertex indices referenced by meshlets
+ *     "triangles": { "bufferView": k },  // uint8 x3 local indices, each meshlet padded to 4 bytes
+ *     "bounds":    { "bufferView": l }   // N x float32 {center[3], radius, coneApex[3], coneAxis[3], coneCutoff, pad}
+ *   }
+ *
+ * The primitive keeps its indices and attributes, so viewers that ignore the
+ * extension still render it. Passes that reorder vertices (weld, simplify)
+ * invalidate meshlets and must run before this one; compress leaves
+ * primitives carrying the extension uncompressed.
+ */
+class GltfMeshlets {
+public:
+    GltfMeshlets() = default;
+
+    /**
+     * Build meshlets for every indexed triangle primitive.
+     * @param model The GLTF model to process
+     * @param options Meshlet options
+     * @return true if successful
+     */
+    bool process(tinygltf::Model& model, const MeshletOptions& options = MeshletOptions());
+    std::string getStats() const { return stats_; }
+    std::string getError() const { return error_; }
+
+private:
+    std::string stats_;
+    std::string error_;
+};
+
+} // namespace gltfu
@@ -5,6 +5,71 @@
 #include <unordered_map>
 
 namespace gltfu {
+namespace {
+
+// Extensions reference raw data as { "bufferView": N } objects, possibly nested
+void markExtensionBufferViews(const tinygltf::Value& value,
+                              const tinygltf::Model& model,
+                              std::unordered_set<int>& usedBufferViews,
+                              std::unordered_set<int>& usedBuffers) {
+    if (value.IsArray()) {
+        for (size_t i = 0; i < value.ArrayLen(); ++i) {
+            markExtensionBufferViews(value.Get(static_cast<int>(i)), model, usedBufferViews, usedBuffers);
+        }
+        return;
+    }
+    if (!value.IsObject()) {
+        return;
+    }
+    for (const auto& member : value.Get<tinygltf::Value::Object>()) {
+        if (member.first == "bufferView" && member.second.IsInt()) {
+            const int bvIdx = member.second.Get<int>();
+            if (bvIdx >= 0 && bvIdx < static_cast<int>(model.bufferViews.size())) {
+                usedBufferViews.insert(bvIdx);
+                const auto& bv = model.bufferViews[bvIdx];
+                if (bv.buffer >= 0) {
+                    usedBuffers.insert(bv.buffer);
+                }
+            }
+        } else {
+            markExtensionBufferViews(member.second, model, usedBufferViews, usedBuffers);
+        }
+    }
+}
+
+void markExtensionBufferViews(const tinygltf::ExtensionMap& extensions,
+                              const tinygltf::Model& model,
+                              std::unordered_set<int>& usedBufferViews,
+                              std::unordered_set<int>& usedBuffers) {
+    for (const auto& ext : extensions) {
+        markExtensionBufferViews(ext.second, model, usedBufferViews, usedBuffers);
+    }
+}
+
+void remapExtensionBufferViews(tinygltf::Value& value, const std::vector<int>& bufferViewMap) {
+    if (value.IsArray()) {
+        for (auto& element : value.Get<tinygltf::Value::Array>()) {
+            remapExtensionBufferViews(element, bufferViewMap);
+        }
+        return;
+    }
+    if (!value.IsObject()) {
+        return;
+    }
+    for (auto& member : value.Get<tinygltf::Value::Object>()) {
+        if (member.first == "bufferView" && member.second.IsInt()) {
+            const int oldBvIdx = member.second.Get<int>();
+            if (oldBvIdx >= 0 && oldBvIdx < static_cast<int>(bufferViewMap.size()) &&
+                bufferViewMap[oldBvIdx] != -1) {
+                member.second = tinygltf::Value(bufferViewMap[oldBvIdx]);
+            }
+        } else {
+            remapExtensionBufferViews(member.second, bufferViewMap);
+        }
+    }
+}
+
+} // namespace
 
 bool GltfPrune::process(tinygltf::Model& model, const PruneOptions& options) {
     error_.clear();
@@ -34,6 +99,7 @@ bool GltfPrune::process(tinygltf::Model& model, const PruneOptions& options) {
     
     // Mark resources used by animations
     markAnimationResources(model, usedNodes, usedAccessors, usedBufferViews, usedBuffers);
+    markExtensionBufferViews(model.extensions, model, usedBufferViews, usedBuffers);
     
     // Prune empty leaf nodes if requested
     if (!options.keepLeaves) {
@@ -54,6 +120,7 @@ bool GltfPrune::process(tinygltf::Model& model, const PruneOptions& options) {
                                usedAccessors, usedTextures, usedImages, usedSamplers,
                                usedBufferViews, usedBuffers, usedSkins, usedCameras);
         markAnimationResources(model, usedNodes, usedAccessors, usedBufferViews, usedBuffers);
+        markExtensionBufferViews(model.extensions, model, usedBufferViews, usedBuffers);
     }
     
     // Prune unused vertex attributes if requested
@@ -76,6 +143,7 @@ bool GltfPrune::process(tinygltf::Model& model, const PruneOptions& options) {
                                usedAccessors, usedTextures, usedImages, usedSamplers,
                                usedBufferViews, usedBuffers, usedSkins, usedCameras);
         markAnimationResources(model, usedNodes, usedAccessors, usedBufferViews, usedBuffers);
+        markExtensionBufferViews(model.extensions, model, usedBufferViews, usedBuffers);
     }
 
     auto ensureAccessorResourcesMarked = [&]() {
@@ -206,26 +274,18 @@ bool GltfPrune::process(tinygltf::Model& model, const PruneOptions& options) {
                 }
             }
             
-            // Update Draco compression extension bufferView
-            if (prim.extensions.count("KHR_draco_mesh_compression") > 0) {
-                auto& dracoExt = prim.extensions.at("KHR_draco_mesh_compression");
-                if (dracoExt.Has("bufferView") && dracoExt.Get("bufferView").IsInt()) {
-                    int oldBvIdx = dracoExt.Get("bufferView").Get<int>();
-                    if (oldBvIdx >= 0 && oldBvIdx < static_cast<int>(bufferViewMap.size())) {
-                        int newBvIdx = bufferViewMap[oldBvIdx];
-                        if (newBvIdx != -1) {
-                            // Need to get the mutable object and update it
-                            if (dracoExt.IsObject()) {
-                                auto& obj = dracoExt.Get<tinygltf::Value::Object>();
-                                obj["bufferView"] = tinygltf::Value(newBvIdx);
-                            }
-                        }
-                    }
-                }
+            // Update bufferViews referenced by primitive extensions (Draco, meshlets)
+            for (auto& ext : prim.extensions) {
+                remapExtensionBufferViews(ext.second, bufferViewMap);
             }
         }
     }
     
+    // Update bufferViews referenced by root extensions (scene BVH)
+    for (auto& ext : model.extensions) {
+        remapExtensionBufferViews(ext.second, bufferViewMap);
+    }
+    
     // Update materials
     for (auto& material : model.materials) {
         auto updateTextureInfo = [&](tinygltf::TextureInfo& info) {
@@ -521,19 +581,9 @@ void GltfPrune::markMesh(int meshIdx,
             }
         }
         
-        // Mark Draco compression extension bufferView
-        if (prim.extensions.count("KHR_draco_mesh_compression") > 0) {
-            const auto& dracoExt = prim.extensions.at("KHR_draco_mesh_compression");
-            if (dracoExt.Has("bufferView") && dracoExt.Get("bufferView").IsInt()) {
-                int bvIdx = dracoExt.Get("bufferView").Get<int>();
-                if (bvIdx >= 0 && bvIdx < static_cast<int>(model.bufferViews.size())) {
-                    usedBufferViews.insert(bvIdx);
-                    const auto& bv = model.bufferViews[bvIdx];
-                    if (bv.buffer >= 0) {
-                        usedBuffers.insert(bv.buffer);
-                    }
-                }
-            }
+        // Mark bufferViews referenced by primitive extensions (Draco, meshlets)
+        for (const auto& ext : prim.extensions) {
+            markExtensionBufferViews(ext.second, model, usedBufferViews, usedBuffers);
         }
     }
 }
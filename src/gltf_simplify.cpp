@@ -1,19 +1,183 @@
 #include "gltf_simplify.h"
+#include "buffer_arena.h"
+#include "gltf_bounds.h"
+#include "gltf_flatten.h"
+#include "gltf_triangulate.h"
 #include "meshoptimizer.h"
+#include "trace.h"
 #include <iostream>
 #include <algorithm>
+#include <cmath>
+#include <cfloat>
 #include <cstring>
+#include <functional>
+#include <queue>
 #include <sstream>
+#include <stdexcept>
 
 namespace gltfu {
+namespace {
+
+constexpr const char* kCacheStage = "simplify";
+constexpr unsigned int kUnusedVertex = ~0u;
+constexpr size_t kMaxAttributeChannels = 9;  // NORMAL + TEXCOORD_0 + COLOR_0
+constexpr size_t kMinBudgetIndices = 3 * 16; // Coarsest level measured for budget allocation
+
+// Vertex streams can only be compacted if every one of them is a plain, dense accessor.
+bool isCompactable(const tinygltf::Model& model, int accessorIdx, size_t vertexCount) {
+    if (accessorIdx < 0 || accessorIdx >= static_cast<int>(model.accessors.size())) {
+        return false;
+    }
+    const auto& accessor = model.accessors[accessorIdx];
+    return !accessor.sparse.isSparse && accessor.count == vertexCount &&
+           accessor.bufferView >= 0 && accessor.bufferView < static_cast<int>(model.bufferViews.size());
+}
+
+// Decode one component to float, applying the glTF normalization rules for integer types.
+float readComponent(const unsigned char* data, int componentType, bool normalized) {
+    switch (componentType) {
+        case TINYGLTF_COMPONENT_TYPE_FLOAT: {
+            float value;
+            std::memcpy(&value, data, sizeof(value));
+            return value;
+        }
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+            return normalized ? data[0] / 255.0f : static_cast<float>(data[0]);
+        case TINYGLTF_COMPONENT_TYPE_BYTE: {
+            const float value = static_cast<float>(static_cast<int8_t>(data[0]));
+            return normalized ? std::max(value / 127.0f, -1.0f) : value;
+        }
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
+            uint16_t value;
+            std::memcpy(&value, data, sizeof(value));
+            return normalized ? value / 65535.0f : static_cast<float>(value);
+        }
+        case TINYGLTF_COMPONENT_TYPE_SHORT: {
+            int16_t value;
+            std::memcpy(&value, data, sizeof(value));
+            return normalized ? std::max(value / 32767.0f, -1.0f) : static_cast<float>(value);
+        }
+        default:
+            return 0.0f;
+    }
+}
+
+// Append up to maxComponents float channels of an attribute to the interleaved
+// buffer. Returns the number of channels written (0 if the attribute is unusable).
+size_t gatherAttribute(const tinygltf::Model& model, const tinygltf::Primitive& primitive, const char* name,
+                       size_t maxComponents, size_t vertexCount, std::vector<float>& interleaved,
+                       size_t interleavedStride, size_t channel) {
+    const auto it = primitive.attributes.find(name);
+    if (it == primitive.attributes.end() || it->second < 0 ||
+        it->second >= static_cast<int>(model.accessors.size())) {
+        return 0;
+    }
+
+    const auto& accessor = model.accessors[it->second];
+    if (accessor.sparse.isSparse || accessor.count != vertexCount || accessor.bufferView < 0 ||
+        accessor.bufferView >= static_cast<int>(model.bufferViews.size())) {
+        return 0;
+    }
+
+    const int componentCount = tinygltf::GetNumComponentsInType(static_cast<uint32_t>(accessor.type));
+    const int componentSize = tinygltf::GetComponentSizeInBytes(static_cast<uint32_t>(accessor.componentType));
+    if (componentCount <= 0 || componentSize <= 0 || componentSize > 4) {
+        return 0;
+    }
+
+    const auto& view = model.bufferViews[accessor.bufferView];
+    if (view.buffer < 0 || view.buffer >= static_cast<int>(model.buffers.size())) {
+        return 0;
+    }
+    const auto& data = model.buffers[view.buffer].data;
+    const size_t elementSize = static_cast<size_t>(componentCount) * componentSize;
+    const size_t stride = view.byteStride != 0 ? view.byteStride : elementSize;
+    const size_t offset = view.byteOffset + accessor.byteOffset;
+    if (offset + (vertexCount - 1) * stride + elementSize > data.size()) {
+        return 0;
+    }
+
+    const size_t channels = std::min(static_cast<size_t>(componentCount), maxComponents);
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
+        const unsigned char* element = data.data() + offset + vertex * stride;
+        float* dst = interleaved.data() + vertex * interleavedStride + channel;
+        for (size_t c = 0; c < channels; ++c) {
+            dst[c] = readComponent(element + c * componentSize, accessor.componentType, accessor.normalized);
+        }
+    }
+    return channels;
+}
+
+// Cache payload: [uint32 index count][float error][uint32 indices...]
+std::vector<uint8_t> encodeCachedResult(const std::vector<unsigned int>& indices, float error) {
+    const uint32_t count = static_cast<uint32_t>(indices.size());
+    std::vector<uint8_t> payload(sizeof(count) + sizeof(error) + indices.size() * sizeof(uint32_t));
+    std::memcpy(payload.data(), &count, sizeof(count));
+    std::memcpy(payload.data() + sizeof(count), &error, sizeof(error));
+    if (!indices.empty()) {
+        std::memcpy(payload.data() + sizeof(count) + sizeof(error), indices.data(), indices.size() * sizeof(uint32_t));
+    }
+    return payload;
+}
+
+bool decodeCachedResult(const std::vector<uint8_t>& payload, size_t vertexCount,
+                        std::vector<unsigned int>& indices, float& error) {
+    uint32_t count = 0;
+    if (payload.size() < sizeof(count) + sizeof(error)) {
+        return false;
+    }
+    std::memcpy(&count, payload.data(), sizeof(count));
+    if (payload.size() != sizeof(count) + sizeof(error) + size_t(count) * sizeof(uint32_t)) {
+        return false;
+    }
+    std::memcpy(&error, payload.data() + sizeof(count), sizeof(error));
+    indices.resize(count);
+    if (count > 0) {
+        std::memcpy(indices.data(), payload.data() + sizeof(count) + sizeof(error), size_t(count) * sizeof(uint32_t));
+    }
+    return std::all_of(indices.begin(), indices.end(),
+                       [vertexCount](unsigned int index) { return index < vertexCount; });
+}
+
+} // namespace
 
 bool GltfSimplify::process(tinygltf::Model& model, const SimplifyOptions& options) {
     error_.clear();
     stats_.clear();
 
+    const bool budgeted = options.triangleBudget > 0;
     if (options.verbose) {
-        std::cout << "[simplify] Starting (ratio=" << options.ratio
-                  << ", error=" << options.error << ")" << std::endl;
+        if (budgeted) {
+            std::cout << "[simplify] Starting (budget=" << options.triangleBudget << " triangles)" << std::endl;
+        } else {
+            std::cout << "[simplify] Starting (ratio=" << options.ratio
+                      << ", error=" << options.error << ")" << std::endl;
+        }
+    }
+
+    // Strips and fans become indexed triangle lists before anything reads their indices
+    GltfTriangulate triangulator;
+    TriangulateOptions triangulateOptions;
+    triangulateOptions.verbose = options.verbose;
+    triangulator.process(model, triangulateOptions);
+
+    // Absolute modes turn one world-space budget into a relative error per primitive,
+    // based on the largest world-space size the primitive is drawn at
+    const bool absoluteError = !budgeted && options.errorMode != SimplifyErrorMode::Relative;
+    const double worldBudget = absoluteError ? worldErrorBudget(options) : 0.0;
+    std::vector<std::vector<Matrix4>> meshInstances;
+    if (absoluteError || budgeted) {
+        meshInstances.resize(model.meshes.size());
+        const std::vector<Matrix4> worldMatrices = GltfFlatten::computeWorldMatrices(model);
+        for (size_t nodeIdx = 0; nodeIdx < model.nodes.size(); ++nodeIdx) {
+            const int meshIdx = model.nodes[nodeIdx].mesh;
+            if (meshIdx >= 0 && meshIdx < static_cast<int>(model.meshes.size())) {
+                meshInstances[meshIdx].push_back(worldMatrices[nodeIdx]);
+            }
+        }
+        if (absoluteError && options.verbose) {
+            std::cout << "[simplify] World-space error budget: " << worldBudget << std::endl;
+        }
     }
 
     size_t totalPrimitives = 0;
@@ -21,20 +185,41 @@ bool GltfSimplify::process(tinygltf::Model& model, const SimplifyOptions& option
     size_t skippedPrimitives = 0;
     size_t totalOriginalTriangles = 0;
     size_t totalSimplifiedTriangles = 0;
+    size_t totalOriginalVertices = 0;
+    size_t totalSimplifiedVertices = 0;
+
+    cache_.reset();
+    if (!options.cacheDirectory.empty()) {
+        cache_ = std::make_unique<PrimitiveCache>(options.cacheDirectory);
+    }
+
+    // New index and vertex data is staged and spliced into buffer 0 once at the end
+    arena_ = std::make_unique<BufferArena>(model);
+    pendingBounds_.clear();
+
+    // Budget mode picks every primitive's target index count up front (0 = keep as is)
+    std::vector<std::vector<size_t>> budgetTargets;
+    BudgetSummary budget;
 
     try {
+        if (budgeted) {
+            allocateTriangleBudget(model, options, meshInstances, budgetTargets, budget);
+            if (options.verbose) {
+                std::cout << "[simplify] Budget allocated " << budget.allocatedTriangles << " triangles over "
+                          << budget.measuredPrimitives << " primitives (+" << budget.fixedTriangles
+                          << " fixed), max error " << budget.maxError << std::endl;
+            }
+        }
+
         for (size_t meshIdx = 0; meshIdx < model.meshes.size(); ++meshIdx) {
             auto& mesh = model.meshes[meshIdx];
             for (size_t primIdx = 0; primIdx < mesh.primitives.size(); ++primIdx) {
                 auto& prim = mesh.primitives[primIdx];
                 ++totalPrimitives;
+                TraceScope traceScope("simplify", "primitive", static_cast<long long>(meshIdx),
+                                      static_cast<long long>(primIdx));
 
-                const bool isTrianglePrimitive =
-                    prim.mode == TINYGLTF_MODE_TRIANGLES ||
-                    prim.mode == TINYGLTF_MODE_TRIANGLE_STRIP ||
-                    prim.mode == TINYGLTF_MODE_TRIANGLE_FAN;
-
-                if (!isTrianglePrimitive) {
+                if (prim.mode != TINYGLTF_MODE_TRIANGLES) {
                     ++skippedPrimitives;
                     if (options.verbose) {
                         std::cout << "[simplify] Skipping primitive " << meshIdx << ':' << primIdx
@@ -43,25 +228,44 @@ bool GltfSimplify::process(tinygltf::Model& model, const SimplifyOptions& option
                     continue;
                 }
 
-                if (prim.mode != TINYGLTF_MODE_TRIANGLES) {
-                    if (options.verbose) {
-                        std::cout << "[simplify] Converting primitive " << meshIdx << ':' << primIdx
-                                  << " from mode " << prim.mode << " to triangles" << std::endl;
+                size_t budgetIndexCount = 0;
+                if (budgeted) {
+                    budgetIndexCount = budgetTargets[meshIdx][primIdx];
+                    if (budgetIndexCount == 0) {
+                        ++skippedPrimitives;
+                        if (options.verbose) {
+                            std::cout << "[simplify] Keeping primitive " << meshIdx << ':' << primIdx
+                                      << " at full detail within budget" << std::endl;
+                        }
+                        continue;
                     }
-                    convertToTriangles(prim, model);
+                }
+
+                SimplifyOptions primitiveOptions = options;
+                if (budgeted) {
+                    // The allocated size is the only stopping criterion
+                    primitiveOptions.error = FLT_MAX;
+                } else if (absoluteError) {
+                    const double extent = primitiveWorldExtent(model, prim, meshInstances[meshIdx]);
+                    primitiveOptions.errorMode = SimplifyErrorMode::Relative;
+                    primitiveOptions.error = extent > 0.0 ? static_cast<float>(worldBudget / extent) : options.error;
                 }
 
                 PrimitiveSummary summary{};
-                if (simplifyPrimitive(prim, model, options, summary)) {
+                if (simplifyPrimitive(prim, model, primitiveOptions, budgetIndexCount, summary)) {
                     ++simplifiedPrimitives;
                     totalOriginalTriangles += summary.originalTriangles;
                     totalSimplifiedTriangles += summary.simplifiedTriangles;
+                    totalOriginalVertices += summary.originalVertices;
+                    totalSimplifiedVertices += summary.simplifiedVertices;
 
                     if (options.verbose) {
                         const char* meshName = mesh.name.empty() ? "(unnamed)" : mesh.name.c_str();
                         std::cout << "[simplify] " << meshName << " primitive " << primIdx
                                   << ": " << summary.originalTriangles << " → "
-                                  << summary.simplifiedTriangles << " triangles"
+                                  << summary.simplifiedTriangles << " triangles, "
+                                  << summary.originalVertices << " → "
+                                  << summary.simplifiedVertices << " vertices"
                                   << " (error " << summary.error << ")" << std::endl;
                     }
                 } else {
@@ -75,7 +279,16 @@ bool GltfSimplify::process(tinygltf::Model& model, const SimplifyOptions& option
                 }
             }
         }
+        arena_->commit();
+        arena_.reset();
+
+        // Bounds need the compacted bytes, which only exist in the model after the commit
+        for (const int accessorIdx : pendingBounds_) {
+            GltfBounds::computeAccessorBounds(model, accessorIdx);
+        }
+        pendingBounds_.clear();
     } catch (const std::exception& ex) {
+        arena_.reset();
         error_ = std::string("Simplification failed: ") + ex.what();
         return false;
     }
@@ -89,6 +302,10 @@ bool GltfSimplify::process(tinygltf::Model& model, const SimplifyOptions& option
             stream << "\nTriangles: " << totalOriginalTriangles << " → "
                    << totalSimplifiedTriangles;
         }
+        if (totalOriginalVertices > 0) {
+            stream << "\nVertices: " << totalOriginalVertices << " → "
+                   << totalSimplifiedVertices;
+        }
         if (skippedPrimitives > 0) {
             stream << "\nSkipped: " << skippedPrimitives;
         }
@@ -99,6 +316,20 @@ bool GltfSimplify::process(tinygltf::Model& model, const SimplifyOptions& option
         }
     }
 
+    if (budgeted) {
+        stream << "\nTriangle budget: " << (budget.allocatedTriangles + budget.fixedTriangles) << '/'
+               << options.triangleBudget << " (max error " << budget.maxError << ", total error "
+               << budget.totalError << ")";
+        if (!budget.fits) {
+            stream << " - budget not reachable";
+        }
+    }
+
+    if (cache_) {
+        stream << "\nPrimitive cache: " << cache_->getHits() << " hits, "
+               << cache_->getMisses() << " misses";
+    }
+
     stats_ = stream.str();
 
     if (options.verbose) {
@@ -108,150 +339,458 @@ bool GltfSimplify::process(tinygltf::Model& model, const SimplifyOptions& option
     return true;
 }
 
-bool GltfSimplify::simplifyPrimitive(tinygltf::Primitive& primitive,
-                                      tinygltf::Model& model,
-                                      const SimplifyOptions& options,
-                                      PrimitiveSummary& summary) {
-    summary = {};
-
+bool GltfSimplify::loadGeometry(const tinygltf::Model& model,
+                                const tinygltf::Primitive& primitive,
+                                const SimplifyOptions& options,
+                                PrimitiveGeometry& geometry,
+                                std::string& reason) const {
     const auto posIt = primitive.attributes.find("POSITION");
     if (posIt == primitive.attributes.end()) {
-        summary.reason = "missing POSITION attribute";
+        reason = "missing POSITION attribute";
         return false;
     }
 
     const int posAccessorIdx = posIt->second;
     if (posAccessorIdx < 0 || posAccessorIdx >= static_cast<int>(model.accessors.size())) {
-        summary.reason = "invalid POSITION accessor";
+        reason = "invalid POSITION accessor";
         return false;
     }
 
     const auto& posAccessor = model.accessors[posAccessorIdx];
     const size_t vertexCount = posAccessor.count;
     if (vertexCount == 0) {
-        summary.reason = "empty POSITION accessor";
+        reason = "empty POSITION accessor";
         return false;
     }
 
     if (primitive.indices < 0 || primitive.indices >= static_cast<int>(model.accessors.size())) {
-        summary.reason = "missing indices";
+        reason = "missing indices";
         return false;
     }
 
     const auto& indexAccessor = model.accessors[primitive.indices];
     const size_t indexCount = indexAccessor.count;
     if (indexCount == 0 || indexCount % 3 != 0) {
-        summary.reason = "indices not a triangle list";
+        reason = "indices not a triangle list";
         return false;
     }
 
-    summary.originalTriangles = indexCount / 3;
-    summary.simplifiedTriangles = summary.originalTriangles;
-
     if (posAccessor.bufferView < 0 || posAccessor.bufferView >= static_cast<int>(model.bufferViews.size())) {
-        summary.reason = "invalid POSITION bufferView";
+        reason = "invalid POSITION bufferView";
         return false;
     }
 
     const auto& posBufferView = model.bufferViews[posAccessor.bufferView];
     if (posBufferView.buffer < 0 || posBufferView.buffer >= static_cast<int>(model.buffers.size())) {
-        summary.reason = "invalid POSITION buffer";
+        reason = "invalid POSITION buffer";
         return false;
     }
 
     const auto& posBuffer = model.buffers[posBufferView.buffer];
     const size_t posOffset = posBufferView.byteOffset + posAccessor.byteOffset;
     if (posOffset >= posBuffer.data.size()) {
-        summary.reason = "POSITION data out of range";
+        reason = "POSITION data out of range";
         return false;
     }
 
-    const unsigned char* posData = posBuffer.data.data() + posOffset;
-    const size_t posStride = posBufferView.byteStride != 0 ? posBufferView.byteStride : (3 * sizeof(float));
-
     if (indexAccessor.bufferView < 0 || indexAccessor.bufferView >= static_cast<int>(model.bufferViews.size())) {
-        summary.reason = "invalid index bufferView";
+        reason = "invalid index bufferView";
         return false;
     }
 
     const auto& indexBufferView = model.bufferViews[indexAccessor.bufferView];
     if (indexBufferView.buffer < 0 || indexBufferView.buffer >= static_cast<int>(model.buffers.size())) {
-        summary.reason = "invalid index buffer";
+        reason = "invalid index buffer";
         return false;
     }
 
     const auto& indexBuffer = model.buffers[indexBufferView.buffer];
     const size_t indexOffset = indexBufferView.byteOffset + indexAccessor.byteOffset;
     if (indexOffset >= indexBuffer.data.size()) {
-        summary.reason = "index data out of range";
+        reason = "index data out of range";
         return false;
     }
 
     const unsigned char* indexData = indexBuffer.data.data() + indexOffset;
 
-    std::vector<unsigned int> indices(indexCount);
+    geometry.indices.resize(indexCount);
     switch (indexAccessor.componentType) {
         case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: {
             const auto* src = reinterpret_cast<const uint8_t*>(indexData);
             for (size_t i = 0; i < indexCount; ++i) {
-                indices[i] = src[i];
+                geometry.indices[i] = src[i];
             }
             break;
         }
         case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
             const auto* src = reinterpret_cast<const uint16_t*>(indexData);
             for (size_t i = 0; i < indexCount; ++i) {
-                indices[i] = src[i];
+                geometry.indices[i] = src[i];
             }
             break;
         }
         case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT: {
             const auto* src = reinterpret_cast<const uint32_t*>(indexData);
-            std::memcpy(indices.data(), src, indexCount * sizeof(uint32_t));
+            std::memcpy(geometry.indices.data(), src, indexCount * sizeof(uint32_t));
             break;
         }
         default:
-            summary.reason = "unsupported index type";
+            reason = "unsupported index type";
             return false;
     }
 
-    size_t targetIndexCount = static_cast<size_t>(static_cast<double>(indexCount) * options.ratio);
-    targetIndexCount = (targetIndexCount / 3) * 3;
-    if (targetIndexCount < 3) {
-        targetIndexCount = 3;
+    geometry.positions = reinterpret_cast<const float*>(posBuffer.data.data() + posOffset);
+    geometry.positionStride = posBufferView.byteStride != 0 ? posBufferView.byteStride : (3 * sizeof(float));
+    geometry.vertexCount = vertexCount;
+
+    // Interleave NORMAL (3), TEXCOORD_0 (2) and COLOR_0 (up to 4) for the attribute metric
+    geometry.attributes.clear();
+    geometry.attributeWeights.clear();
+    if (options.normalWeight > 0.0f || options.texCoordWeight > 0.0f || options.colorWeight > 0.0f) {
+        geometry.attributes.assign(vertexCount * kMaxAttributeChannels, 0.0f);
+        const struct {
+            const char* name;
+            size_t components;
+            float weight;
+        } streams[] = {
+            {"NORMAL", 3, options.normalWeight},
+            {"TEXCOORD_0", 2, options.texCoordWeight},
+            {"COLOR_0", 4, options.colorWeight},
+        };
+        for (const auto& stream : streams) {
+            if (stream.weight <= 0.0f) {
+                continue;
+            }
+            const size_t channels = gatherAttribute(model, primitive, stream.name, stream.components, vertexCount,
+                                                    geometry.attributes, kMaxAttributeChannels,
+                                                    geometry.attributeWeights.size());
+            geometry.attributeWeights.insert(geometry.attributeWeights.end(), channels, stream.weight);
+        }
     }
 
-    if (indexCount <= targetIndexCount) {
-        summary.reason = "already at or below target";
-        return false;
-    }
+    return true;
+}
 
-    std::vector<unsigned int> simplifiedIndices(indexCount);
+size_t GltfSimplify::runSimplifier(const PrimitiveGeometry& geometry,
+                                   const SimplifyOptions& options,
+                                   size_t targetIndexCount,
+                                   float targetError,
+                                   std::vector<unsigned int>& destination,
+                                   float& resultError) const {
+    destination.resize(geometry.indices.size());
 
     unsigned int simplifyFlags = 0;
     if (options.lockBorder) {
         simplifyFlags |= meshopt_SimplifyLockBorder;
     }
 
+    size_t simplifiedCount = 0;
+    if (!geometry.attributeWeights.empty()) {
+        simplifiedCount = meshopt_simplifyWithAttributes(
+            destination.data(),
+            geometry.indices.data(),
+            geometry.indices.size(),
+            geometry.positions,
+            geometry.vertexCount,
+            geometry.positionStride,
+            geometry.attributes.data(),
+            kMaxAttributeChannels * sizeof(float),
+            geometry.attributeWeights.data(),
+            geometry.attributeWeights.size(),
+            nullptr,
+            targetIndexCount,
+            targetError,
+            simplifyFlags,
+            &resultError);
+    } else {
+        simplifiedCount = meshopt_simplify(
+            destination.data(),
+            geometry.indices.data(),
+            geometry.indices.size(),
+            geometry.positions,
+            geometry.vertexCount,
+            geometry.positionStride,
+            targetIndexCount,
+            targetError,
+            simplifyFlags,
+            &resultError);
+    }
+    destination.resize(simplifiedCount);
+    return simplifiedCount;
+}
+
+void GltfSimplify::allocateTriangleBudget(tinygltf::Model& model,
+                                          const SimplifyOptions& options,
+                                          const std::vector<std::vector<Matrix4>>& meshInstances,
+                                          std::vector<std::vector<size_t>>& targets,
+                                          BudgetSummary& budget) const {
+    struct Curve {
+        size_t mesh = 0;
+        size_t primitive = 0;
+        std::vector<ErrorSample> samples;   // Strictly fewer indices and non-decreasing error
+        size_t chosen = 0;
+        size_t instances = 1;               // Nodes drawing the mesh; weights triangles and error
+    };
+
+    budget = {};
+    std::vector<Curve> curves;
+    targets.assign(model.meshes.size(), {});
+
+    for (size_t meshIdx = 0; meshIdx < model.meshes.size(); ++meshIdx) {
+        const auto& primitives = model.meshes[meshIdx].primitives;
+        targets[meshIdx].assign(primitives.size(), 0);
+        // The budget counts rendered triangles, so every instance of a mesh counts
+        const size_t instances = std::max<size_t>(1, meshInstances[meshIdx].size());
+
+        for (size_t primIdx = 0; primIdx < primitives.size(); ++primIdx) {
+            const auto& prim = primitives[primIdx];
+            TraceScope traceScope("simplify", "measure", static_cast<long long>(meshIdx),
+                                  static_cast<long long>(primIdx));
+
+            // Errors are compared across primitives, so bring them to world units
+            const double extent = prim.mode == TINYGLTF_MODE_TRIANGLES
+                ? primitiveWorldExtent(model, prim, meshInstances[meshIdx]) : 0.0;
+
+            PrimitiveGeometry geometry;
+            std::string reason;
+            if (prim.mode != TINYGLTF_MODE_TRIANGLES || !loadGeometry(model, prim, options, geometry, reason)) {
+                budget.fixedTriangles += primitiveTriangleCount(model, prim) * instances;
+                continue;
+            }
+
+            Curve curve;
+            curve.mesh = meshIdx;
+            curve.primitive = primIdx;
+            curve.instances = instances;
+            curve.samples.push_back({geometry.indices.size(), geometry.indices.size(), 0.0});
+
+            // Halve the target until the simplifier stops making progress
+            std::vector<unsigned int> scratch;
+            size_t target = geometry.indices.size();
+            while (target > kMinBudgetIndices) {
+                target = std::max(kMinBudgetIndices, (target / 2) / 3 * 3);
+                float resultError = 0.0f;
+                const size_t count = runSimplifier(geometry, options, target, FLT_MAX, scratch, resultError);
+                if (count == 0 || count >= curve.samples.back().indexCount) {
+                    break;
+                }
+                const double error = std::max(curve.samples.back().error,
+                                              static_cast<double>(resultError) * (extent > 0.0 ? extent : 1.0));
+                curve.samples.push_back({target, count, error});
+            }
+
+            ++budget.measuredPrimitives;
+            curves.push_back(std::move(curve));
+        }
+    }
+
+    const size_t available = options.triangleBudget > budget.fixedTriangles
+        ? options.triangleBudget - budget.fixedTriangles : 0;
+
+    auto allocatedTriangles = [&curves]() {
+        size_t total = 0;
+        for (const auto& curve : curves) {
+            total += curve.samples[curve.chosen].indexCount / 3 * curve.instances;
+        }
+        return total;
+    };
+
+    if (options.budgetObjective == SimplifyBudgetObjective::MinMax) {
+        // The cheapest level of each curve within a shared error bound; the total only
+        // shrinks as the bound grows, so binary search the smallest bound that fits
+        std::vector<double> bounds;
+        for (const auto& curve : curves) {
+            for (const auto& sample : curve.samples) {
+                bounds.push_back(sample.error);
+            }
+        }
+        std::sort(bounds.begin(), bounds.end());
+        bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+
+        auto chooseWithin = [&](double bound) {
+            for (auto& curve : curves) {
+                curve.chosen = 0;
+                while (curve.chosen + 1 < curve.samples.size() && curve.samples[curve.chosen + 1].error <= bound) {
+                    ++curve.chosen;
+                }
+            }
+            return allocatedTriangles();
+        };
+
+        size_t low = 0;
+        size_t high = bounds.empty() ? 0 : bounds.size() - 1;
+        if (!bounds.empty() && chooseWithin(bounds[high]) <= available) {
+            while (low < high) {
+                const size_t mid = low + (high - low) / 2;
+                if (chooseWithin(bounds[mid]) <= available) {
+                    high = mid;
+                } else {
+                    low = mid + 1;
+                }
+            }
+            chooseWithin(bounds[low]);
+        }
+    } else {
+        // Repeatedly take the coarsening step that costs the least error per triangle removed
+        using Step = std::pair<double, size_t>;
+        std::priority_queue<Step, std::vector<Step>, std::greater<Step>> steps;
+        auto pushStep = [&](size_t curveIdx) {
+            const auto& curve = curves[curveIdx];
+            if (curve.chosen + 1 < curve.samples.size()) {
+                const auto& from = curve.samples[curve.chosen];
+                const auto& to = curve.samples[curve.chosen + 1];
+                const double removed = static_cast<double>((from.indexCount - to.indexCount) / 3 * curve.instances);
+                const double added = (to.error - from.error) * static_cast<double>(curve.instances);
+                steps.push({added / std::max(removed, 1.0), curveIdx});
+            }
+        };
+        for (size_t curveIdx = 0; curveIdx < curves.size(); ++curveIdx) {
+            pushStep(curveIdx);
+        }
+
+        size_t total = allocatedTriangles();
+        while (total > available && !steps.empty()) {
+            const size_t curveIdx = steps.top().second;
+            steps.pop();
+            auto& curve = curves[curveIdx];
+            total -= (curve.samples[curve.chosen].indexCount - curve.samples[curve.chosen + 1].indexCount) / 3 *
+                     curve.instances;
+            ++curve.chosen;
+            pushStep(curveIdx);
+        }
+    }
+
+    for (const auto& curve : curves) {
+        const auto& sample = curve.samples[curve.chosen];
+        targets[curve.mesh][curve.primitive] = curve.chosen > 0 ? sample.targetIndexCount : 0;
+        budget.maxError = std::max(budget.maxError, sample.error);
+        budget.totalError += sample.error * static_cast<double>(curve.instances);
+    }
+    budget.allocatedTriangles = allocatedTriangles();
+    budget.fits = budget.allocatedTriangles <= available;
+}
+
+size_t GltfSimplify::primitiveTriangleCount(const tinygltf::Model& model, const tinygltf::Primitive& primitive) const {
+    size_t elements = 0;
+    if (primitive.indices >= 0 && primitive.indices < static_cast<int>(model.accessors.size())) {
+        elements = model.accessors[primitive.indices].count;
+    } else {
+        const auto posIt = primitive.attributes.find("POSITION");
+        if (posIt != primitive.attributes.end() && posIt->second >= 0 &&
+            posIt->second < static_cast<int>(model.accessors.size())) {
+            elements = model.accessors[posIt->second].count;
+        }
+    }
+
+    switch (primitive.mode) {
+        case TINYGLTF_MODE_TRIANGLES:
+            return elements / 3;
+        case TINYGLTF_MODE_TRIANGLE_STRIP:
+        case TINYGLTF_MODE_TRIANGLE_FAN:
+            return elements >= 3 ? elements - 2 : 0;
+        default:
+            return 0;
+    }
+}
+
+bool GltfSimplify::simplifyPrimitive(tinygltf::Primitive& primitive,
+                                      tinygltf::Model& model,
+                                      const SimplifyOptions& options,
+                                      size_t budgetIndexCount,
+                                      PrimitiveSummary& summary) {
+    summary = {};
+
+    PrimitiveGeometry geometry;
+    if (!loadGeometry(model, primitive, options, geometry, summary.reason)) {
+        return false;
+    }
+
+    const size_t vertexCount = geometry.vertexCount;
+    const size_t indexCount = geometry.indices.size();
+
+    summary.originalTriangles = indexCount / 3;
+    summary.simplifiedTriangles = summary.originalTriangles;
+    summary.originalVertices = vertexCount;
+    summary.simplifiedVertices = vertexCount;
+
+    size_t targetIndexCount = budgetIndexCount;
+    if (targetIndexCount == 0) {
+        targetIndexCount = static_cast<size_t>(static_cast<double>(indexCount) * options.ratio);
+        targetIndexCount = (targetIndexCount / 3) * 3;
+        if (targetIndexCount < 3) {
+            targetIndexCount = 3;
+        }
+    }
+
+    if (indexCount <= targetIndexCount) {
+        summary.reason = "already at or below target";
+        return false;
+    }
+
+    std::vector<unsigned int> simplifiedIndices;
     float resultError = 0.0f;
-    const size_t resultIndexCount = meshopt_simplify(
-        simplifiedIndices.data(),
-        indices.data(),
-        indexCount,
-        reinterpret_cast<const float*>(posData),
-        vertexCount,
-        posStride,
-        targetIndexCount,
-        options.error,
-        simplifyFlags,
-        &resultError);
 
+    // Reuse the result of an earlier run on identical geometry and options
+    std::string cacheKey;
+    bool cached = false;
+    if (cache_) {
+        cacheKey = PrimitiveCache::hashPrimitive(
+            model, primitive, CacheFingerprint().add(options).add("simplify.targetIndexCount", targetIndexCount));
+        std::vector<uint8_t> payload;
+        cached = !cacheKey.empty() && cache_->load(kCacheStage, cacheKey, payload) &&
+                 decodeCachedResult(payload, vertexCount, simplifiedIndices, resultError);
+    }
+
+    if (!cached) {
+        runSimplifier(geometry, options, targetIndexCount, options.error, simplifiedIndices, resultError);
+
+        if (cache_ && !cacheKey.empty()) {
+            cache_->store(kCacheStage, cacheKey, encodeCachedResult(simplifiedIndices, resultError));
+        }
+    }
+
+    const size_t resultIndexCount = simplifiedIndices.size();
     if (resultIndexCount == 0 || resultIndexCount >= indexCount) {
         summary.reason = "no reduction";
         return false;
     }
 
-    simplifiedIndices.resize(resultIndexCount);
+    // Drop vertices the simplified indices no longer reference, renumbering the
+    // survivors in first-use order so vertex fetch stays sequential
+    bool compactable = true;
+    for (const auto& attribute : primitive.attributes) {
+        compactable = compactable && isCompactable(model, attribute.second, vertexCount);
+    }
+    for (const auto& target : primitive.targets) {
+        for (const auto& attribute : target) {
+            compactable = compactable && isCompactable(model, attribute.second, vertexCount);
+        }
+    }
+
+    if (compactable) {
+        std::vector<unsigned int> remap(vertexCount, kUnusedVertex);
+        unsigned int usedVertices = 0;
+        for (const unsigned int index : simplifiedIndices) {
+            if (remap[index] == kUnusedVertex) {
+                remap[index] = usedVertices++;
+            }
+        }
+
+        if (usedVertices < vertexCount) {
+            for (auto& index : simplifiedIndices) {
+                index = remap[index];
+            }
+            for (auto& attribute : primitive.attributes) {
+                attribute.second = compactAccessor(model, attribute.second, remap, usedVertices);
+            }
+            for (auto& target : primitive.targets) {
+                for (auto& attribute : target) {
+                    attribute.second = compactAccessor(model, attribute.second, remap, usedVertices);
+                }
+            }
+            summary.simplifiedVertices = usedVertices;
+        }
+    }
 
     std::vector<unsigned char> newIndexData;
     const unsigned int maxIndex = *std::max_element(simplifiedIndices.begin(), simplifiedIndices.end());
@@ -276,23 +815,8 @@ bool GltfSimplify::simplifyPrimitive(tinygltf::Primitive& primitive,
         std::memcpy(newIndexData.data(), simplifiedIndices.data(), resultIndexCount * sizeof(uint32_t));
     }
 
-    if (model.buffers.empty()) {
-        model.buffers.emplace_back();
-    }
-
-    const int bufferIdx = 0;
-    const size_t byteOffset = model.buffers[bufferIdx].data.size();
-    model.buffers[bufferIdx].data.insert(model.buffers[bufferIdx].data.end(),
-                                         newIndexData.begin(), newIndexData.end());
-
-    tinygltf::BufferView newBufferView;
-    newBufferView.buffer = bufferIdx;
-    newBufferView.byteOffset = byteOffset;
-    newBufferView.byteLength = newIndexData.size();
-    newBufferView.target = TINYGLTF_TARGET_ELEMENT_ARRAY_BUFFER;
-
-    const int bufferViewIdx = static_cast<int>(model.bufferViews.size());
-    model.bufferViews.push_back(newBufferView);
+    const int bufferViewIdx = arena_->append(newIndexData.data(), newIndexData.size(),
+                                             TINYGLTF_TARGET_ELEMENT_ARRAY_BUFFER);
 
     tinygltf::Accessor newAccessor;
     newAccessor.bufferView = bufferViewIdx;
@@ -317,9 +841,95 @@ bool GltfSimplify::simplifyPrimitive(tinygltf::Primitive& primitive,
     return true;
 }
 
-void GltfSimplify::convertToTriangles(tinygltf::Primitive& primitive, tinygltf::Model& /* model */) {
-    // Simplified conversion placeholder – real conversion would expand strips/fans
-    primitive.mode = TINYGLTF_MODE_TRIANGLES;
+double GltfSimplify::worldErrorBudget(const SimplifyOptions& options) {
+    if (options.errorMode != SimplifyErrorMode::Pixels) {
+        return options.error;
+    }
+    // Height in world units covered by one pixel at viewDistance
+    constexpr double kPi = 3.14159265358979323846;
+    const double halfFov = 0.5 * static_cast<double>(options.fieldOfView) * kPi / 180.0;
+    const double pixelSize = 2.0 * static_cast<double>(options.viewDistance) * std::tan(halfFov) /
+                             std::max(1.0, static_cast<double>(options.viewportHeight));
+    return static_cast<double>(options.error) * pixelSize;
+}
+
+double GltfSimplify::primitiveWorldExtent(tinygltf::Model& model,
+                                          const tinygltf::Primitive& primitive,
+                                          const std::vector<Matrix4>& instances) const {
+    const auto posIt = primitive.attributes.find("POSITION");
+    if (posIt == primitive.attributes.end() || posIt->second < 0 ||
+        posIt->second >= static_cast<int>(model.accessors.size())) {
+        return 0.0;
+    }
+
+    auto& accessor = model.accessors[posIt->second];
+    if (accessor.minValues.size() != 3 || accessor.maxValues.size() != 3) {
+        GltfBounds::computeAccessorBounds(model, posIt->second);
+        if (accessor.minValues.size() != 3 || accessor.maxValues.size() != 3) {
+            return 0.0;
+        }
+    }
+
+    const Vector3 localMin = {accessor.minValues[0], accessor.minValues[1], accessor.minValues[2]};
+    const Vector3 localMax = {accessor.maxValues[0], accessor.maxValues[1], accessor.maxValues[2]};
+
+    // Meshes no node references are measured in their own space
+    const std::vector<Matrix4> identity = {kIdentityMatrix};
+    double extent = 0.0;
+    for (const auto& matrix : instances.empty() ? identity : instances) {
+        Vector3 worldMin;
+        Vector3 worldMax;
+        transformBounds(matrix, localMin, localMax, worldMin, worldMax);
+        for (size_t axis = 0; axis < 3; ++axis) {
+            extent = std::max(extent, worldMax[axis] - worldMin[axis]);
+        }
+    }
+    return extent;
+}
+
+int GltfSimplify::compactAccessor(tinygltf::Model& model,
+                                  int accessorIdx,
+                                  const std::vector<unsigned int>& remap,
+                                  size_t newCount) {
+    const tinygltf::Accessor source = model.accessors[accessorIdx];
+    const auto& view = model.bufferViews[source.bufferView];
+    const size_t elementSize = getAccessorElementSize(source);
+    const size_t sourceStride = view.byteStride != 0 ? view.byteStride : elementSize;
+    const auto& sourceData = model.buffers[view.buffer].data;
+    const size_t sourceOffset = view.byteOffset + source.byteOffset;
+
+    // Vertex attribute elements must start on 4-byte boundaries
+    const size_t stride = (elementSize + 3) & ~size_t(3);
+
+    // Gather the surviving elements into a packed copy, then stage it
+    std::vector<unsigned char> packed(newCount * stride, 0);
+    for (size_t vertex = 0; vertex < remap.size(); ++vertex) {
+        if (remap[vertex] == kUnusedVertex) {
+            continue;
+        }
+        const size_t from = sourceOffset + vertex * sourceStride;
+        if (from + elementSize > sourceData.size()) {
+            throw std::runtime_error("accessor data out of range");
+        }
+        std::memcpy(packed.data() + remap[vertex] * stride, sourceData.data() + from, elementSize);
+    }
+
+    tinygltf::Accessor compacted;
+    compacted.name = source.name;
+    compacted.bufferView = arena_->append(packed.data(), packed.size(), TINYGLTF_TARGET_ARRAY_BUFFER,
+                                          stride != elementSize ? stride : 0);
+    compacted.componentType = source.componentType;
+    compacted.normalized = source.normalized;
+    compacted.type = source.type;
+    compacted.count = newCount;
+    compacted.extras = source.extras;
+
+    const int compactedIdx = static_cast<int>(model.accessors.size());
+    model.accessors.push_back(std::move(compacted));
+
+    // Bounds of a subset are only known for the POSITION-like streams we can recompute
+    pendingBounds_.push_back(compactedIdx);
+    return compactedIdx;
 }
 
 size_t GltfSimplify::getAccessorCount(const tinygltf::Accessor& accessor) const {
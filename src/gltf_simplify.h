@@ -1,18 +1,50 @@
 #pragma once
 
+#include "buffer_arena.h"
+#include "gltf_cache.h"
+#include "math_utils.h"
 #include "tiny_gltf.h"
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace gltfu {
 
+/**
+ * How SimplifyOptions::error is interpreted.
+ */
+enum class SimplifyErrorMode {
+    Relative,   // Fraction of each mesh's extent
+    World,      // Absolute distance in world units
+    Pixels      // Projected pixels at viewDistance for the configured camera
+};
+
+/**
+ * What a triangle budget minimizes when distributing triangles across primitives.
+ */
+enum class SimplifyBudgetObjective {
+    MinMax,     // Smallest worst-case error of any primitive
+    MinSum      // Smallest summed error over all drawn primitive instances
+};
+
 /**
  * Options for the simplify operation.
  */
 struct SimplifyOptions {
     float ratio = 0.0f;          // Target ratio (0-1) of vertices to keep (0 = maximum simplification)
-    float error = 0.0001f;       // Error threshold as fraction of mesh radius (default 0.01%)
+    float error = 0.0001f;       // Error threshold, interpreted according to errorMode
+    SimplifyErrorMode errorMode = SimplifyErrorMode::Relative;
+    float viewDistance = 10.0f;  // Pixels mode: camera distance in world units
+    float fieldOfView = 60.0f;   // Pixels mode: vertical field of view in degrees
+    float viewportHeight = 1080.0f; // Pixels mode: viewport height in pixels
     bool lockBorder = false;     // Lock topological borders of the mesh
+    size_t triangleBudget = 0;   // Rendered scene triangles to fit, counting every node instance of a mesh (0 = disabled; overrides ratio and error)
+    SimplifyBudgetObjective budgetObjective = SimplifyBudgetObjective::MinMax;
+    float normalWeight = 0.0f;   // Weight of NORMAL deviation in the error metric (0 = ignore)
+    float texCoordWeight = 0.0f; // Weight of TEXCOORD_0 deviation in the error metric (0 = ignore)
+    float colorWeight = 0.0f;    // Weight of COLOR_0 deviation in the error metric (0 = ignore)
     bool verbose = false;        // Emit simplification summary
+    std::string cacheDirectory;  // Persistent per-primitive result cache (empty = disabled)
 };
 
 /**
@@ -39,18 +71,83 @@ public:
 private:
     std::string stats_;
     std::string error_;
+    std::unique_ptr<PrimitiveCache> cache_;
+    std::unique_ptr<BufferArena> arena_;    // Output staging for the current process() call
+    std::vector<int> pendingBounds_;        // Compacted accessors whose bounds follow the commit
+
+    // Geometry as fed to meshoptimizer; positions point into the model's buffer
+    struct PrimitiveGeometry {
+        const float* positions = nullptr;
+        size_t positionStride = 0;
+        size_t vertexCount = 0;
+        std::vector<unsigned int> indices;
+        std::vector<float> attributes;          // Interleaved attribute channels used for weighting
+        std::vector<float> attributeWeights;    // One weight per attribute channel
+    };
+
+    // One point on a primitive's error-vs-size curve
+    struct ErrorSample {
+        size_t targetIndexCount = 0;
+        size_t indexCount = 0;
+        double error = 0.0;                     // World-space error
+    };
+
+    struct BudgetSummary {
+        size_t measuredPrimitives = 0;
+        size_t fixedTriangles = 0;              // Triangles that cannot be simplified
+        size_t allocatedTriangles = 0;
+        double maxError = 0.0;
+        double totalError = 0.0;
+        bool fits = true;
+    };
 
     struct PrimitiveSummary {
         size_t originalTriangles = 0;
         size_t simplifiedTriangles = 0;
+        size_t originalVertices = 0;
+        size_t simplifiedVertices = 0;
         float error = 0.0f;
         std::string reason;
     };
 
-    // Simplify a single primitive
+    // Convert options.error to a world-space distance (World and Pixels modes)
+    static double worldErrorBudget(const SimplifyOptions& options);
+
+    // Largest world-space extent of a primitive over every node instancing its mesh
+    double primitiveWorldExtent(tinygltf::Model& model,
+                                const tinygltf::Primitive& primitive,
+                                const std::vector<Matrix4>& instances) const;
+
+    // Read indices, positions and weighted attributes of a triangle primitive
+    bool loadGeometry(const tinygltf::Model& model,
+                      const tinygltf::Primitive& primitive,
+                      const SimplifyOptions& options,
+                      PrimitiveGeometry& geometry,
+                      std::string& reason) const;
+
+    // Run meshoptimizer on loaded geometry, returning the simplified index count
+    size_t runSimplifier(const PrimitiveGeometry& geometry,
+                         const SimplifyOptions& options,
+                         size_t targetIndexCount,
+                         float targetError,
+                         std::vector<unsigned int>& destination,
+                         float& resultError) const;
+
+    // Measure error-vs-size curves and pick a target index count per primitive
+    void allocateTriangleBudget(tinygltf::Model& model,
+                                const SimplifyOptions& options,
+                                const std::vector<std::vector<Matrix4>>& meshInstances,
+                                std::vector<std::vector<size_t>>& targets,
+                                BudgetSummary& budget) const;
+
+    // Triangles a primitive draws, for primitives the budget cannot simplify
+    size_t primitiveTriangleCount(const tinygltf::Model& model, const tinygltf::Primitive& primitive) const;
+
+    // Simplify a single primitive (budgetIndexCount = 0 derives the target from options.ratio)
     bool simplifyPrimitive(tinygltf::Primitive& primitive,
                           tinygltf::Model& model,
                           const SimplifyOptions& options,
+                          size_t budgetIndexCount,
                           PrimitiveSummary& summary);
     
     // Get accessor element count
@@ -59,8 +156,11 @@ private:
     // Get accessor element size in bytes
     size_t getAccessorElementSize(const tinygltf::Accessor& accessor) const;
     
-    // Convert primitive to triangles if needed
-    void convertToTriangles(tinygltf::Primitive& primitive, tinygltf::Model& model);
+    // Copy the remapped subset of an attribute accessor into a new packed accessor
+    int compactAccessor(tinygltf::Model& model,
+                        int accessorIdx,
+                        const std::vector<unsigned int>& remap,
+                        size_t newCount);
 };
 
 } // namespace gltfu
@@ -0,0 +1,421 @@
+#include "gltf_split.h"
+#include "buffer_arena.h"
+#include "gltf_bounds.h"
+#include "gltf_meshlets.h"
+#include "trace.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace gltfu {
+namespace {
+
+constexpr uint32_t kUnmapped = 0xffffffffu;
+
+// Tightly packed view of one vertex stream
+struct StreamSource {
+    const unsigned char* data = nullptr;
+    size_t stride = 0;
+    size_t elementSize = 0;
+    int componentType = 0;
+    int type = 0;
+    bool normalized = false;
+};
+
+// Triangle range [begin, end) of the reordered triangle list
+struct Chunk {
+    size_t begin = 0;
+    size_t end = 0;
+};
+
+bool streamSource(const tinygltf::Model& model, int accessorIdx, size_t vertexCount, StreamSource& source) {
+    if (accessorIdx < 0 || accessorIdx >= static_cast<int>(model.accessors.size())) {
+        return false;
+    }
+    const auto& accessor = model.accessors[accessorIdx];
+    if (accessor.sparse.isSparse || accessor.count < vertexCount || accessor.bufferView < 0 ||
+        accessor.bufferView >= static_cast<int>(model.bufferViews.size())) {
+        return false;
+    }
+    const auto& view = model.bufferViews[accessor.bufferView];
+    if (view.buffer < 0 || view.buffer >= static_cast<int>(model.buffers.size())) {
+        return false;
+    }
+
+    const int componentBytes = tinygltf::GetComponentSizeInBytes(static_cast<uint32_t>(accessor.componentType));
+    const int components = tinygltf::GetNumComponentsInType(static_cast<uint32_t>(accessor.type));
+    if (componentBytes <= 0 || components <= 0) {
+        return false;
+    }
+
+    source.elementSize = static_cast<size_t>(componentBytes) * static_cast<size_t>(components);
+    source.stride = view.byteStride != 0 ? view.byteStride : source.elementSize;
+    const size_t offset = view.byteOffset + accessor.byteOffset;
+    const auto& data = model.buffers[view.buffer].data;
+    if (vertexCount == 0 || offset + (vertexCount - 1) * source.stride + source.elementSize > data.size()) {
+        return false;
+    }
+
+    source.data = data.data() + offset;
+    source.componentType = accessor.componentType;
+    source.type = accessor.type;
+    source.normalized = accessor.normalized;
+    return true;
+}
+
+bool readIndices(const tinygltf::Model& model, const tinygltf::Primitive& prim, size_t vertexCount,
+                 std::vector<uint32_t>& indices) {
+    if (prim.indices < 0) {
+        indices.resize(vertexCount);
+        for (size_t i = 0; i < vertexCount; ++i) {
+            indices[i] = static_cast<uint32_t>(i);
+        }
+        return true;
+    }
+
+    StreamSource source;
+    if (prim.indices >= static_cast<int>(model.accessors.size()) ||
+        !streamSource(model, prim.indices, model.accessors[prim.indices].count, source) ||
+        source.type != TINYGLTF_TYPE_SCALAR) {
+        return false;
+    }
+
+    const size_t count = model.accessors[prim.indices].count;
+    indices.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        const unsigned char* element = source.data + i * source.stride;
+        switch (source.componentType) {
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+                indices[i] = element[0];
+                break;
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
+                uint16_t value;
+                std::memcpy(&value, element, sizeof(value));
+                indices[i] = value;
+                break;
+            }
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+                std::memcpy(&indices[i], element, sizeof(uint32_t));
+                break;
+            default:
+                return false;
+        }
+        if (indices[i] >= vertexCount) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Number of distinct vertices referenced by the triangles in [begin, end)
+size_t countVertices(const std::vector<uint32_t>& indices, const std::vector<uint32_t>& triangles,
+                     size_t begin, size_t end, std::vector<uint32_t>& stamp, uint32_t& epoch) {
+    ++epoch;
+    size_t count = 0;
+    for (size_t t = begin; t < end; ++t) {
+        for (size_t corner = 0; corner < 3; ++corner) {
+            const uint32_t vertex = indices[triangles[t] * 3 + corner];
+            if (stamp[vertex] != epoch) {
+                stamp[vertex] = epoch;
+                ++count;
+            }
+        }
+    }
+    return count;
+}
+
+// Median split on triangle centroids until every chunk fits the limits
+std::vector<Chunk> partition(const std::vector<uint32_t>& indices, const StreamSource& positions,
+                             size_t vertexCount, const SplitOptions& options,
+                             std::vector<uint32_t>& triangles) {
+    const size_t triangleCount = indices.size() / 3;
+    std::vector<float> centroids(triangleCount * 3);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        float sum[3] = {0.0f, 0.0f, 0.0f};
+        for (size_t corner = 0; corner < 3; ++corner) {
+            float p[3];
+            std::memcpy(p, positions.data + indices[t * 3 + corner] * positions.stride, sizeof(p));
+            sum[0] += p[0];
+            sum[1] += p[1];
+            sum[2] += p[2];
+        }
+        for (size_t axis = 0; axis < 3; ++axis) {
+            centroids[t * 3 + axis] = sum[axis] / 3.0f;
+        }
+    }
+
+    triangles.resize(triangleCount);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        triangles[t] = static_cast<uint32_t>(t);
+    }
+
+    std::vector<uint32_t> stamp(vertexCount, 0);
+    uint32_t epoch = 0;
+    std::vector<Chunk> chunks;
+    std::vector<Chunk> stack{{0, triangleCount}};
+    while (!stack.empty()) {
+        const Chunk chunk = stack.back();
+        stack.pop_back();
+
+        const size_t count = chunk.end - chunk.begin;
+        const bool trianglesFit = options.maxTriangles == 0 || count <= options.maxTriangles;
+        if (count <= 1 || (trianglesFit &&
+                           countVertices(indices, triangles, chunk.begin, chunk.end, stamp, epoch) <=
+                               options.maxVertices)) {
+            chunks.push_back(chunk);
+            continue;
+        }
+
+        float lo[3] = {centroids[triangles[chunk.begin] * 3], centroids[triangles[chunk.begin] * 3 + 1],
+                       centroids[triangles[chunk.begin] * 3 + 2]};
+        float hi[3] = {lo[0], lo[1], lo[2]};
+        for (size_t t = chunk.begin; t < chunk.end; ++t) {
+            for (size_t axis = 0; axis < 3; ++axis) {
+                lo[axis] = std::min(lo[axis], centroids[triangles[t] * 3 + axis]);
+                hi[axis] = std::max(hi[axis], centroids[triangles[t] * 3 + axis]);
+            }
+        }
+        size_t axis = 0;
+        for (size_t a = 1; a < 3; ++a) {
+            if (hi[a] - lo[a] > hi[axis] - lo[axis]) {
+                axis = a;
+            }
+        }
+
+        const size_t mid = chunk.begin + count / 2;
+        std::nth_element(triangles.begin() + chunk.begin, triangles.begin() + mid, triangles.begin() + chunk.end,
+                         [&](uint32_t a, uint32_t b) { return centroids[a * 3 + axis] < centroids[b * 3 + axis]; });
+
+        // Push the upper half first so chunks come out in spatial order
+        stack.push_back({mid, chunk.end});
+        stack.push_back({chunk.begin, mid});
+    }
+    return chunks;
+}
+
+int copyStream(tinygltf::Model& model, BufferArena& arena, const StreamSource& source,
+               const std::vector<uint32_t>& vertices) {
+    // Vertex attribute elements must start on 4-byte boundaries
+    const size_t stride = (source.elementSize + 3) & ~size_t(3);
+    std::vector<unsigned char> data(vertices.size() * stride, 0);
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        std::memcpy(data.data() + i * stride, source.data + vertices[i] * source.stride, source.elementSize);
+    }
+
+    tinygltf::Accessor accessor;
+    accessor.bufferView = arena.append(data.data(), data.size(), TINYGLTF_TARGET_ARRAY_BUFFER,
+                                       stride != source.elementSize ? stride : 0);
+    accessor.componentType = source.componentType;
+    accessor.type = source.type;
+    accessor.normalized = source.normalized;
+    accessor.count = vertices.size();
+    model.accessors.push_back(std::move(accessor));
+    return static_cast<int>(model.accessors.size() - 1);
+}
+
+int writeIndices(tinygltf::Model& model, BufferArena& arena, const std::vector<uint32_t>& list,
+                 size_t vertexCount) {
+    std::vector<unsigned char> data;
+    int componentType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT;
+    if (vertexCount <= 256) {
+        componentType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+        data.assign(list.begin(), list.end());
+    } else if (vertexCount <= 65536) {
+        componentType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT;
+        data.resize(list.size() * sizeof(uint16_t));
+        auto* dst = reinterpret_cast<uint16_t*>(data.data());
+        for (size_t i = 0; i < list.size(); ++i) {
+            dst[i] = static_cast<uint16_t>(list[i]);
+        }
+    } else {
+        data.resize(list.size() * sizeof(uint32_t));
+        std::memcpy(data.data(), list.data(), data.size());
+    }
+
+    tinygltf::Accessor accessor;
+    accessor.bufferView = arena.append(data.data(), data.size(), TINYGLTF_TARGET_ELEMENT_ARRAY_BUFFER);
+    accessor.componentType = componentType;
+    accessor.type = TINYGLTF_TYPE_SCALAR;
+    accessor.count = list.size();
+    accessor.minValues = {0.0};
+    accessor.maxValues = {static_cast<double>(vertexCount - 1)};
+    model.accessors.push_back(std::move(accessor));
+    return static_cast<int>(model.accessors.size() - 1);
+}
+
+} // namespace
+
+bool GltfSplit::process(tinygltf::Model& model, const SplitOptions& options) {
+    error_.clear();
+    stats_.clear();
+
+    if (options.maxVertices < 3) {
+        error_ = "maxVertices must be at least 3";
+        return false;
+    }
+
+    size_t splitCount = 0;
+    size_t chunkCount = 0;
+    size_t skipped = 0;
+    size_t largestChunk = 0;
+
+    // Chunk streams are staged and spliced into buffer 0 once at the end;
+    // POSITION bounds are computed after the splice
+    BufferArena arena(model);
+    std::vector<int> pendingBounds;
+
+    for (size_t meshIdx = 0; meshIdx < model.meshes.size(); ++meshIdx) {
+        std::vector<tinygltf::Primitive> primitives;
+        primitives.reserve(model.meshes[meshIdx].primitives.size());
+
+        for (size_t primIdx = 0; primIdx < model.meshes[meshIdx].primitives.size(); ++primIdx) {
+            const tinygltf::Primitive prim = model.meshes[meshIdx].primitives[primIdx];
+            TraceScope traceScope("split", "primitive", static_cast<long long>(meshIdx),
+                                  static_cast<long long>(primIdx));
+
+            const auto posIt = prim.attributes.find("POSITION");
+            const size_t vertexCount =
+                posIt != prim.attributes.end() && posIt->second >= 0 &&
+                        posIt->second < static_cast<int>(model.accessors.size())
+                    ? model.accessors[posIt->second].count
+                    : 0;
+            const size_t indexCount = prim.indices >= 0 && prim.indices < static_cast<int>(model.accessors.size())
+                                          ? model.accessors[prim.indices].count
+                                          : vertexCount;
+
+            // Cheap checks first so primitives under the limits are left untouched
+            const bool oversized = vertexCount > options.maxVertices ||
+                                   (options.maxTriangles != 0 && indexCount / 3 > options.maxTriangles);
+            if (prim.mode != TINYGLTF_MODE_TRIANGLES || vertexCount == 0 || !oversized) {
+                primitives.push_back(prim);
+                continue;
+            }
+
+            std::string reason;
+            StreamSource positions;
+            std::vector<uint32_t> indices;
+            std::vector<std::pair<std::string, StreamSource>> attributes;
+            std::vector<std::vector<std::pair<std::string, StreamSource>>> targets(prim.targets.size());
+
+            if (prim.extensions.count(kMeshletsExtension) > 0) {
+                reason = "has meshlets";
+            } else if (prim.extensions.count("KHR_draco_mesh_compression") > 0) {
+                reason = "Draco compressed";
+            } else if (!streamSource(model, posIt->second, vertexCount, positions) ||
+                       positions.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT ||
+                       positions.type != TINYGLTF_TYPE_VEC3) {
+                reason = "POSITION is not float3";
+            } else if (!readIndices(model, prim, vertexCount, indices) || indices.size() % 3 != 0) {
+                reason = "invalid indices";
+            } else {
+                for (const auto& attr : prim.attributes) {
+                    StreamSource source;
+                    if (!streamSource(model, attr.second, vertexCount, source)) {
+                        reason = "unsupported " + attr.first + " layout";
+                        break;
+                    }
+                    attributes.emplace_back(attr.first, source);
+                }
+                for (size_t t = 0; reason.empty() && t < prim.targets.size(); ++t) {
+                    for (const auto& attr : prim.targets[t]) {
+                        StreamSource source;
+                        if (!streamSource(model, attr.second, vertexCount, source)) {
+                            reason = "unsupported morph target layout";
+                            break;
+                        }
+                        targets[t].emplace_back(attr.first, source);
+                    }
+                }
+            }
+
+            if (!reason.empty()) {
+                ++skipped;
+                primitives.push_back(prim);
+                if (options.verbose) {
+                    std::cout << "[split] Skipped primitive " << meshIdx << ':' << primIdx << " - " << reason
+                              << std::endl;
+                }
+                continue;
+            }
+
+            std::vector<uint32_t> triangles;
+            const std::vector<Chunk> chunks = partition(indices, positions, vertexCount, options, triangles);
+
+            std::vector<uint32_t> remap(vertexCount, kUnmapped);
+            for (const Chunk& chunk : chunks) {
+                std::vector<uint32_t> vertices;
+                std::vector<uint32_t> list;
+                list.reserve((chunk.end - chunk.begin) * 3);
+                for (size_t t = chunk.begin; t < chunk.end; ++t) {
+                    for (size_t corner = 0; corner < 3; ++corner) {
+                        const uint32_t vertex = indices[triangles[t] * 3 + corner];
+                        if (remap[vertex] == kUnmapped) {
+                            remap[vertex] = static_cast<uint32_t>(vertices.size());
+                            vertices.push_back(vertex);
+                        }
+                        list.push_back(remap[vertex]);
+                    }
+                }
+                for (const uint32_t vertex : vertices) {
+                    remap[vertex] = kUnmapped;
+                }
+
+                tinygltf::Primitive part = prim;
+                part.indices = writeIndices(model, arena, list, vertices.size());
+                for (const auto& attr : attributes) {
+                    part.attributes[attr.first] = copyStream(model, arena, attr.second, vertices);
+                    if (attr.first == "POSITION") {
+                        pendingBounds.push_back(part.attributes[attr.first]);
+                    }
+                }
+                for (size_t t = 0; t < targets.size(); ++t) {
+                    for (const auto& attr : targets[t]) {
+                        part.targets[t][attr.first] = copyStream(model, arena, attr.second, vertices);
+                        if (attr.first == "POSITION") {
+                            pendingBounds.push_back(part.targets[t][attr.first]);
+                        }
+                    }
+                }
+                primitives.push_back(std::move(part));
+                largestChunk = std::max(largestChunk, vertices.size());
+            }
+
+            ++splitCount;
+            chunkCount += chunks.size();
+            if (options.verbose) {
+                std::cout << "[split] Primitive " << meshIdx << ':' << primIdx << ": " << indices.size() / 3
+                          << " triangles, " << vertexCount << " vertices -> " << chunks.size() << " chunks"
+                          << std::endl;
+            }
+        }
+
+        model.meshes[meshIdx].primitives = std::move(primitives);
+    }
+
+    arena.commit();
+    for (const int accessorIdx : pendingBounds) {
+        GltfBounds::computeAccessorBounds(model, accessorIdx);
+    }
+
+    std::ostringstream stream;
+    if (splitCount == 0) {
+        stream << "No primitives exceeded the split limits";
+    } else {
+        stream << "Primitives split: " << splitCount << " into " << chunkCount << " chunks (largest "
+               << largestChunk << " vertices)";
+    }
+    if (skipped > 0) {
+        stream << "\nSkipped: " << skipped;
+    }
+    stats_ = stream.str();
+
+    if (options.verbose) {
+        std::cout << "[split] " << stats_ << std::endl;
+    }
+    return true;
+}
+
+} // namespace gltfu
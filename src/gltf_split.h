@@ -0,0 +1,47 @@
+#pragma once
+
+#include "tiny_gltf.h"
+#include <cstddef>
+#include <string>
+
+namespace gltfu {
+
+/**
+ * Options for the split operation.
+ */
+struct SplitOptions {
+    size_t maxVertices = 65536;  // Vertices per chunk; 65536 keeps every chunk on 16-bit indices
+    size_t maxTriangles = 0;     // Triangles per chunk (0 = no triangle limit)
+    bool verbose = false;        // Emit per-primitive chunk counts
+};
+
+/**
+ * Split partitions oversized triangle primitives into spatially coherent
+ * chunks so renderers can frustum-cull them and use narrow index types.
+ *
+ * Triangles are recursively divided at the median centroid along the longest
+ * axis of their centroid bounds until every chunk fits the vertex and triangle
+ * limits. Each chunk becomes a new primitive of the same mesh with the original
+ * material and compacted copies of every attribute and morph target, and its
+ * POSITION accessor carries tight min/max bounds.
+ */
+class GltfSplit {
+public:
+    GltfSplit() = default;
+
+    /**
+     * Split every triangle primitive that exceeds the limits.
+     * @param model The GLTF model to process
+     * @param options Split options
+     * @return true if successful
+     */
+    bool process(tinygltf::Model& model, const SplitOptions& options = SplitOptions());
+    std::string getStats() const { return stats_; }
+    std::string getError() const { return error_; }
+
+private:
+    std::string stats_;
+    std::string error_;
+};
+
+} // namespace gltfu
@@ -0,0 +1,591 @@
+#include "gltf_tile.h"
+#include "gltf_bounds.h"
+#include "gltf_bvh.h"
+#include "gltf_flatten.h"
+#include "gltf_prune.h"
+#include "gltf_simplify.h"
+#include "trace.h"
+
+#include "json.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <unordered_map>
+
+namespace gltfu {
+namespace {
+
+namespace fs = std::filesystem;
+
+// Cells holding every item in one child are shrunk instead of adding a level
+constexpr int kMaxCellShrinks = 32;
+
+size_t meshTriangles(const tinygltf::Model& model, const tinygltf::Mesh& mesh) {
+    size_t triangles = 0;
+    for (const auto& prim : mesh.primitives) {
+        if (prim.mode != TINYGLTF_MODE_TRIANGLES && prim.mode != TINYGLTF_MODE_TRIANGLE_STRIP &&
+            prim.mode != TINYGLTF_MODE_TRIANGLE_FAN) {
+            continue;
+        }
+        size_t count = 0;
+        if (prim.indices >= 0 && prim.indices < static_cast<int>(model.accessors.size())) {
+            count = model.accessors[prim.indices].count;
+        } else {
+            const auto posIt = prim.attributes.find("POSITION");
+            if (posIt != prim.attributes.end() && posIt->second >= 0 &&
+                posIt->second < static_cast<int>(model.accessors.size())) {
+                count = model.accessors[posIt->second].count;
+            }
+        }
+        triangles += prim.mode == TINYGLTF_MODE_TRIANGLES ? count / 3 : (count > 2 ? count - 2 : 0);
+    }
+    return triangles;
+}
+
+double diagonal(const Vector3& min, const Vector3& max) {
+    const double dx = max[0] - min[0];
+    const double dy = max[1] - min[1];
+    const double dz = max[2] - min[2];
+    return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+// 3D Tiles box (center, then three half-axis vectors), converted from Y-up to Z-up
+nlohmann::json boundingBox(const Vector3& min, const Vector3& max) {
+    const double cx = 0.5 * (min[0] + max[0]);
+    const double cy = 0.5 * (min[1] + max[1]);
+    const double cz = 0.5 * (min[2] + max[2]);
+    const double hx = 0.5 * (max[0] - min[0]);
+    const double hy = 0.5 * (max[1] - min[1]);
+    const double hz = 0.5 * (max[2] - min[2]);
+    return nlohmann::json::array({cx, -cz, cy, hx, 0.0, 0.0, 0.0, hz, 0.0, 0.0, 0.0, hy});
+}
+
+// Copy every bufferView into one tightly packed buffer; sources is indexed by bufferView.buffer
+void packBuffers(tinygltf::Model& model, const std::vector<const std::vector<unsigned char>*>& sources) {
+    size_t total = 0;
+    for (const auto& view : model.bufferViews) {
+        total += (view.byteLength + 3) & ~size_t(3);
+    }
+
+    tinygltf::Buffer packed;
+    packed.data.reserve(total);
+    for (auto& view : model.bufferViews) {
+        packed.data.resize((packed.data.size() + 3) & ~size_t(3));
+        const size_t offset = packed.data.size();
+        const std::vector<unsigned char>* source =
+            view.buffer >= 0 && view.buffer < static_cast<int>(sources.size()) ? sources[view.buffer] : nullptr;
+        if (source && view.byteOffset + view.byteLength <= source->size()) {
+            packed.data.insert(packed.data.end(), source->begin() + static_cast<std::ptrdiff_t>(view.byteOffset),
+                               source->begin() + static_cast<std::ptrdiff_t>(view.byteOffset + view.byteLength));
+        } else {
+            packed.data.resize(offset + view.byteLength);
+        }
+        view.buffer = 0;
+        view.byteOffset = offset;
+    }
+
+    model.buffers.clear();
+    if (!model.bufferViews.empty()) {
+        model.buffers.push_back(std::move(packed));
+    }
+}
+
+void repackBuffers(tinygltf::Model& model) {
+    const std::vector<tinygltf::Buffer> previous = std::move(model.buffers);
+    std::vector<const std::vector<unsigned char>*> sources;
+    for (const auto& buffer : previous) {
+        sources.push_back(&buffer.data);
+    }
+    packBuffers(model, sources);
+}
+
+// Assigns compact indices to source resources in first-use order
+struct IndexRemap {
+    std::unordered_map<int, int> map;
+    std::vector<int> order;
+
+    int claim(int index, size_t count) {
+        if (index < 0 || index >= static_cast<int>(count)) {
+            return -1;
+        }
+        const auto inserted = map.emplace(index, static_cast<int>(order.size()));
+        if (inserted.second) {
+            order.push_back(index);
+        }
+        return inserted.first->second;
+    }
+};
+
+// Extensions reference raw data as { "bufferView": N } objects, possibly nested
+void claimExtensionBufferViews(tinygltf::Value& value, IndexRemap& bufferViews, size_t count) {
+    if (value.IsArray()) {
+        for (auto& element : value.Get<tinygltf::Value::Array>()) {
+            claimExtensionBufferViews(element, bufferViews, count);
+        }
+        return;
+    }
+    if (!value.IsObject()) {
+        return;
+    }
+    for (auto& member : value.Get<tinygltf::Value::Object>()) {
+        if (member.first == "bufferView" && member.second.IsInt()) {
+            member.second = tinygltf::Value(bufferViews.claim(member.second.Get<int>(), count));
+        } else {
+            claimExtensionBufferViews(member.second, bufferViews, count);
+        }
+    }
+}
+
+// Build a standalone model holding only what the given root nodes reference.
+// Resources are marked and remapped in one walk, so the cost follows the tile, not the scene.
+void extractTile(const tinygltf::Model& source, const std::vector<int>& nodes, tinygltf::Model& out) {
+    out.asset = source.asset;
+    out.lights = source.lights;
+    out.extensionsRequired = source.extensionsRequired;
+    for (const auto& name : source.extensionsUsed) {
+        if (name != kSceneBvhExtension) {
+            out.extensionsUsed.push_back(name);
+        }
+    }
+
+    IndexRemap nodeMap, meshMap, skinMap, cameraMap, materialMap, accessorMap;
+    IndexRemap textureMap, imageMap, samplerMap, bufferViewMap;
+
+    const auto claimAccessor = [&](int& index) { index = accessorMap.claim(index, source.accessors.size()); };
+    const auto claimNode = [&](int& index) { index = nodeMap.claim(index, source.nodes.size()); };
+
+    tinygltf::Scene scene;
+    scene.nodes = nodes;
+    for (int& root : scene.nodes) {
+        claimNode(root);
+    }
+    scene.nodes.erase(std::remove(scene.nodes.begin(), scene.nodes.end(), -1), scene.nodes.end());
+
+    // Claiming appends to each order list, so these loops also visit everything claimed on the way
+    for (size_t i = 0; i < nodeMap.order.size(); ++i) {
+        tinygltf::Node node = source.nodes[nodeMap.order[i]];
+        for (int& child : node.children) {
+            claimNode(child);
+        }
+        node.children.erase(std::remove(node.children.begin(), node.children.end(), -1), node.children.end());
+        node.mesh = meshMap.claim(node.mesh, source.meshes.size());
+        node.skin = skinMap.claim(node.skin, source.skins.size());
+        node.camera = cameraMap.claim(node.camera, source.cameras.size());
+        out.nodes.push_back(std::move(node));
+
+        // Skins can pull in joints outside the tile roots
+        for (size_t s = out.skins.size(); s < skinMap.order.size(); ++s) {
+            tinygltf::Skin skin = source.skins[skinMap.order[s]];
+            claimAccessor(skin.inverseBindMatrices);
+            claimNode(skin.skeleton);
+            for (int& joint : skin.joints) {
+                claimNode(joint);
+            }
+            skin.joints.erase(std::remove(skin.joints.begin(), skin.joints.end(), -1), skin.joints.end());
+            out.skins.push_back(std::move(skin));
+        }
+    }
+
+    for (const int meshIdx : meshMap.order) {
+        tinygltf::Mesh mesh = source.meshes[meshIdx];
+        for (auto& prim : mesh.primitives) {
+            prim.material = materialMap.claim(prim.material, source.materials.size());
+            claimAccessor(prim.indices);
+            for (auto& attr : prim.attributes) {
+                claimAccessor(attr.second);
+            }
+            for (auto& target : prim.targets) {
+                for (auto& attr : target) {
+                    claimAccessor(attr.second);
+                }
+            }
+            // Draco and meshlet data live in bufferViews named by the primitive extensions
+            for (auto& ext : prim.extensions) {
+                claimExtensionBufferViews(ext.second, bufferViewMap, source.bufferViews.size());
+            }
+        }
+        out.meshes.push_back(std::move(mesh));
+    }
+
+    for (const int cameraIdx : cameraMap.order) {
+        out.cameras.push_back(source.cameras[cameraIdx]);
+    }
+
+    for (const int materialIdx : materialMap.order) {
+        tinygltf::Material material = source.materials[materialIdx];
+        const auto claimTexture = [&](int& index) { index = textureMap.claim(index, source.textures.size()); };
+        claimTexture(material.pbrMetallicRoughness.baseColorTexture.index);
+        claimTexture(material.pbrMetallicRoughness.metallicRoughnessTexture.index);
+        claimTexture(material.normalTexture.index);
+        claimTexture(material.occlusionTexture.index);
+        claimTexture(material.emissiveTexture.index);
+        out.materials.push_back(std::move(material));
+    }
+
+    for (const int textureIdx : textureMap.order) {
+        tinygltf::Texture texture = source.textures[textureIdx];
+        texture.source = imageMap.claim(texture.source, source.images.size());
+        texture.sampler = samplerMap.claim(texture.sampler, source.samplers.size());
+        out.textures.push_back(std::move(texture));
+    }
+
+    for (const int imageIdx : imageMap.order) {
+        tinygltf::Image image = source.images[imageIdx];
+        image.bufferView = bufferViewMap.claim(image.bufferView, source.bufferViews.size());
+        out.images.push_back(std::move(image));
+    }
+
+    for (const int samplerIdx : samplerMap.order) {
+        out.samplers.push_back(source.samplers[samplerIdx]);
+    }
+
+    for (const int accessorIdx : accessorMap.order) {
+        tinygltf::Accessor accessor = source.accessors[accessorIdx];
+        accessor.bufferView = bufferViewMap.claim(accessor.bufferView, source.bufferViews.size());
+        if (accessor.sparse.isSparse) {
+            accessor.sparse.indices.bufferView =
+                bufferViewMap.claim(accessor.sparse.indices.bufferView, source.bufferViews.size());
+            accessor.sparse.values.bufferView =
+                bufferViewMap.claim(accessor.sparse.values.bufferView, source.bufferViews.size());
+        }
+        out.accessors.push_back(std::move(accessor));
+    }
+
+    // Views keep their source buffer index until packing, so the sources map straight across
+    for (const int viewIdx : bufferViewMap.order) {
+        out.bufferViews.push_back(source.bufferViews[viewIdx]);
+    }
+
+    out.scenes.push_back(std::move(scene));
+    out.defaultScene = 0;
+
+    std::vector<const std::vector<unsigned char>*> sources;
+    sources.reserve(source.buffers.size());
+    for (const auto& buffer : source.buffers) {
+        sources.push_back(&buffer.data);
+    }
+    packBuffers(out, sources);
+}
+
+} // namespace
+
+bool GltfTile::process(tinygltf::Model& model, const std::string& outputDir, const TileOptions& options) {
+    error_.clear();
+    stats_.clear();
+    tiles_.clear();
+    items_.clear();
+
+    if (options.maxDepth < 0 || options.maxDepth > 20) {
+        error_ = "maxDepth must be between 0 and 20";
+        return false;
+    }
+    if (options.lodRatio <= 0.0f || options.lodRatio > 1.0f || options.lodErrorScale <= 0.0f) {
+        error_ = "lodRatio must be in (0, 1] and lodErrorScale positive";
+        return false;
+    }
+    if (model.scenes.empty()) {
+        error_ = "Model has no scene to tile";
+        return false;
+    }
+
+    // Bring mesh nodes up to the scene root so they can be distributed individually
+    GltfFlatten::process(model);
+
+    const int sceneIdx = model.defaultScene >= 0 && model.defaultScene < static_cast<int>(model.scenes.size())
+                             ? model.defaultScene
+                             : 0;
+    const std::vector<Matrix4> world = GltfFlatten::computeWorldMatrices(model);
+
+    std::vector<char> meshValid(model.meshes.size(), 0);
+    std::vector<Vector3> meshMin(model.meshes.size());
+    std::vector<Vector3> meshMax(model.meshes.size());
+    std::vector<size_t> meshTriangleCount(model.meshes.size(), 0);
+    for (size_t meshIdx = 0; meshIdx < model.meshes.size(); ++meshIdx) {
+        meshValid[meshIdx] = GltfBounds::computeMeshBounds(model, static_cast<int>(meshIdx), meshMin[meshIdx],
+                                                           meshMax[meshIdx]);
+        meshTriangleCount[meshIdx] = meshTriangles(model, model.meshes[meshIdx]);
+    }
+
+    // Each root subtree is one item, bounded by the world bounds of its meshes
+    size_t skipped = 0;
+    for (const int root : model.scenes[sceneIdx].nodes) {
+        if (root < 0 || root >= static_cast<int>(model.nodes.size())) {
+            continue;
+        }
+        TileItem item;
+        item.node = root;
+        bool found = false;
+        std::vector<char> visited(model.nodes.size(), 0);
+        std::vector<int> stack{root};
+        while (!stack.empty()) {
+            const int nodeIdx = stack.back();
+            stack.pop_back();
+            if (nodeIdx < 0 || nodeIdx >= static_cast<int>(model.nodes.size()) || visited[nodeIdx]) {
+                continue;
+            }
+            visited[nodeIdx] = 1;
+            const auto& node = model.nodes[nodeIdx];
+            stack.insert(stack.end(), node.children.begin(), node.children.end());
+            if (node.mesh < 0 || node.mesh >= static_cast<int>(model.meshes.size()) || !meshValid[node.mesh]) {
+                continue;
+            }
+            Vector3 lo;
+            Vector3 hi;
+            transformBounds(world[nodeIdx], meshMin[node.mesh], meshMax[node.mesh], lo, hi);
+            for (size_t axis = 0; axis < 3; ++axis) {
+                item.min[axis] = found ? std::min(item.min[axis], lo[axis]) : lo[axis];
+                item.max[axis] = found ? std::max(item.max[axis], hi[axis]) : hi[axis];
+            }
+            item.triangles += meshTriangleCount[node.mesh];
+            found = true;
+        }
+        if (!found) {
+            ++skipped;
+            continue;
+        }
+        for (size_t axis = 0; axis < 3; ++axis) {
+            item.centroid[axis] = 0.5 * (item.min[axis] + item.max[axis]);
+        }
+        items_.push_back(item);
+    }
+
+    if (items_.empty()) {
+        error_ = "No geometry to tile";
+        return false;
+    }
+
+    Tile root;
+    root.id = "0";
+    for (size_t i = 0; i < items_.size(); ++i) {
+        root.items.push_back(i);
+        for (size_t axis = 0; axis < 3; ++axis) {
+            root.min[axis] = i == 0 ? items_[i].min[axis] : std::min(root.min[axis], items_[i].min[axis]);
+            root.max[axis] = i == 0 ? items_[i].max[axis] : std::max(root.max[axis], items_[i].max[axis]);
+        }
+    }
+    root.cellMin = root.min;
+    root.cellMax = root.max;
+    tiles_.push_back(std::move(root));
+    {
+        TraceScope traceScope("tile", "subdivide");
+        subdivide(0, options);
+    }
+
+    // Children always follow their parent, so a reverse sweep sees them first
+    size_t leaves = 0;
+    int maxDepth = 0;
+    for (size_t i = tiles_.size(); i-- > 0;) {
+        Tile& tile = tiles_[i];
+        maxDepth = std::max(maxDepth, tile.depth);
+        if (tile.children.empty()) {
+            ++leaves;
+            continue;
+        }
+        double childError = 0.0;
+        for (const size_t child : tile.children) {
+            tile.height = std::max(tile.height, tiles_[child].height + 1);
+            childError = std::max(childError, tiles_[child].geometricError);
+        }
+        const double extent = diagonal(tile.min, tile.max);
+        tile.geometricError = std::max(childError, options.parentLods ? extent * options.lodErrorScale : extent);
+    }
+
+    std::error_code ec;
+    fs::create_directories(fs::path(outputDir) / "tiles", ec);
+    if (ec) {
+        error_ = "Failed to create " + outputDir + ": " + ec.message();
+        return false;
+    }
+
+    size_t files = 0;
+    uintmax_t bytes = 0;
+    for (size_t i = 0; i < tiles_.size(); ++i) {
+        if (!tiles_[i].children.empty() && !options.parentLods) {
+            continue;
+        }
+        const fs::path path = fs::path(outputDir) / "tiles" / (tiles_[i].id + ".glb");
+        if (!writeTile(model, i, path.string(), options)) {
+            return false;
+        }
+        ++files;
+        bytes += fs::file_size(path, ec);
+    }
+
+    std::vector<nlohmann::json> documents(tiles_.size());
+    for (size_t i = tiles_.size(); i-- > 0;) {
+        const Tile& tile = tiles_[i];
+        nlohmann::json& document = documents[i];
+        document["boundingVolume"]["box"] = boundingBox(tile.min, tile.max);
+        document["geometricError"] = tile.geometricError;
+        if (tile.children.empty() || options.parentLods) {
+            document["content"]["uri"] = "tiles/" + tile.id + ".glb";
+        }
+        if (!tile.children.empty()) {
+            nlohmann::json children = nlohmann::json::array();
+            for (const size_t child : tile.children) {
+                children.push_back(std::move(documents[child]));
+            }
+            document["children"] = std::move(children);
+        }
+    }
+    documents[0]["refine"] = "REPLACE";
+
+    nlohmann::json tileset;
+    tileset["asset"]["version"] = "1.1";
+    tileset["asset"]["generator"] = "gltfu";
+    tileset["geometricError"] = std::max(tiles_[0].geometricError, diagonal(tiles_[0].min, tiles_[0].max));
+    tileset["root"] = std::move(documents[0]);
+
+    const fs::path tilesetPath = fs::path(outputDir) / "tileset.json";
+    std::ofstream file(tilesetPath);
+    if (!(file << tileset.dump(2) << '\n')) {
+        error_ = "Failed to write " + tilesetPath.string();
+        return false;
+    }
+
+    std::ostringstream stream;
+    stream << "Tiles: " << tiles_.size() << " (" << leaves << " leaves, depth " << maxDepth << ") from "
+           << items_.size() << " root nodes\n"
+           << "Written: " << files << " GLB files, " << bytes << " bytes";
+    if (skipped > 0) {
+        stream << "\nSkipped " << skipped << " root nodes without geometry";
+    }
+    stats_ = stream.str();
+
+    if (options.verbose) {
+        std::cout << "[tile] " << stats_ << std::endl;
+    }
+    return true;
+}
+
+void GltfTile::subdivide(size_t tileIdx, const TileOptions& options) {
+    size_t triangles = 0;
+    for (const size_t item : tiles_[tileIdx].items) {
+        triangles += items_[item].triangles;
+    }
+    if (tiles_[tileIdx].depth >= options.maxDepth || tiles_[tileIdx].items.size() <= 1 ||
+        triangles <= options.maxTriangles) {
+        return;
+    }
+
+    // Octant bits: 1 = upper X, 2 = upper Z, 4 = upper Y (octree only)
+    const size_t childCount = options.quadtree ? 4 : 8;
+    Vector3 cellMin = tiles_[tileIdx].cellMin;
+    Vector3 cellMax = tiles_[tileIdx].cellMax;
+    std::vector<std::vector<size_t>> buckets(childCount);
+    Vector3 center{};
+    size_t occupied = 0;
+    for (int attempt = 0; attempt < kMaxCellShrinks; ++attempt) {
+        for (size_t axis = 0; axis < 3; ++axis) {
+            center[axis] = 0.5 * (cellMin[axis] + cellMax[axis]);
+        }
+        for (auto& bucket : buckets) {
+            bucket.clear();
+        }
+        for (const size_t item : tiles_[tileIdx].items) {
+            const Vector3& c = items_[item].centroid;
+            const size_t octant = (c[0] >= center[0] ? 1 : 0) | (c[2] >= center[2] ? 2 : 0) |
+                                  (!options.quadtree && c[1] >= center[1] ? 4 : 0);
+            buckets[octant].push_back(item);
+        }
+
+        occupied = 0;
+        size_t last = 0;
+        for (size_t octant = 0; octant < childCount; ++octant) {
+            if (!buckets[octant].empty()) {
+                ++occupied;
+                last = octant;
+            }
+        }
+        if (occupied > 1) {
+            break;
+        }
+        (last & 1 ? cellMin : cellMax)[0] = center[0];
+        (last & 2 ? cellMin : cellMax)[2] = center[2];
+        if (!options.quadtree) {
+            (last & 4 ? cellMin : cellMax)[1] = center[1];
+        }
+    }
+    if (occupied <= 1) {
+        return;
+    }
+
+    for (size_t octant = 0; octant < childCount; ++octant) {
+        if (buckets[octant].empty()) {
+            continue;
+        }
+        Tile child;
+        child.id = tiles_[tileIdx].id + "_" + std::to_string(octant);
+        child.depth = tiles_[tileIdx].depth + 1;
+        child.cellMin = cellMin;
+        child.cellMax = cellMax;
+        (octant & 1 ? child.cellMin : child.cellMax)[0] = center[0];
+        (octant & 2 ? child.cellMin : child.cellMax)[2] = center[2];
+        if (!options.quadtree) {
+            (octant & 4 ? child.cellMin : child.cellMax)[1] = center[1];
+        }
+        child.items = std::move(buckets[octant]);
+        for (size_t i = 0; i < child.items.size(); ++i) {
+            const TileItem& item = items_[child.items[i]];
+            for (size_t axis = 0; axis < 3; ++axis) {
+                child.min[axis] = i == 0 ? item.min[axis] : std::min(child.min[axis], item.min[axis]);
+                child.max[axis] = i == 0 ? item.max[axis] : std::max(child.max[axis], item.max[axis]);
+            }
+        }
+
+        const size_t childIdx = tiles_.size();
+        tiles_.push_back(std::move(child));
+        tiles_[tileIdx].children.push_back(childIdx);
+        subdivide(childIdx, options);
+    }
+}
+
+bool GltfTile::writeTile(const tinygltf::Model& model, size_t tileIdx, const std::string& path,
+                         const TileOptions& options) {
+    TraceScope traceScope("tile", tiles_[tileIdx].id);
+    const Tile& tile = tiles_[tileIdx];
+
+    std::vector<int> nodes;
+    nodes.reserve(tile.items.size());
+    for (const size_t item : tile.items) {
+        nodes.push_back(items_[item].node);
+    }
+
+    tinygltf::Model out;
+    extractTile(model, nodes, out);
+
+    if (!tile.children.empty()) {
+        // Parent LOD: fewer triangles per level, never more error than the tile declares
+        SimplifyOptions simplifyOpts;
+        simplifyOpts.ratio = std::pow(options.lodRatio, static_cast<float>(tile.height));
+        simplifyOpts.error = static_cast<float>(tile.geometricError);
+        simplifyOpts.errorMode = SimplifyErrorMode::World;
+        GltfSimplify simplifier;
+        if (!simplifier.process(out, simplifyOpts)) {
+            error_ = "Failed to simplify LOD for tile " + tile.id + ": " + simplifier.getError();
+            return false;
+        }
+        GltfPrune prune;
+        prune.process(out, PruneOptions());
+        repackBuffers(out);
+    }
+
+    tinygltf::TinyGLTF writer;
+    if (!writer.WriteGltfSceneToFile(&out, path, true, true, false, true)) {
+        error_ = "Failed to write tile " + path;
+        return false;
+    }
+
+    if (options.verbose) {
+        std::cout << "[tile] " << tile.id << ": " << nodes.size() << " nodes, depth " << tile.depth
+                  << ", geometric error " << tile.geometricError << std::endl;
+    }
+    return true;
+}
+
+} // namespace gltfu
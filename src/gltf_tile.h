@@ -0,0 +1,90 @@
+#pragma once
+
+#include "math_utils.h"
+#include "tiny_gltf.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace gltfu {
+
+/**
+ * Options for the tile operation.
+ */
+struct TileOptions {
+    int maxDepth = 6;            // Deepest subdivision level (0 = a single tile)
+    size_t maxTriangles = 200000; // Triangles in a tile before it is subdivided
+    bool quadtree = false;       // Subdivide X and Z only (terrain and city layouts)
+    bool parentLods = false;     // Give inner tiles simplified copies of their descendants
+    float lodRatio = 0.5f;       // Triangle ratio kept per level above the leaves
+    float lodErrorScale = 0.01f; // Allowed LOD error as a fraction of the tile diagonal
+    bool verbose = false;        // Emit per-tile details
+};
+
+/**
+ * Tile splits a model into a spatial octree (or quadtree) of GLB files and
+ * writes a 3D Tiles 1.1 tileset.json index next to them, so clients can stream
+ * only the visible parts of a city-scale merge.
+ *
+ * The scene is flattened first; each root node of the default scene is then
+ * assigned to a tile by the centroid of its world-space bounds. Tiles whose
+ * triangle count exceeds maxTriangles are subdivided until maxDepth. Leaf tiles
+ * hold the original geometry with geometricError 0. With parentLods, inner tiles
+ * hold their descendants simplified to lodRatio per level, bounded by
+ * lodErrorScale times the tile diagonal; without it they have no content and
+ * their geometricError is the full diagonal, so clients refine them right away.
+ *
+ * Bounding volumes are oriented boxes converted from glTF's Y-up to 3D Tiles'
+ * Z-up axes. Animations are not carried into tiles.
+ *
+ * Output layout: <outputDir>/tileset.json and <outputDir>/tiles/<id>.glb.
+ */
+class GltfTile {
+public:
+    GltfTile() = default;
+
+    /**
+     * Tile the model into outputDir.
+     * @param model The GLTF model to tile (flattened in place)
+     * @param outputDir Directory receiving tileset.json and the tiles/ folder
+     * @param options Tiling options
+     * @return true if successful
+     */
+    bool process(tinygltf::Model& model, const std::string& outputDir, const TileOptions& options = TileOptions());
+    std::string getStats() const { return stats_; }
+    std::string getError() const { return error_; }
+
+private:
+    // A scene root node with its world-space bounds
+    struct TileItem {
+        int node = -1;
+        Vector3 min{};
+        Vector3 max{};
+        Vector3 centroid{};
+        size_t triangles = 0;
+    };
+
+    struct Tile {
+        std::string id;
+        Vector3 cellMin{};           // Subdivision cell
+        Vector3 cellMax{};
+        Vector3 min{};               // Tight bounds of the items
+        Vector3 max{};
+        std::vector<size_t> items;   // Items below this tile, in items_
+        std::vector<size_t> children;
+        int depth = 0;
+        int height = 0;              // Levels down to the deepest leaf
+        double geometricError = 0.0;
+    };
+
+    void subdivide(size_t tileIdx, const TileOptions& options);
+    bool writeTile(const tinygltf::Model& model, size_t tileIdx, const std::string& path,
+                   const TileOptions& options);
+
+    std::vector<Tile> tiles_;
+    std::vector<TileItem> items_;
+    std::string stats_;
+    std::string error_;
+};
+
+} // namespace gltfu
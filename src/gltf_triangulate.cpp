@@ -0,0 +1,245 @@
+#include "gltf_triangulate.h"
+#include "buffer_arena.h"
+#include "trace.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace gltfu {
+namespace {
+
+// Read an index accessor; restart receives the primitive restart value of its component type.
+bool readIndices(const tinygltf::Model& model, int accessorIdx, std::vector<uint32_t>& indices,
+                 uint32_t& restart, std::string& reason) {
+    const auto& accessor = model.accessors[accessorIdx];
+    if (accessor.sparse.isSparse) {
+        reason = "sparse indices";
+        return false;
+    }
+    if (accessor.bufferView < 0 || accessor.bufferView >= static_cast<int>(model.bufferViews.size())) {
+        reason = "invalid index bufferView";
+        return false;
+    }
+
+    const auto& view = model.bufferViews[accessor.bufferView];
+    if (view.buffer < 0 || view.buffer >= static_cast<int>(model.buffers.size())) {
+        reason = "invalid index buffer";
+        return false;
+    }
+
+    size_t componentBytes = 0;
+    switch (accessor.componentType) {
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: componentBytes = 1; restart = 0xffu; break;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: componentBytes = 2; restart = 0xffffu; break;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT: componentBytes = 4; restart = 0xffffffffu; break;
+        default:
+            reason = "unsupported index type";
+            return false;
+    }
+
+    const auto& data = model.buffers[view.buffer].data;
+    const size_t offset = view.byteOffset + accessor.byteOffset;
+    if (offset + accessor.count * componentBytes > data.size()) {
+        reason = "index data out of range";
+        return false;
+    }
+
+    const unsigned char* src = data.data() + offset;
+    indices.resize(accessor.count);
+    for (size_t i = 0; i < accessor.count; ++i) {
+        switch (componentBytes) {
+            case 1:
+                indices[i] = src[i];
+                break;
+            case 2: {
+                uint16_t value;
+                std::memcpy(&value, src + i * 2, sizeof(value));
+                indices[i] = value;
+                break;
+            }
+            default:
+                std::memcpy(&indices[i], src + i * 4, sizeof(uint32_t));
+                break;
+        }
+    }
+    return true;
+}
+
+void emitTriangle(uint32_t a, uint32_t b, uint32_t c, std::vector<uint32_t>& out, size_t& degenerate) {
+    if (a == b || b == c || a == c) {
+        ++degenerate;
+        return;
+    }
+    out.push_back(a);
+    out.push_back(b);
+    out.push_back(c);
+}
+
+// Expand one restart-free run of a strip or fan, following the glTF vertex order.
+void expandRun(const uint32_t* run, size_t count, int mode, std::vector<uint32_t>& out, size_t& degenerate) {
+    for (size_t i = 0; i + 2 < count; ++i) {
+        if (mode == TINYGLTF_MODE_TRIANGLE_FAN) {
+            emitTriangle(run[i + 1], run[i + 2], run[0], out, degenerate);
+        } else if (i % 2 == 0) {
+            emitTriangle(run[i], run[i + 1], run[i + 2], out, degenerate);
+        } else {
+            emitTriangle(run[i], run[i + 2], run[i + 1], out, degenerate);
+        }
+    }
+}
+
+} // namespace
+
+bool GltfTriangulate::process(tinygltf::Model& model, const TriangulateOptions& options) {
+    error_.clear();
+    stats_.clear();
+
+    size_t strips = 0;
+    size_t fans = 0;
+    size_t skipped = 0;
+    size_t triangles = 0;
+    size_t degenerate = 0;
+    size_t restarts = 0;
+
+    // Index lists are staged and spliced into buffer 0 once at the end
+    BufferArena arena(model);
+
+    for (size_t meshIdx = 0; meshIdx < model.meshes.size(); ++meshIdx) {
+        auto& mesh = model.meshes[meshIdx];
+        for (size_t primIdx = 0; primIdx < mesh.primitives.size(); ++primIdx) {
+            auto& prim = mesh.primitives[primIdx];
+            if (prim.mode != TINYGLTF_MODE_TRIANGLE_STRIP && prim.mode != TINYGLTF_MODE_TRIANGLE_FAN) {
+                continue;
+            }
+            TraceScope traceScope("triangulate", "primitive", static_cast<long long>(meshIdx),
+                                  static_cast<long long>(primIdx));
+
+            std::string reason;
+            const auto posIt = prim.attributes.find("POSITION");
+            size_t vertexCount = 0;
+            if (posIt != prim.attributes.end() && posIt->second >= 0 &&
+                posIt->second < static_cast<int>(model.accessors.size())) {
+                vertexCount = model.accessors[posIt->second].count;
+            }
+
+            std::vector<uint32_t> source;
+            uint32_t restart = 0;
+            bool ok = vertexCount > 0;
+            if (!ok) {
+                reason = "missing POSITION attribute";
+            } else if (prim.indices >= 0 && prim.indices < static_cast<int>(model.accessors.size())) {
+                ok = readIndices(model, prim.indices, source, restart, reason);
+            } else {
+                source.resize(vertexCount);
+                for (size_t i = 0; i < vertexCount; ++i) {
+                    source[i] = static_cast<uint32_t>(i);
+                }
+            }
+
+            std::vector<uint32_t> list;
+            size_t primitiveDegenerate = 0;
+            size_t primitiveRestarts = 0;
+            if (ok) {
+                list.reserve(source.size() > 2 ? (source.size() - 2) * 3 : 0);
+                size_t runStart = 0;
+                for (size_t i = 0; i <= source.size(); ++i) {
+                    // Only an out-of-range maximum value can be a restart marker
+                    const bool isRestart = i < source.size() && prim.indices >= 0 &&
+                                           source[i] == restart && source[i] >= vertexCount;
+                    if (i == source.size() || isRestart) {
+                        expandRun(source.data() + runStart, i - runStart, prim.mode, list, primitiveDegenerate);
+                        runStart = i + 1;
+                        primitiveRestarts += isRestart ? 1 : 0;
+                    }
+                }
+                if (list.empty()) {
+                    ok = false;
+                    reason = "no non-degenerate triangles";
+                } else if (*std::max_element(list.begin(), list.end()) >= vertexCount) {
+                    ok = false;
+                    reason = "index out of range";
+                }
+            }
+
+            if (!ok) {
+                ++skipped;
+                if (options.verbose) {
+                    std::cout << "[triangulate] Skipped primitive " << meshIdx << ':' << primIdx
+                              << " - " << reason << std::endl;
+                }
+                continue;
+            }
+
+            // Narrowest index type that addresses every vertex
+            std::vector<unsigned char> indexData;
+            int componentType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT;
+            if (vertexCount <= 256) {
+                componentType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+                indexData.assign(list.begin(), list.end());
+            } else if (vertexCount <= 65536) {
+                componentType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT;
+                indexData.resize(list.size() * sizeof(uint16_t));
+                auto* dst = reinterpret_cast<uint16_t*>(indexData.data());
+                for (size_t i = 0; i < list.size(); ++i) {
+                    dst[i] = static_cast<uint16_t>(list[i]);
+                }
+            } else {
+                indexData.resize(list.size() * sizeof(uint32_t));
+                std::memcpy(indexData.data(), list.data(), indexData.size());
+            }
+
+            tinygltf::Accessor accessor;
+            accessor.bufferView = arena.append(indexData.data(), indexData.size(),
+                                               TINYGLTF_TARGET_ELEMENT_ARRAY_BUFFER);
+            accessor.componentType = componentType;
+            accessor.count = list.size();
+            accessor.type = TINYGLTF_TYPE_SCALAR;
+            const auto minMax = std::minmax_element(list.begin(), list.end());
+            accessor.minValues = {static_cast<double>(*minMax.first)};
+            accessor.maxValues = {static_cast<double>(*minMax.second)};
+            model.accessors.push_back(std::move(accessor));
+
+            (prim.mode == TINYGLTF_MODE_TRIANGLE_FAN ? fans : strips)++;
+            if (options.verbose) {
+                std::cout << "[triangulate] " << (prim.mode == TINYGLTF_MODE_TRIANGLE_FAN ? "Fan" : "Strip")
+                          << " primitive " << meshIdx << ':' << primIdx << ": " << list.size() / 3
+                          << " triangles (" << primitiveDegenerate << " degenerate dropped, "
+                          << primitiveRestarts << " restarts)" << std::endl;
+            }
+
+            prim.indices = static_cast<int>(model.accessors.size() - 1);
+            prim.mode = TINYGLTF_MODE_TRIANGLES;
+            triangles += list.size() / 3;
+            degenerate += primitiveDegenerate;
+            restarts += primitiveRestarts;
+        }
+    }
+
+    arena.commit();
+
+    std::ostringstream stream;
+    if (strips + fans == 0 && skipped == 0) {
+        stream << "No strip or fan primitives found";
+    } else {
+        stream << "Primitives triangulated: " << (strips + fans) << " (" << strips << " strips, "
+               << fans << " fans)";
+        stream << "\nTriangles: " << triangles << " (" << degenerate << " degenerate dropped";
+        if (restarts > 0) {
+            stream << ", " << restarts << " restarts";
+        }
+        stream << ")";
+        if (skipped > 0) {
+            stream << "\nSkipped: " << skipped;
+        }
+    }
+    stats_ = stream.str();
+
+    if (options.verbose) {
+        std::cout << "[triangulate] " << stats_ << std::endl;
+    }
+    return true;
+}
+
+} // namespace gltfu
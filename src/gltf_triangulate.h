@@ -0,0 +1,44 @@
+#pragma once
+
+#include "tiny_gltf.h"
+#include <string>
+
+namespace gltfu {
+
+/**
+ * Options for the triangulate operation.
+ */
+struct TriangulateOptions {
+    bool verbose = false;        // Emit per-primitive conversion details
+};
+
+/**
+ * Triangulate rewrites TRIANGLE_STRIP and TRIANGLE_FAN primitives, indexed or
+ * not, as indexed TRIANGLES lists so the join, weld, simplify and compress
+ * passes can process them.
+ *
+ * Winding follows the glTF specification. Degenerate triangles (the usual
+ * way strips are stitched together) are dropped, and an index equal to the
+ * maximum value of its component type that is not a valid vertex is treated
+ * as a primitive restart, as emitted by some legacy exporters.
+ */
+class GltfTriangulate {
+public:
+    GltfTriangulate() = default;
+
+    /**
+     * Convert every strip and fan primitive in the model to a triangle list.
+     * @param model The GLTF model to process
+     * @param options Triangulation options
+     * @return true if successful
+     */
+    bool process(tinygltf::Model& model, const TriangulateOptions& options = TriangulateOptions());
+    std::string getStats() const { return stats_; }
+    std::string getError() const { return error_; }
+
+private:
+    std::string stats_;
+    std::string error_;
+};
+
+} // namespace gltfu
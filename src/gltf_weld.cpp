@@ -1,5 +1,8 @@
 #include "gltf_weld.h"
 
+#include "buffer_arena.h"
+#include "trace.h"
+
 #include <algorithm>
 #include <cstdint>
 #include <cstring>
@@ -259,6 +262,7 @@ std::vector<uint32_t> readIndices(const tinygltf::Primitive& primitive,
 
 bool compactPrimitive(tinygltf::Primitive& primitive,
                       tinygltf::Model& model,
+                      BufferArena& arena,
                       const std::vector<uint32_t>& srcIndices,
                       const std::vector<uint32_t>& remap,
                       uint32_t dstVertexCount) {
@@ -276,26 +280,25 @@ bool compactPrimitive(tinygltf::Primitive& primitive,
     }
 
     const size_t componentBytes = componentSize(dstComponentType);
-    tinygltf::Buffer indexBuffer;
-    indexBuffer.data.resize(indexCount * componentBytes);
+    std::vector<uint8_t> indexData(indexCount * componentBytes);
 
     switch (dstComponentType) {
         case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: {
-            auto* dst = reinterpret_cast<uint8_t*>(indexBuffer.data.data());
+            auto* dst = indexData.data();
             for (size_t i = 0; i < indexCount; ++i) {
                 dst[i] = static_cast<uint8_t>(remap[srcIndices[i]]);
             }
             break;
         }
         case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
-            auto* dst = reinterpret_cast<uint16_t*>(indexBuffer.data.data());
+            auto* dst = reinterpret_cast<uint16_t*>(indexData.data());
             for (size_t i = 0; i < indexCount; ++i) {
                 dst[i] = static_cast<uint16_t>(remap[srcIndices[i]]);
             }
             break;
         }
         default: {
-            auto* dst = reinterpret_cast<uint32_t*>(indexBuffer.data.data());
+            auto* dst = reinterpret_cast<uint32_t*>(indexData.data());
             for (size_t i = 0; i < indexCount; ++i) {
                 dst[i] = remap[srcIndices[i]];
             }
@@ -303,16 +306,7 @@ bool compactPrimitive(tinygltf::Primitive& primitive,
         }
     }
 
-    const int indexBufferIdx = static_cast<int>(model.buffers.size());
-    model.buffers.push_back(indexBuffer);
-
-    tinygltf::BufferView indexView;
-    indexView.buffer = indexBufferIdx;
-    indexView.byteOffset = 0;
-    indexView.byteLength = indexBuffer.data.size();
-    indexView.target = TINYGLTF_TARGET_ELEMENT_ARRAY_BUFFER;
-    const int indexViewIdx = static_cast<int>(model.bufferViews.size());
-    model.bufferViews.push_back(indexView);
+    const int indexViewIdx = arena.append(indexData.data(), indexData.size(), TINYGLTF_TARGET_ELEMENT_ARRAY_BUFFER);
 
     tinygltf::Accessor indexAccessor;
     indexAccessor.bufferView = indexViewIdx;
@@ -338,8 +332,7 @@ bool compactPrimitive(tinygltf::Primitive& primitive,
             continue;
         }
 
-        tinygltf::Buffer attributeBuffer;
-        attributeBuffer.data.resize(static_cast<size_t>(dstVertexCount) * stride);
+        std::vector<uint8_t> attributeData(static_cast<size_t>(dstVertexCount) * stride);
 
         std::vector<char> written(dstVertexCount, 0);
         for (size_t i = 0; i < indexCount; ++i) {
@@ -350,21 +343,12 @@ bool compactPrimitive(tinygltf::Primitive& primitive,
             }
 
             const uint8_t* src = srcData + static_cast<size_t>(srcIdx) * stride;
-            uint8_t* dst = attributeBuffer.data.data() + static_cast<size_t>(dstIdx) * stride;
+            uint8_t* dst = attributeData.data() + static_cast<size_t>(dstIdx) * stride;
             std::memcpy(dst, src, stride);
             written[dstIdx] = 1;
         }
 
-        const int bufferIdx = static_cast<int>(model.buffers.size());
-        model.buffers.push_back(attributeBuffer);
-
-        tinygltf::BufferView view;
-        view.buffer = bufferIdx;
-        view.byteOffset = 0;
-        view.byteLength = model.buffers[bufferIdx].data.size();
-        view.target = TINYGLTF_TARGET_ARRAY_BUFFER;
-        const int viewIdx = static_cast<int>(model.bufferViews.size());
-        model.bufferViews.push_back(view);
+        const int viewIdx = arena.append(attributeData.data(), attributeData.size(), TINYGLTF_TARGET_ARRAY_BUFFER);
 
         tinygltf::Accessor accessor;
         accessor.bufferView = viewIdx;
@@ -386,6 +370,7 @@ bool compactPrimitive(tinygltf::Primitive& primitive,
 
 bool weldPrimitive(tinygltf::Primitive& primitive,
                    tinygltf::Model& model,
+                   BufferArena& arena,
                    const WeldOptions& options) {
     if (primitive.indices >= 0 && !options.overwrite) {
         return true;
@@ -446,7 +431,7 @@ bool weldPrimitive(tinygltf::Primitive& primitive,
                   << " vertices (" << (vertexCount - dstVertexCount) << " removed)" << std::endl;
     }
 
-    return compactPrimitive(primitive, model, sourceIndices, remap, dstVertexCount);
+    return compactPrimitive(primitive, model, arena, sourceIndices, remap, dstVertexCount);
 }
 
 } // namespace
@@ -455,10 +440,17 @@ bool GltfWeld::process(tinygltf::Model& model, const WeldOptions& options) {
     int weldedPrimitives = 0;
     int touchedMeshes = 0;
 
-    for (auto& mesh : model.meshes) {
+    // Welded streams are staged and spliced into buffer 0 once, after every primitive
+    BufferArena arena(model);
+
+    for (size_t meshIdx = 0; meshIdx < model.meshes.size(); ++meshIdx) {
+        auto& mesh = model.meshes[meshIdx];
         bool meshChanged = false;
-        for (auto& primitive : mesh.primitives) {
-            if (weldPrimitive(primitive, model, options)) {
+        for (size_t primIdx = 0; primIdx < mesh.primitives.size(); ++primIdx) {
+            auto& primitive = mesh.primitives[primIdx];
+            TraceScope traceScope("weld", "primitive", static_cast<long long>(meshIdx),
+                                  static_cast<long long>(primIdx));
+            if (weldPrimitive(primitive, model, arena, options)) {
                 meshChanged = true;
                 ++weldedPrimitives;
             }
@@ -467,6 +459,7 @@ bool GltfWeld::process(tinygltf::Model& model, const WeldOptions& options) {
             ++touchedMeshes;
         }
     }
+    arena.commit();
 
     if (options.verbose) {
         std::cout << "Weld complete: processed " << touchedMeshes << " meshes, welded "
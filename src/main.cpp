@@ -6,14 +6,25 @@
 #include "gltf_weld.h"
 #include "gltf_prune.h"
 #include "gltf_simplify.h"
+#include "gltf_triangulate.h"
+#include "gltf_meshlets.h"
+#include "gltf_split.h"
+#include "gltf_bvh.h"
+#include "gltf_tile.h"
 #include "gltf_info.h"
 #include "gltf_compress.h"
+#include "gltf_decompress.h"
 #include "gltf_bounds.h"
+#include "gltf_cache.h"
+#include "pipeline_profiler.h"
+#include "trace.h"
 #include "progress_reporter.h"
 
 #include <iostream>
+#include <memory>
 #include <vector>
 #include <string>
+#include <sstream>
 #include <algorithm>
 
 // Helper function to check if filename ends with .glb
@@ -24,6 +35,18 @@ bool isGlbFile(const std::string& filename) {
     return ext == ".glb";
 }
 
+// Map the --error-mode value (already validated by CLI11) to the simplify enum
+gltfu::SimplifyErrorMode parseErrorMode(const std::string& mode) {
+    if (mode == "world") return gltfu::SimplifyErrorMode::World;
+    if (mode == "pixels") return gltfu::SimplifyErrorMode::Pixels;
+    return gltfu::SimplifyErrorMode::Relative;
+}
+
+gltfu::SimplifyBudgetObjective parseBudgetObjective(const std::string& objective) {
+    return objective == "minsum" ? gltfu::SimplifyBudgetObjective::MinSum
+                                 : gltfu::SimplifyBudgetObjective::MinMax;
+}
+
 int main(int argc, char** argv) {
     CLI::App app{"gltfu - Memory-efficient GLTF operations tool"};
     app.require_subcommand(1);
@@ -33,6 +56,14 @@ int main(int argc, char** argv) {
     app.add_flag("--json-progress", jsonProgress, 
                  "Output progress reports as JSON (one per line)")
         ->group("Global");
+
+    // Global option for recording a Chrome trace / Perfetto timeline
+    std::string tracePath;
+    app.add_option("--trace", tracePath,
+                   "Record a timeline of the run in Chrome Trace Event format (open in Perfetto)")
+        ->group("Global")
+        ->trigger_on_parse()
+        ->each([](const std::string&) { gltfu::Tracer::enable(); });
     
     // Merge subcommand
     auto* mergeCmd = app.add_subcommand("merge", "Merge multiple GLTF files or scenes");
@@ -46,6 +77,12 @@ int main(int argc, char** argv) {
     bool prettyPrint = true;
     bool writeBinary = false;
     std::vector<int> sceneIndices;
+    int mergeJobs = 0;
+    int mergePrefetch = 0;
+    bool mergePresize = false;
+    std::string mergeSpillDir;
+    bool mergeTree = false;
+    bool mergeDedup = false;
     
     mergeCmd->add_option("inputs", inputFiles, "Input GLTF files")
         ->required()
@@ -63,6 +100,26 @@ int main(int argc, char** argv) {
     mergeCmd->add_option("--scenes", sceneIndices, 
                         "Specific scene indices to merge (not yet implemented)");
     
+    mergeCmd->add_option("-j,--jobs", mergeJobs,
+                        "Loader threads parsing inputs ahead of the merge (default: 0 = all cores, 1 = serial)")
+        ->check(CLI::NonNegativeNumber);
+    
+    mergeCmd->add_option("--prefetch", mergePrefetch,
+                        "Parsed inputs held ahead of the merge (default: 0 = twice the jobs)")
+        ->check(CLI::NonNegativeNumber);
+    
+    mergeCmd->add_flag("--presize", mergePresize,
+                       "Scan every input's header first and allocate the merged model once");
+    
+    mergeCmd->add_option("--spill-dir", mergeSpillDir,
+                        "Append binary data to a temporary file in this directory instead of memory");
+    
+    mergeCmd->add_flag("--tree", mergeTree,
+                       "Merge groups of inputs in parallel and combine them pairwise (not with --spill-dir)");
+    
+    mergeCmd->add_flag("--dedup", mergeDedup,
+                       "Reuse identical accessors, images, samplers, textures and materials while merging");
+    
     mergeCmd->add_flag("--embed-images", embedImages, 
                        "Embed images in output file");
     
@@ -86,21 +143,38 @@ int main(int argc, char** argv) {
             writeBinary = true;
         }
         
+        // Checked before merging so a long spilled merge does not fail at save time
+        if (!mergeSpillDir.empty() && embedBuffers && !writeBinary) {
+            progress.error("merge", "--embed-buffers needs .glb output when used with --spill-dir");
+            return 1;
+        }
+        
         progress.report("merge", "Starting merge of " + std::to_string(inputFiles.size()) + " file(s)", 0.0);
         
         gltfu::GltfMerger merger;
-        
-        // Load and merge files one at a time (memory efficient)
-        for (size_t i = 0; i < inputFiles.size(); ++i) {
+        gltfu::MergeOptions mergeOptions;
+        mergeOptions.keepScenesIndependent = keepScenesIndependent;
+        mergeOptions.defaultScenesOnly = defaultScenesOnly;
+        mergeOptions.jobs = mergeJobs;
+        mergeOptions.prefetch = mergePrefetch;
+        mergeOptions.presize = mergePresize;
+        mergeOptions.spillDirectory = mergeSpillDir;
+        mergeOptions.tree = mergeTree;
+        mergeOptions.dedup = mergeDedup;
+        
+        // Inputs are parsed ahead on loader threads and merged in order (memory bounded by --prefetch)
+        const bool merged = merger.mergeFiles(inputFiles, mergeOptions, [&](size_t i) {
             double loadProgress = static_cast<double>(i) / inputFiles.size(); 
-            progress.report("merge", "Loading and merging file " + std::to_string(i + 1) + "/" + std::to_string(inputFiles.size()), 
+            progress.report("merge", "Merging file " + std::to_string(i + 1) + "/" + std::to_string(inputFiles.size()), 
                           loadProgress, inputFiles[i]);
-            
-            // Pass flags: keepScenesIndependent and defaultScenesOnly
-            if (!merger.loadAndMergeFile(inputFiles[i], keepScenesIndependent, defaultScenesOnly)) {
-                progress.error("merge", merger.getError());
-                return 1;
-            }
+        });
+        if (!merged) {
+            progress.error("merge", merger.getError());
+            return 1;
+        }
+        
+        if (mergeDedup) {
+            progress.report("merge", "Dedup complete", 0.7, merger.getStats());
         }
         
         if (!sceneIndices.empty()) {
@@ -664,73 +738,61 @@ int main(int argc, char** argv) {
         return 0;
     });
     
-    // Prune subcommand
-    auto* pruneCmd = app.add_subcommand("prune", "Remove unused resources not referenced by any scene");
+    // Triangulate subcommand
+    auto* triangulateCmd = app.add_subcommand("triangulate", "Convert triangle strips and fans to triangle lists");
     
-    std::string pruneInputFile;
-    std::string pruneOutputFile;
-    bool keepLeaves = false;
-    bool keepAttributes = false;
-    bool keepExtras = false;
-    bool pruneVerbose = false;
-    bool pruneEmbedImages = false;
-    bool pruneEmbedBuffers = false;
-    bool prunePrettyPrint = true;
-    bool pruneWriteBinary = false;
+    std::string triangulateInputFile;
+    std::string triangulateOutputFile;
+    bool triangulateVerbose = false;
+    bool triangulateEmbedImages = false;
+    bool triangulateEmbedBuffers = false;
+    bool triangulatePrettyPrint = true;
+    bool triangulateWriteBinary = false;
     
-    pruneCmd->add_option("input", pruneInputFile, "Input GLTF file")
+    triangulateCmd->add_option("input", triangulateInputFile, "Input GLTF file")
         ->required()
         ->check(CLI::ExistingFile);
     
-    pruneCmd->add_option("-o,--output", pruneOutputFile, "Output GLTF file")
+    triangulateCmd->add_option("-o,--output", triangulateOutputFile, "Output GLTF file")
         ->required();
     
-    pruneCmd->add_flag("--keep-leaves", keepLeaves,
-                      "Keep empty leaf nodes");
-    
-    pruneCmd->add_flag("--keep-attributes", keepAttributes,
-                      "Keep unused vertex attributes");
+    triangulateCmd->add_flag("-v,--verbose", triangulateVerbose,
+                             "Show per-primitive conversion details");
     
-    pruneCmd->add_flag("--keep-extras", keepExtras,
-                      "Prevent pruning properties with custom extras");
-
-    pruneCmd->add_flag("-v,--verbose", pruneVerbose,
-                      "Show pruning summary");
+    triangulateCmd->add_flag("--embed-images", triangulateEmbedImages, 
+                             "Embed images in output file");
     
-    pruneCmd->add_flag("--embed-images", pruneEmbedImages, 
-                      "Embed images in output file");
+    triangulateCmd->add_flag("--embed-buffers", triangulateEmbedBuffers, 
+                             "Embed buffers in output file");
     
-    pruneCmd->add_flag("--embed-buffers", pruneEmbedBuffers, 
-                      "Embed buffers in output file");
+    triangulateCmd->add_flag("--no-pretty-print", 
+                             [&triangulatePrettyPrint](int count) { triangulatePrettyPrint = !count; },
+                             "Disable JSON pretty printing");
     
-    pruneCmd->add_flag("--no-pretty-print", 
-                      [&prunePrettyPrint](int count) { prunePrettyPrint = !count; },
-                      "Disable JSON pretty printing");
+    triangulateCmd->add_flag("--binary", triangulateWriteBinary, 
+                             "Write binary .glb output (auto-detected from .glb extension)");
     
-    pruneCmd->add_flag("--binary", pruneWriteBinary, 
-                       "Write binary .glb output (auto-detected from .glb extension)");
-
-    pruneCmd->callback([&]() {
+    triangulateCmd->callback([&]() {
         gltfu::ProgressReporter progress(
             jsonProgress ? gltfu::ProgressReporter::Format::JSON : gltfu::ProgressReporter::Format::Text
         );
         
         // Auto-detect binary format from output file extension
-        if (!pruneWriteBinary && isGlbFile(pruneOutputFile)) {
-            pruneWriteBinary = true;
+        if (!triangulateWriteBinary && isGlbFile(triangulateOutputFile)) {
+            triangulateWriteBinary = true;
         }
         
-        progress.report("prune", "Loading file", 0.0, pruneInputFile);
+        progress.report("triangulate", "Loading file", 0.0, triangulateInputFile);
         
         tinygltf::Model model;
         tinygltf::TinyGLTF loader;
         std::string err, warn;
         
         bool ret;
-        if (pruneInputFile.size() >= 4 && pruneInputFile.substr(pruneInputFile.size()-4) == ".glb") {
-            ret = loader.LoadBinaryFromFile(&model, &err, &warn, pruneInputFile);
+        if (isGlbFile(triangulateInputFile)) {
+            ret = loader.LoadBinaryFromFile(&model, &err, &warn, triangulateInputFile);
         } else {
-            ret = loader.LoadASCIIFromFile(&model, &err, &warn, pruneInputFile);
+            ret = loader.LoadASCIIFromFile(&model, &err, &warn, triangulateInputFile);
         }
         
         if (!warn.empty() && !jsonProgress) {
@@ -738,140 +800,123 @@ int main(int argc, char** argv) {
         }
         
         if (!ret) {
-            progress.error("prune", "Failed to load: " + err);
+            progress.error("triangulate", "Failed to load: " + err);
             return 1;
         }
         
-        // Prune unused resources
-        progress.report("prune", "Pruning unused resources", 0.3);
-        gltfu::GltfPrune pruner;
-        gltfu::PruneOptions options;
-        options.keepLeaves = keepLeaves;
-        options.keepAttributes = keepAttributes;
-        options.keepExtras = keepExtras;
-        options.verbose = pruneVerbose;
-
-        if (!pruner.process(model, options)) {
-            const auto error = pruner.getError();
-            progress.error("prune", error.empty() ? "Prune operation failed" : error);
+        progress.report("triangulate", "Converting strips and fans", 0.3);
+        gltfu::GltfTriangulate triangulator;
+        gltfu::TriangulateOptions options;
+        options.verbose = triangulateVerbose;
+        
+        if (!triangulator.process(model, options)) {
+            progress.error("triangulate", triangulator.getError());
             return 1;
         }
-
-        const auto stats = pruner.getStats();
-        if (!stats.empty()) {
-            if (jsonProgress || pruneVerbose) {
-                progress.report("prune", "Pruning complete", 0.6, stats);
-            } else {
-                std::cout << stats << std::endl;
-            }
+        
+        if (jsonProgress || triangulateVerbose) {
+            progress.report("triangulate", "Triangulation complete", 0.6, triangulator.getStats());
+        } else {
+            std::cout << triangulator.getStats() << std::endl;
         }
         
         // When writing to GLB, clear buffer URIs so data is embedded in binary chunk
-        if (pruneWriteBinary) {
+        if (triangulateWriteBinary) {
             for (auto& buffer : model.buffers) {
                 buffer.uri.clear();
             }
         }
         
-        // Write output
-        progress.report("prune", "Writing output", 0.9, pruneOutputFile);
+        progress.report("triangulate", "Writing output", 0.9, triangulateOutputFile);
         bool writeRet;
-        if (pruneWriteBinary) {
-            // GLB format must embed buffers in the binary chunk
-            writeRet = loader.WriteGltfSceneToFile(&model, pruneOutputFile, 
-                                                   pruneEmbedImages, 
+        if (triangulateWriteBinary) {
+            writeRet = loader.WriteGltfSceneToFile(&model, triangulateOutputFile, 
+                                                   triangulateEmbedImages, 
                                                    true, 
-                                                   prunePrettyPrint, 
+                                                   triangulatePrettyPrint, 
                                                    true);
         } else {
-            writeRet = loader.WriteGltfSceneToFile(&model, pruneOutputFile, 
-                                                   pruneEmbedImages, 
-                                                   pruneEmbedBuffers, 
-                                                   prunePrettyPrint, 
+            writeRet = loader.WriteGltfSceneToFile(&model, triangulateOutputFile, 
+                                                   triangulateEmbedImages, 
+                                                   triangulateEmbedBuffers, 
+                                                   triangulatePrettyPrint, 
                                                    false);
         }
         
         if (!writeRet) {
-            progress.error("prune", "Failed to write output file: " + pruneOutputFile);
+            progress.error("triangulate", "Failed to write output file: " + triangulateOutputFile);
             return 1;
         }
         
-        progress.success("prune", "Written to: " + pruneOutputFile);
+        progress.success("triangulate", "Written to: " + triangulateOutputFile);
         return 0;
     });
     
-    // Simplify subcommand
-    auto* simplifyCmd = app.add_subcommand("simplify", "Reduce mesh complexity using meshoptimizer");
-    
-    std::string simplifyInputFile;
-    std::string simplifyOutputFile;
-    float simplifyRatio = 0.5f;
-    float simplifyError = 0.01f;
-    bool simplifyLockBorder = false;
-    bool simplifyVerbose = false;
+    // Split subcommand
+    auto* splitCmd = app.add_subcommand("split", "Split oversized primitives into spatially coherent chunks");
     
-    bool simplifyEmbedImages = false;
-    bool simplifyEmbedBuffers = false;
-    bool simplifyPrettyPrint = true;
-    bool simplifyWriteBinary = false;
+    std::string splitInputFile;
+    std::string splitOutputFile;
+    size_t splitMaxVertices = 65536;
+    size_t splitMaxTriangles = 0;
+    bool splitVerbose = false;
+    bool splitEmbedImages = false;
+    bool splitEmbedBuffers = false;
+    bool splitPrettyPrint = true;
+    bool splitWriteBinary = false;
     
-    simplifyCmd->add_option("input", simplifyInputFile, "Input GLTF file")
+    splitCmd->add_option("input", splitInputFile, "Input GLTF file")
         ->required()
         ->check(CLI::ExistingFile);
     
-    simplifyCmd->add_option("-o,--output", simplifyOutputFile, "Output GLTF file")
+    splitCmd->add_option("-o,--output", splitOutputFile, "Output GLTF file")
         ->required();
     
-    simplifyCmd->add_option("-r,--ratio", simplifyRatio, 
-        "Target ratio of triangles to keep (0.0-1.0, default 0.5)")
-        ->check(CLI::Range(0.0, 1.0));
-    
-    simplifyCmd->add_option("-e,--error", simplifyError,
-        "Maximum error threshold (default 0.01)")
+    splitCmd->add_option("--max-vertices", splitMaxVertices,
+                         "Maximum vertices per chunk (default: 65536, fits 16-bit indices)")
         ->check(CLI::PositiveNumber);
     
-    simplifyCmd->add_flag("-l,--lock-border", simplifyLockBorder,
-        "Lock border vertices to prevent mesh from shrinking");
-
-    simplifyCmd->add_flag("-v,--verbose", simplifyVerbose,
-        "Show simplification summary");
+    splitCmd->add_option("--max-triangles", splitMaxTriangles,
+                         "Maximum triangles per chunk, 0 for no limit (default: 0)")
+        ->check(CLI::NonNegativeNumber);
     
-    simplifyCmd->add_flag("--embed-images", simplifyEmbedImages, 
-        "Embed images as data URIs");
+    splitCmd->add_flag("-v,--verbose", splitVerbose,
+                       "Show per-primitive chunk counts");
     
-    simplifyCmd->add_flag("--embed-buffers", simplifyEmbedBuffers, 
-        "Embed buffers as data URIs");
+    splitCmd->add_flag("--embed-images", splitEmbedImages, 
+                       "Embed images in output file");
     
-    simplifyCmd->add_flag("!--no-pretty-print,!--ugly", simplifyPrettyPrint, 
-        "Disable pretty printing JSON");
+    splitCmd->add_flag("--embed-buffers", splitEmbedBuffers, 
+                       "Embed buffers in output file");
     
-    simplifyCmd->add_flag("-b,--binary", simplifyWriteBinary, 
-        "Write output as GLB (binary) (auto-detected from .glb extension)");
+    splitCmd->add_flag("--no-pretty-print", 
+                       [&splitPrettyPrint](int count) { splitPrettyPrint = !count; },
+                       "Disable JSON pretty printing");
     
-    simplifyCmd->callback([&]() {
+    splitCmd->add_flag("--binary", splitWriteBinary, 
+                       "Write binary .glb output (auto-detected from .glb extension)");
+    
+    splitCmd->callback([&]() {
         gltfu::ProgressReporter progress(
             jsonProgress ? gltfu::ProgressReporter::Format::JSON : gltfu::ProgressReporter::Format::Text
         );
         
-        if (simplifyOutputFile.empty()) {
-            simplifyOutputFile = simplifyInputFile;
-        }
-        
         // Auto-detect binary format from output file extension
-        if (!simplifyWriteBinary && isGlbFile(simplifyOutputFile)) {
-            simplifyWriteBinary = true;
+        if (!splitWriteBinary && isGlbFile(splitOutputFile)) {
+            splitWriteBinary = true;
         }
         
-        progress.report("simplify", "Loading file", 0.0, simplifyInputFile);
+        progress.report("split", "Loading file", 0.0, splitInputFile);
+        
         tinygltf::Model model;
         tinygltf::TinyGLTF loader;
         std::string err, warn;
         
         bool ret;
-        if (simplifyInputFile.size() >= 4 && simplifyInputFile.substr(simplifyInputFile.size()-4) == ".glb") {
-            ret = loader.LoadBinaryFromFile(&model, &err, &warn, simplifyInputFile);
+        if (isGlbFile(splitInputFile)) {
+            ret = loader.LoadBinaryFromFile(&model, &err, &warn, splitInputFile);
         } else {
-            ret = loader.LoadASCIIFromFile(&model, &err, &warn, simplifyInputFile);
+            ret = loader.LoadASCIIFromFile(&model, &err, &warn, splitInputFile);
         }
         
         if (!warn.empty() && !jsonProgress) {
@@ -879,149 +924,1105 @@ int main(int argc, char** argv) {
         }
         
         if (!ret) {
-            progress.error("simplify", "Failed to load: " + err);
+            progress.error("split", "Failed to load: " + err);
             return 1;
         }
         
-        // Simplify meshes
-        progress.report("simplify", "Simplifying meshes", 0.3);
-        gltfu::GltfSimplify simplifier;
-        gltfu::SimplifyOptions options;
-        options.ratio = simplifyRatio;
-        options.error = simplifyError;
-        options.lockBorder = simplifyLockBorder;
-        options.verbose = simplifyVerbose;
+        progress.report("split", "Splitting primitives", 0.3);
+        gltfu::GltfSplit splitter;
+        gltfu::SplitOptions options;
+        options.maxVertices = splitMaxVertices;
+        options.maxTriangles = splitMaxTriangles;
+        options.verbose = splitVerbose;
         
-        if (!simplifier.process(model, options)) {
-            const auto error = simplifier.getError();
-            progress.error("simplify", error.empty() ? "Simplify operation failed" : error);
+        if (!splitter.process(model, options)) {
+            progress.error("split", splitter.getError());
             return 1;
         }
-
-        const auto simplifyStats = simplifier.getStats();
-        if (!simplifyStats.empty()) {
-            if (jsonProgress || simplifyVerbose) {
-                progress.report("simplify", "Simplification complete", 0.6, simplifyStats);
-            } else {
-                std::cout << simplifyStats << std::endl;
-            }
+        
+        if (jsonProgress || splitVerbose) {
+            progress.report("split", "Split complete", 0.6, splitter.getStats());
+        } else {
+            std::cout << splitter.getStats() << std::endl;
         }
         
         // When writing to GLB, clear buffer URIs so data is embedded in binary chunk
-        if (simplifyWriteBinary) {
+        if (splitWriteBinary) {
             for (auto& buffer : model.buffers) {
                 buffer.uri.clear();
             }
         }
         
-        // Write output
-        progress.report("simplify", "Writing output", 0.9, simplifyOutputFile);
+        progress.report("split", "Writing output", 0.9, splitOutputFile);
         bool writeRet;
-        if (simplifyWriteBinary) {
-            // GLB format must embed buffers in the binary chunk
-            writeRet = loader.WriteGltfSceneToFile(&model, simplifyOutputFile, 
-                                                   simplifyEmbedImages, 
+        if (splitWriteBinary) {
+            writeRet = loader.WriteGltfSceneToFile(&model, splitOutputFile, 
+                                                   splitEmbedImages, 
                                                    true, 
-                                                   simplifyPrettyPrint, 
+                                                   splitPrettyPrint, 
                                                    true);
         } else {
-            writeRet = loader.WriteGltfSceneToFile(&model, simplifyOutputFile, 
-                                                   simplifyEmbedImages, 
-                                                   simplifyEmbedBuffers, 
-                                                   simplifyPrettyPrint, 
+            writeRet = loader.WriteGltfSceneToFile(&model, splitOutputFile, 
+                                                   splitEmbedImages, 
+                                                   splitEmbedBuffers, 
+                                                   splitPrettyPrint, 
                                                    false);
         }
         
         if (!writeRet) {
-            progress.error("simplify", "Failed to write output file: " + simplifyOutputFile);
+            progress.error("split", "Failed to write output file: " + splitOutputFile);
             return 1;
         }
         
-        progress.success("simplify", "Written to: " + simplifyOutputFile);
+        progress.success("split", "Written to: " + splitOutputFile);
         return 0;
     });
     
-    // Optim subcommand - Full optimization pipeline
-    auto* optimCmd = app.add_subcommand("optim", "Optimize GLTF files (merge + dedupe + flatten + join + weld + prune)");
+    // Decompress subcommand
+    auto* decompressCmd = app.add_subcommand("decompress", "Decode Draco-compressed primitives into plain accessors");
     
-    std::vector<std::string> optimInputs;
-    std::string optimOutput;
-    bool optimSimplify = false;
-    float optimSimplifyRatio = 0.75f;
-    float optimSimplifyError = 0.01f;
-    bool optimLockBorder = false;
-    bool optimCompress = false;
-    int optimCompressPositionBits = 14;
-    int optimCompressNormalBits = 10;
-    int optimCompressTexcoordBits = 12;
-    int optimCompressColorBits = 8;
-    bool optimSkipDedupe = false;
-    bool optimSkipFlatten = false;
-    bool optimSkipJoin = false;
-    bool optimSkipWeld = false;
-    bool optimSkipPrune = false;
-    bool optimVerbose = false;
-    bool optimEmbedImages = false;
-    bool optimEmbedBuffers = false;
-    bool optimPrettyPrint = true;
-    bool optimWriteBinary = false;
+    std::string decompressInputFile;
+    std::string decompressOutputFile;
+    int decompressJobs = 0;
+    bool decompressVerbose = false;
+    bool decompressEmbedImages = false;
+    bool decompressEmbedBuffers = false;
+    bool decompressPrettyPrint = true;
+    bool decompressWriteBinary = false;
     
-    optimCmd->add_option("input", optimInputs, "Input GLTF file(s) to optimize")
+    decompressCmd->add_option("input", decompressInputFile, "Input GLTF file")
         ->required()
         ->check(CLI::ExistingFile);
     
-    optimCmd->add_option("-o,--output", optimOutput, "Output GLTF file")
+    decompressCmd->add_option("-o,--output", decompressOutputFile, "Output GLTF file")
         ->required();
     
-    optimCmd->add_flag("--simplify", optimSimplify, 
-                      "Apply mesh simplification");
-    
-    optimCmd->add_option("--simplify-ratio", optimSimplifyRatio, 
-                        "Target ratio for simplification (default: 0.75)")
-        ->check(CLI::Range(0.0, 1.0));
-    
-    optimCmd->add_option("--simplify-error", optimSimplifyError, 
-                        "Error threshold for simplification (default: 0.01)")
-        ->check(CLI::PositiveNumber);
-    
-    optimCmd->add_flag("--simplify-lock-border", optimLockBorder, 
-                      "Lock border vertices during simplification");
-    
-#ifdef GLTFU_ENABLE_DRACO
-    optimCmd->add_flag("--compress", optimCompress, 
-                      "Apply Draco mesh compression");
-    
-    optimCmd->add_option("--compress-position-bits", optimCompressPositionBits, 
-                        "Quantization bits for positions (default: 14)")
-        ->check(CLI::Range(10, 16));
-    
-    optimCmd->add_option("--compress-normal-bits", optimCompressNormalBits, 
-                        "Quantization bits for normals (default: 10)")
-        ->check(CLI::Range(8, 12));
-    
-    optimCmd->add_option("--compress-texcoord-bits", optimCompressTexcoordBits, 
-                        "Quantization bits for texture coordinates (default: 12)")
-        ->check(CLI::Range(10, 14));
-    
-    optimCmd->add_option("--compress-color-bits", optimCompressColorBits, 
-                        "Quantization bits for colors (default: 8)")
-        ->check(CLI::Range(6, 10));
-#endif
+    decompressCmd->add_option("-j,--jobs", decompressJobs,
+                              "Decoder threads (default: 0 = hardware concurrency)")
+        ->check(CLI::NonNegativeNumber);
     
-    optimCmd->add_flag("--skip-dedupe", optimSkipDedupe, 
-                      "Skip deduplication pass");
+    decompressCmd->add_flag("-v,--verbose", decompressVerbose,
+                            "Show per-primitive point and triangle counts");
     
-    optimCmd->add_flag("--skip-flatten", optimSkipFlatten, 
-                      "Skip scene flattening pass");
+    decompressCmd->add_flag("--embed-images", decompressEmbedImages, 
+                            "Embed images in output file");
     
-    optimCmd->add_flag("--skip-join", optimSkipJoin, 
-                      "Skip primitive joining pass");
+    decompressCmd->add_flag("--embed-buffers", decompressEmbedBuffers, 
+                            "Embed buffers in output file");
     
-    optimCmd->add_flag("--skip-weld", optimSkipWeld, 
-                      "Skip vertex welding pass");
+    decompressCmd->add_flag("--no-pretty-print", 
+                            [&decompressPrettyPrint](int count) { decompressPrettyPrint = !count; },
+                            "Disable JSON pretty printing");
     
-    optimCmd->add_flag("--skip-prune", optimSkipPrune, 
-                      "Skip unused resource pruning pass");
+    decompressCmd->add_flag("--binary", decompressWriteBinary, 
+                            "Write binary .glb output (auto-detected from .glb extension)");
+    
+    decompressCmd->callback([&]() {
+        gltfu::ProgressReporter progress(
+            jsonProgress ? gltfu::ProgressReporter::Format::JSON : gltfu::ProgressReporter::Format::Text
+        );
+        
+        // Auto-detect binary format from output file extension
+        if (!decompressWriteBinary && isGlbFile(decompressOutputFile)) {
+            decompressWriteBinary = true;
+        }
+        
+        progress.report("decompress", "Loading file", 0.0, decompressInputFile);
+        
+        tinygltf::Model model;
+        tinygltf::TinyGLTF loader;
+        std::string err, warn;
+        
+        bool ret;
+        if (isGlbFile(decompressInputFile)) {
+            ret = loader.LoadBinaryFromFile(&model, &err, &warn, decompressInputFile);
+        } else {
+            ret = loader.LoadASCIIFromFile(&model, &err, &warn, decompressInputFile);
+        }
+        
+        if (!warn.empty() && !jsonProgress) {
+            std::cerr << "Warning: " << warn << std::endl;
+        }
+        
+        if (!ret) {
+            progress.error("decompress", "Failed to load: " + err);
+            return 1;
+        }
+        
+        progress.report("decompress", "Decoding primitives", 0.3);
+        gltfu::GltfDecompress decompressor;
+        gltfu::DecompressOptions options;
+        options.jobs = decompressJobs;
+        options.verbose = decompressVerbose;
+        
+        if (!decompressor.process(model, options)) {
+            progress.error("decompress", decompressor.getError());
+            return 1;
+        }
+        
+        if (jsonProgress || decompressVerbose) {
+            progress.report("decompress", "Decompress complete", 0.6, decompressor.getStats());
+        } else {
+            std::cout << decompressor.getStats() << std::endl;
+        }
+        
+        // When writing to GLB, clear buffer URIs so data is embedded in binary chunk
+        if (decompressWriteBinary) {
+            for (auto& buffer : model.buffers) {
+                buffer.uri.clear();
+            }
+        }
+        
+        progress.report("decompress", "Writing output", 0.9, decompressOutputFile);
+        bool writeRet;
+        if (decompressWriteBinary) {
+            writeRet = loader.WriteGltfSceneToFile(&model, decompressOutputFile, 
+                                                   decompressEmbedImages, 
+                                                   true, 
+                                                   decompressPrettyPrint, 
+                                                   true);
+        } else {
+            writeRet = loader.WriteGltfSceneToFile(&model, decompressOutputFile, 
+                                                   decompressEmbedImages, 
+                                                   decompressEmbedBuffers, 
+                                                   decompressPrettyPrint, 
+                                                   false);
+        }
+        
+        if (!writeRet) {
+            progress.error("decompress", "Failed to write output file: " + decompressOutputFile);
+            return 1;
+        }
+        
+        progress.success("decompress", "Written to: " + decompressOutputFile);
+        return 0;
+    });
+    
+    // Meshlets subcommand
+    auto* meshletsCmd = app.add_subcommand("meshlets", "Build meshlets for mesh-shader and cluster-culling runtimes");
+    
+    std::string meshletsInputFile;
+    std::string meshletsOutputFile;
+    int meshletsMaxVertices = 64;
+    int meshletsMaxTriangles = 124;
+    float meshletsConeWeight = 0.25f;
+    bool meshletsVerbose = false;
+    bool meshletsEmbedImages = false;
+    bool meshletsEmbedBuffers = false;
+    bool meshletsPrettyPrint = true;
+    bool meshletsWriteBinary = false;
+    
+    meshletsCmd->add_option("input", meshletsInputFile, "Input GLTF file")
+        ->required()
+        ->check(CLI::ExistingFile);
+    
+    meshletsCmd->add_option("-o,--output", meshletsOutputFile, "Output GLTF file")
+        ->required();
+    
+    meshletsCmd->add_option("--max-vertices", meshletsMaxVertices,
+                            "Maximum vertices per meshlet (default: 64)")
+        ->check(CLI::Range(3, 255));
+    
+    meshletsCmd->add_option("--max-triangles", meshletsMaxTriangles,
+                            "Maximum triangles per meshlet, multiple of 4 (default: 124)")
+        ->check(CLI::Range(4, 512));
+    
+    meshletsCmd->add_option("--cone-weight", meshletsConeWeight,
+                            "Trade spatial locality for tighter normal cones, 0-1 (default: 0.25)")
+        ->check(CLI::Range(0.0, 1.0));
+    
+    meshletsCmd->add_flag("-v,--verbose", meshletsVerbose,
+                          "Show per-primitive meshlet counts");
+    
+    meshletsCmd->add_flag("--embed-images", meshletsEmbedImages, 
+                          "Embed images in output file");
+    
+    meshletsCmd->add_flag("--embed-buffers", meshletsEmbedBuffers, 
+                          "Embed buffers in output file");
+    
+    meshletsCmd->add_flag("--no-pretty-print", 
+                          [&meshletsPrettyPrint](int count) { meshletsPrettyPrint = !count; },
+                          "Disable JSON pretty printing");
+    
+    meshletsCmd->add_flag("--binary", meshletsWriteBinary, 
+                          "Write binary .glb output (auto-detected from .glb extension)");
+    
+    meshletsCmd->callback([&]() {
+        gltfu::ProgressReporter progress(
+            jsonProgress ? gltfu::ProgressReporter::Format::JSON : gltfu::ProgressReporter::Format::Text
+        );
+        
+        // Auto-detect binary format from output file extension
+        if (!meshletsWriteBinary && isGlbFile(meshletsOutputFile)) {
+            meshletsWriteBinary = true;
+        }
+        
+        progress.report("meshlets", "Loading file", 0.0, meshletsInputFile);
+        
+        tinygltf::Model model;
+        tinygltf::TinyGLTF loader;
+        std::string err, warn;
+        
+        bool ret;
+        if (isGlbFile(meshletsInputFile)) {
+            ret = loader.LoadBinaryFromFile(&model, &err, &warn, meshletsInputFile);
+        } else {
+            ret = loader.LoadASCIIFromFile(&model, &err, &warn, meshletsInputFile);
+        }
+        
+        if (!warn.empty() && !jsonProgress) {
+            std::cerr << "Warning: " << warn << std::endl;
+        }
+        
+        if (!ret) {
+            progress.error("meshlets", "Failed to load: " + err);
+            return 1;
+        }
+        
+        progress.report("meshlets", "Building meshlets", 0.3);
+        gltfu::GltfMeshlets builder;
+        gltfu::MeshletOptions options;
+        options.maxVertices = meshletsMaxVertices;
+        options.maxTriangles = meshletsMaxTriangles;
+        options.coneWeight = meshletsConeWeight;
+        options.verbose = meshletsVerbose;
+        
+        if (!builder.process(model, options)) {
+            progress.error("meshlets", builder.getError());
+            return 1;
+        }
+        
+        if (jsonProgress || meshletsVerbose) {
+            progress.report("meshlets", "Meshlet generation complete", 0.6, builder.getStats());
+        } else {
+            std::cout << builder.getStats() << std::endl;
+        }
+        
+        // When writing to GLB, clear buffer URIs so data is embedded in binary chunk
+        if (meshletsWriteBinary) {
+            for (auto& buffer : model.buffers) {
+                buffer.uri.clear();
+            }
+        }
+        
+        progress.report("meshlets", "Writing output", 0.9, meshletsOutputFile);
+        bool writeRet;
+        if (meshletsWriteBinary) {
+            writeRet = loader.WriteGltfSceneToFile(&model, meshletsOutputFile, 
+                                                   meshletsEmbedImages, 
+                                                   true, 
+                                                   meshletsPrettyPrint, 
+                                                   true);
+        } else {
+            writeRet = loader.WriteGltfSceneToFile(&model, meshletsOutputFile, 
+                                                   meshletsEmbedImages, 
+                                                   meshletsEmbedBuffers, 
+                                                   meshletsPrettyPrint, 
+                                                   false);
+        }
+        
+        if (!writeRet) {
+            progress.error("meshlets", "Failed to write output file: " + meshletsOutputFile);
+            return 1;
+        }
+        
+        progress.success("meshlets", "Written to: " + meshletsOutputFile);
+        return 0;
+    });
+    
+    // BVH subcommand
+    auto* bvhCmd = app.add_subcommand("bvh", "Build a SAH BVH over scene node bounds and store it in the model");
+    
+    std::string bvhInputFile;
+    std::string bvhOutputFile;
+    int bvhMaxLeafSize = 4;
+    int bvhBins = 16;
+    bool bvhVerbose = false;
+    bool bvhEmbedImages = false;
+    bool bvhEmbedBuffers = false;
+    bool bvhPrettyPrint = true;
+    bool bvhWriteBinary = false;
+    
+    bvhCmd->add_option("input", bvhInputFile, "Input GLTF file")
+        ->required()
+        ->check(CLI::ExistingFile);
+    
+    bvhCmd->add_option("-o,--output", bvhOutputFile, "Output GLTF file")
+        ->required();
+    
+    bvhCmd->add_option("--max-leaf-size", bvhMaxLeafSize,
+                       "Largest leaf the SAH may keep unsplit (default: 4)")
+        ->check(CLI::Range(1, 255));
+    
+    bvhCmd->add_option("--bins", bvhBins,
+                       "SAH buckets evaluated per axis (default: 16)")
+        ->check(CLI::Range(2, 256));
+    
+    bvhCmd->add_flag("-v,--verbose", bvhVerbose,
+                     "Show tree statistics");
+    
+    bvhCmd->add_flag("--embed-images", bvhEmbedImages, 
+                     "Embed images in output file");
+    
+    bvhCmd->add_flag("--embed-buffers", bvhEmbedBuffers, 
+                     "Embed buffers in output file");
+    
+    bvhCmd->add_flag("--no-pretty-print", 
+                     [&bvhPrettyPrint](int count) { bvhPrettyPrint = !count; },
+                     "Disable JSON pretty printing");
+    
+    bvhCmd->add_flag("--binary", bvhWriteBinary, 
+                     "Write binary .glb output (auto-detected from .glb extension)");
+    
+    bvhCmd->callback([&]() {
+        gltfu::ProgressReporter progress(
+            jsonProgress ? gltfu::ProgressReporter::Format::JSON : gltfu::ProgressReporter::Format::Text
+        );
+        
+        // Auto-detect binary format from output file extension
+        if (!bvhWriteBinary && isGlbFile(bvhOutputFile)) {
+            bvhWriteBinary = true;
+        }
+        
+        progress.report("bvh", "Loading file", 0.0, bvhInputFile);
+        
+        tinygltf::Model model;
+        tinygltf::TinyGLTF loader;
+        std::string err, warn;
+        
+        bool ret;
+        if (isGlbFile(bvhInputFile)) {
+            ret = loader.LoadBinaryFromFile(&model, &err, &warn, bvhInputFile);
+        } else {
+            ret = loader.LoadASCIIFromFile(&model, &err, &warn, bvhInputFile);
+        }
+        
+        if (!warn.empty() && !jsonProgress) {
+            std::cerr << "Warning: " << warn << std::endl;
+        }
+        
+        if (!ret) {
+            progress.error("bvh", "Failed to load: " + err);
+            return 1;
+        }
+        
+        progress.report("bvh", "Building scene BVH", 0.3);
+        gltfu::GltfBvh builder;
+        gltfu::BvhOptions options;
+        options.maxLeafSize = bvhMaxLeafSize;
+        options.bins = bvhBins;
+        options.verbose = bvhVerbose;
+        
+        if (!builder.process(model, options)) {
+            progress.error("bvh", builder.getError());
+            return 1;
+        }
+        
+        if (jsonProgress || bvhVerbose) {
+            progress.report("bvh", "BVH complete", 0.6, builder.getStats());
+        } else {
+            std::cout << builder.getStats() << std::endl;
+        }
+        
+        // When writing to GLB, clear buffer URIs so data is embedded in binary chunk
+        if (bvhWriteBinary) {
+            for (auto& buffer : model.buffers) {
+                buffer.uri.clear();
+            }
+        }
+        
+        progress.report("bvh", "Writing output", 0.9, bvhOutputFile);
+        bool writeRet;
+        if (bvhWriteBinary) {
+            writeRet = loader.WriteGltfSceneToFile(&model, bvhOutputFile, 
+                                                   bvhEmbedImages, 
+                                                   true, 
+                                                   bvhPrettyPrint, 
+                                                   true);
+        } else {
+            writeRet = loader.WriteGltfSceneToFile(&model, bvhOutputFile, 
+                                                   bvhEmbedImages, 
+                                                   bvhEmbedBuffers, 
+                                                   bvhPrettyPrint, 
+                                                   false);
+        }
+        
+        if (!writeRet) {
+            progress.error("bvh", "Failed to write output file: " + bvhOutputFile);
+            return 1;
+        }
+        
+        progress.success("bvh", "Written to: " + bvhOutputFile);
+        return 0;
+    });
+    
+    // Tile subcommand
+    auto* tileCmd = app.add_subcommand("tile", "Split a model into a spatial tree of GLB tiles with a tileset.json index");
+    
+    std::vector<std::string> tileInputs;
+    std::string tileOutputDir;
+    int tileMaxDepth = 6;
+    size_t tileMaxTriangles = 200000;
+    bool tileQuadtree = false;
+    bool tileParentLods = false;
+    float tileLodRatio = 0.5f;
+    float tileLodErrorScale = 0.01f;
+    bool tileVerbose = false;
+    
+    tileCmd->add_option("inputs", tileInputs, "Input GLTF files (merged before tiling)")
+        ->required()
+        ->check(CLI::ExistingFile);
+    
+    tileCmd->add_option("-o,--output", tileOutputDir, "Output directory for tileset.json and tiles/")
+        ->required();
+    
+    tileCmd->add_option("--max-depth", tileMaxDepth,
+                        "Deepest subdivision level (default: 6)")
+        ->check(CLI::Range(0, 20));
+    
+    tileCmd->add_option("--max-triangles", tileMaxTriangles,
+                        "Triangles in a tile before it is subdivided (default: 200000)")
+        ->check(CLI::PositiveNumber);
+    
+    tileCmd->add_flag("--quadtree", tileQuadtree,
+                      "Subdivide horizontally only (X and Z) instead of an octree");
+    
+    tileCmd->add_flag("--lod", tileParentLods,
+                      "Write simplified parent LODs for inner tiles");
+    
+    tileCmd->add_option("--lod-ratio", tileLodRatio,
+                        "Triangle ratio kept per level above the leaves (default: 0.5)")
+        ->check(CLI::PositiveNumber)
+        ->check(CLI::Range(0.0f, 1.0f));
+    
+    tileCmd->add_option("--lod-error-scale", tileLodErrorScale,
+                        "Allowed LOD error as a fraction of the tile diagonal (default: 0.01)")
+        ->check(CLI::PositiveNumber)
+        ->check(CLI::Range(0.0f, 1.0f));
+    
+    tileCmd->add_flag("-v,--verbose", tileVerbose,
+                      "Print per-tile details");
+    
+    tileCmd->callback([&]() {
+        gltfu::ProgressReporter progress(
+            jsonProgress ? gltfu::ProgressReporter::Format::JSON : gltfu::ProgressReporter::Format::Text
+        );
+        
+        tinygltf::Model model;
+        if (tileInputs.size() > 1) {
+            gltfu::GltfMerger merger;
+            const bool merged = merger.mergeFiles(tileInputs, gltfu::MergeOptions(), [&](size_t i) {
+                double loadProgress = 0.3 * i / tileInputs.size();
+                progress.report("tile", "Merging file " + std::to_string(i + 1) + "/" + std::to_string(tileInputs.size()),
+                              loadProgress, tileInputs[i]);
+            });
+            if (!merged) {
+                progress.error("tile", merger.getError());
+                return 1;
+            }
+            model = merger.getMergedModel();
+        } else {
+            progress.report("tile", "Loading file", 0.0, tileInputs[0]);
+            
+            tinygltf::TinyGLTF loader;
+            std::string err, warn;
+            
+            bool ret;
+            if (isGlbFile(tileInputs[0])) {
+                ret = loader.LoadBinaryFromFile(&model, &err, &warn, tileInputs[0]);
+            } else {
+                ret = loader.LoadASCIIFromFile(&model, &err, &warn, tileInputs[0]);
+            }
+            
+            if (!warn.empty() && !jsonProgress) {
+                std::cerr << "Warning: " << warn << std::endl;
+            }
+            
+            if (!ret) {
+                progress.error("tile", "Failed to load: " + err);
+                return 1;
+            }
+        }
+        
+        progress.report("tile", "Tiling", 0.4, tileOutputDir);
+        gltfu::GltfTile tiler;
+        gltfu::TileOptions options;
+        options.maxDepth = tileMaxDepth;
+        options.maxTriangles = tileMaxTriangles;
+        options.quadtree = tileQuadtree;
+        options.parentLods = tileParentLods;
+        options.lodRatio = tileLodRatio;
+        options.lodErrorScale = tileLodErrorScale;
+        options.verbose = tileVerbose;
+        
+        if (!tiler.process(model, tileOutputDir, options)) {
+            progress.error("tile", tiler.getError());
+            return 1;
+        }
+        
+        if (jsonProgress || tileVerbose) {
+            progress.report("tile", "Tiling complete", 0.9, tiler.getStats());
+        } else {
+            std::cout << tiler.getStats() << std::endl;
+        }
+        
+        progress.success("tile", "Written to: " + tileOutputDir);
+        return 0;
+    });
+    
+    // Prune subcommand
+    auto* pruneCmd = app.add_subcommand("prune", "Remove unused resources not referenced by any scene");
+    
+    std::string pruneInputFile;
+    std::string pruneOutputFile;
+    bool keepLeaves = false;
+    bool keepAttributes = false;
+    bool keepExtras = false;
+    bool pruneVerbose = false;
+    bool pruneEmbedImages = false;
+    bool pruneEmbedBuffers = false;
+    bool prunePrettyPrint = true;
+    bool pruneWriteBinary = false;
+    
+    pruneCmd->add_option("input", pruneInputFile, "Input GLTF file")
+        ->required()
+        ->check(CLI::ExistingFile);
+    
+    pruneCmd->add_option("-o,--output", pruneOutputFile, "Output GLTF file")
+        ->required();
+    
+    pruneCmd->add_flag("--keep-leaves", keepLeaves,
+                      "Keep empty leaf nodes");
+    
+    pruneCmd->add_flag("--keep-attributes", keepAttributes,
+                      "Keep unused vertex attributes");
+    
+    pruneCmd->add_flag("--keep-extras", keepExtras,
+                      "Prevent pruning properties with custom extras");
+
+    pruneCmd->add_flag("-v,--verbose", pruneVerbose,
+                      "Show pruning summary");
+    
+    pruneCmd->add_flag("--embed-images", pruneEmbedImages, 
+                      "Embed images in output file");
+    
+    pruneCmd->add_flag("--embed-buffers", pruneEmbedBuffers, 
+                      "Embed buffers in output file");
+    
+    pruneCmd->add_flag("--no-pretty-print", 
+                      [&prunePrettyPrint](int count) { prunePrettyPrint = !count; },
+                      "Disable JSON pretty printing");
+    
+    pruneCmd->add_flag("--binary", pruneWriteBinary, 
+                       "Write binary .glb output (auto-detected from .glb extension)");
+
+    pruneCmd->callback([&]() {
+        gltfu::ProgressReporter progress(
+            jsonProgress ? gltfu::ProgressReporter::Format::JSON : gltfu::ProgressReporter::Format::Text
+        );
+        
+        // Auto-detect binary format from output file extension
+        if (!pruneWriteBinary && isGlbFile(pruneOutputFile)) {
+            pruneWriteBinary = true;
+        }
+        
+        progress.report("prune", "Loading file", 0.0, pruneInputFile);
+        
+        tinygltf::Model model;
+        tinygltf::TinyGLTF loader;
+        std::string err, warn;
+        
+        bool ret;
+        if (pruneInputFile.size() >= 4 && pruneInputFile.substr(pruneInputFile.size()-4) == ".glb") {
+            ret = loader.LoadBinaryFromFile(&model, &err, &warn, pruneInputFile);
+        } else {
+            ret = loader.LoadASCIIFromFile(&model, &err, &warn, pruneInputFile);
+        }
+        
+        if (!warn.empty() && !jsonProgress) {
+            std::cerr << "Warning: " << warn << std::endl;
+        }
+        
+        if (!ret) {
+            progress.error("prune", "Failed to load: " + err);
+            return 1;
+        }
+        
+        // Prune unused resources
+        progress.report("prune", "Pruning unused resources", 0.3);
+        gltfu::GltfPrune pruner;
+        gltfu::PruneOptions options;
+        options.keepLeaves = keepLeaves;
+        options.keepAttributes = keepAttributes;
+        options.keepExtras = keepExtras;
+        options.verbose = pruneVerbose;
+
+        if (!pruner.process(model, options)) {
+            const auto error = pruner.getError();
+            progress.error("prune", error.empty() ? "Prune operation failed" : error);
+            return 1;
+        }
+
+        const auto stats = pruner.getStats();
+        if (!stats.empty()) {
+            if (jsonProgress || pruneVerbose) {
+                progress.report("prune", "Pruning complete", 0.6, stats);
+            } else {
+                std::cout << stats << std::endl;
+            }
+        }
+        
+        // When writing to GLB, clear buffer URIs so data is embedded in binary chunk
+        if (pruneWriteBinary) {
+            for (auto& buffer : model.buffers) {
+                buffer.uri.clear();
+            }
+        }
+        
+        // Write output
+        progress.report("prune", "Writing output", 0.9, pruneOutputFile);
+        bool writeRet;
+        if (pruneWriteBinary) {
+            // GLB format must embed buffers in the binary chunk
+            writeRet = loader.WriteGltfSceneToFile(&model, pruneOutputFile, 
+                                                   pruneEmbedImages, 
+                                                   true, 
+                                                   prunePrettyPrint, 
+                                                   true);
+        } else {
+            writeRet = loader.WriteGltfSceneToFile(&model, pruneOutputFile, 
+                                                   pruneEmbedImages, 
+                                                   pruneEmbedBuffers, 
+                                                   prunePrettyPrint, 
+                                                   false);
+        }
+        
+        if (!writeRet) {
+            progress.error("prune", "Failed to write output file: " + pruneOutputFile);
+            return 1;
+        }
+        
+        progress.success("prune", "Written to: " + pruneOutputFile);
+        return 0;
+    });
+    
+    // Simplify subcommand
+    auto* simplifyCmd = app.add_subcommand("simplify", "Reduce mesh complexity using meshoptimizer");
+    
+    std::string simplifyInputFile;
+    std::string simplifyOutputFile;
+    float simplifyRatio = 0.5f;
+    float simplifyError = 0.01f;
+    bool simplifyLockBorder = false;
+    float simplifyNormalWeight = 0.0f;
+    float simplifyTexCoordWeight = 0.0f;
+    float simplifyColorWeight = 0.0f;
+    std::string simplifyErrorMode = "relative";
+    float simplifyViewDistance = 10.0f;
+    float simplifyFieldOfView = 60.0f;
+    float simplifyViewportHeight = 1080.0f;
+    size_t simplifyTriangleBudget = 0;
+    std::string simplifyBudgetObjective = "minmax";
+    bool simplifyVerbose = false;
+    
+    bool simplifyEmbedImages = false;
+    bool simplifyEmbedBuffers = false;
+    bool simplifyPrettyPrint = true;
+    bool simplifyWriteBinary = false;
+    
+    simplifyCmd->add_option("input", simplifyInputFile, "Input GLTF file")
+        ->required()
+        ->check(CLI::ExistingFile);
+    
+    simplifyCmd->add_option("-o,--output", simplifyOutputFile, "Output GLTF file")
+        ->required();
+    
+    simplifyCmd->add_option("-r,--ratio", simplifyRatio, 
+        "Target ratio of triangles to keep (0.0-1.0, default 0.5)")
+        ->check(CLI::Range(0.0, 1.0));
+    
+    simplifyCmd->add_option("-e,--error", simplifyError,
+        "Maximum error threshold (default 0.01)")
+        ->check(CLI::PositiveNumber);
+    
+    simplifyCmd->add_flag("-l,--lock-border", simplifyLockBorder,
+        "Lock border vertices to prevent mesh from shrinking");
+
+    simplifyCmd->add_option("--error-mode", simplifyErrorMode,
+        "How --error is measured: relative (fraction of mesh size), world (units) or pixels")
+        ->check(CLI::IsMember({"relative", "world", "pixels"}));
+
+    simplifyCmd->add_option("--view-distance", simplifyViewDistance,
+        "Camera distance in world units for --error-mode pixels (default 10)")
+        ->check(CLI::PositiveNumber);
+
+    simplifyCmd->add_option("--fov", simplifyFieldOfView,
+        "Vertical field of view in degrees for --error-mode pixels (default 60)")
+        ->check(CLI::Range(1.0, 179.0));
+
+    simplifyCmd->add_option("--viewport-height", simplifyViewportHeight,
+        "Viewport height in pixels for --error-mode pixels (default 1080)")
+        ->check(CLI::PositiveNumber);
+
+    simplifyCmd->add_option("--triangle-budget", simplifyTriangleBudget,
+        "Fit the whole scene in this many triangles, overriding --ratio and --error (default 0 = off)")
+        ->check(CLI::NonNegativeNumber);
+
+    simplifyCmd->add_option("--budget-objective", simplifyBudgetObjective,
+        "What the triangle budget minimizes: minmax (worst error) or minsum (total error)")
+        ->check(CLI::IsMember({"minmax", "minsum"}));
+
+    simplifyCmd->add_option("--normal-weight", simplifyNormalWeight,
+        "Weight of NORMAL deviation in the error metric (default 0 = ignore)")
+        ->check(CLI::NonNegativeNumber);
+
+    simplifyCmd->add_option("--uv-weight", simplifyTexCoordWeight,
+        "Weight of TEXCOORD_0 deviation in the error metric (default 0 = ignore)")
+        ->check(CLI::NonNegativeNumber);
+
+    simplifyCmd->add_option("--color-weight", simplifyColorWeight,
+        "Weight of COLOR_0 deviation in the error metric (default 0 = ignore)")
+        ->check(CLI::NonNegativeNumber);
+
+    simplifyCmd->add_flag("-v,--verbose", simplifyVerbose,
+        "Show simplification summary");
+    
+    simplifyCmd->add_flag("--embed-images", simplifyEmbedImages, 
+        "Embed images as data URIs");
+    
+    simplifyCmd->add_flag("--embed-buffers", simplifyEmbedBuffers, 
+        "Embed buffers as data URIs");
+    
+    simplifyCmd->add_flag("!--no-pretty-print,!--ugly", simplifyPrettyPrint, 
+        "Disable pretty printing JSON");
+    
+    simplifyCmd->add_flag("-b,--binary", simplifyWriteBinary, 
+        "Write output as GLB (binary) (auto-detected from .glb extension)");
+    
+    simplifyCmd->callback([&]() {
+        gltfu::ProgressReporter progress(
+            jsonProgress ? gltfu::ProgressReporter::Format::JSON : gltfu::ProgressReporter::Format::Text
+        );
+        
+        if (simplifyOutputFile.empty()) {
+            simplifyOutputFile = simplifyInputFile;
+        }
+        
+        // Auto-detect binary format from output file extension
+        if (!simplifyWriteBinary && isGlbFile(simplifyOutputFile)) {
+            simplifyWriteBinary = true;
+        }
+        
+        progress.report("simplify", "Loading file", 0.0, simplifyInputFile);
+        tinygltf::Model model;
+        tinygltf::TinyGLTF loader;
+        std::string err, warn;
+        
+        bool ret;
+        if (simplifyInputFile.size() >= 4 && simplifyInputFile.substr(simplifyInputFile.size()-4) == ".glb") {
+            ret = loader.LoadBinaryFromFile(&model, &err, &warn, simplifyInputFile);
+        } else {
+            ret = loader.LoadASCIIFromFile(&model, &err, &warn, simplifyInputFile);
+        }
+        
+        if (!warn.empty() && !jsonProgress) {
+            std::cerr << "Warning: " << warn << std::endl;
+        }
+        
+        if (!ret) {
+            progress.error("simplify", "Failed to load: " + err);
+            return 1;
+        }
+        
+        // Simplify meshes
+        progress.report("simplify", "Simplifying meshes", 0.3);
+        gltfu::GltfSimplify simplifier;
+        gltfu::SimplifyOptions options;
+        options.ratio = simplifyRatio;
+        options.error = simplifyError;
+        options.lockBorder = simplifyLockBorder;
+        options.errorMode = parseErrorMode(simplifyErrorMode);
+        options.viewDistance = simplifyViewDistance;
+        options.fieldOfView = simplifyFieldOfView;
+        options.viewportHeight = simplifyViewportHeight;
+        options.triangleBudget = simplifyTriangleBudget;
+        options.budgetObjective = parseBudgetObjective(simplifyBudgetObjective);
+        options.normalWeight = simplifyNormalWeight;
+        options.texCoordWeight = simplifyTexCoordWeight;
+        options.colorWeight = simplifyColorWeight;
+        options.verbose = simplifyVerbose;
+        
+        if (!simplifier.process(model, options)) {
+            const auto error = simplifier.getError();
+            progress.error("simplify", error.empty() ? "Simplify operation failed" : error);
+            return 1;
+        }
+
+        const auto simplifyStats = simplifier.getStats();
+        if (!simplifyStats.empty()) {
+            if (jsonProgress || simplifyVerbose) {
+                progress.report("simplify", "Simplification complete", 0.6, simplifyStats);
+            } else {
+                std::cout << simplifyStats << std::endl;
+            }
+        }
+        
+        // When writing to GLB, clear buffer URIs so data is embedded in binary chunk
+        if (simplifyWriteBinary) {
+            for (auto& buffer : model.buffers) {
+                buffer.uri.clear();
+            }
+        }
+        
+        // Write output
+        progress.report("simplify", "Writing output", 0.9, simplifyOutputFile);
+        bool writeRet;
+        if (simplifyWriteBinary) {
+            // GLB format must embed buffers in the binary chunk
+            writeRet = loader.WriteGltfSceneToFile(&model, simplifyOutputFile, 
+                                                   simplifyEmbedImages, 
+                                                   true, 
+                                                   simplifyPrettyPrint, 
+                                                   true);
+        } else {
+            writeRet = loader.WriteGltfSceneToFile(&model, simplifyOutputFile, 
+                                                   simplifyEmbedImages, 
+                                                   simplifyEmbedBuffers, 
+                                                   simplifyPrettyPrint, 
+                                                   false);
+        }
+        
+        if (!writeRet) {
+            progress.error("simplify", "Failed to write output file: " + simplifyOutputFile);
+            return 1;
+        }
+        
+        progress.success("simplify", "Written to: " + simplifyOutputFile);
+        return 0;
+    });
+    
+    // Optim subcommand - Full optimization pipeline
+    auto* optimCmd = app.add_subcommand("optim", "Optimize GLTF files (merge + dedupe + flatten + join + weld + prune)");
+    
+    std::vector<std::string> optimInputs;
+    std::string optimOutput;
+    int optimJobs = 0;
+    int optimPrefetch = 0;
+    bool optimPresize = false;
+    std::string optimSpillDir;
+    bool optimTree = false;
+    bool optimMergeDedup = false;
+    bool optimSimplify = false;
+    float optimSimplifyRatio = 0.75f;
+    float optimSimplifyError = 0.01f;
+    bool optimLockBorder = false;
+    float optimSimplifyNormalWeight = 0.0f;
+    float optimSimplifyTexCoordWeight = 0.0f;
+    float optimSimplifyColorWeight = 0.0f;
+    std::string optimSimplifyErrorMode = "relative";
+    float optimSimplifyViewDistance = 10.0f;
+    float optimSimplifyFieldOfView = 60.0f;
+    float optimSimplifyViewportHeight = 1080.0f;
+    size_t optimSimplifyTriangleBudget = 0;
+    std::string optimSimplifyBudgetObjective = "minmax";
+    bool optimDecompress = false;
+    bool optimCompress = false;
+    int optimCompressPositionBits = 14;
+    int optimCompressNormalBits = 10;
+    int optimCompressTexcoordBits = 12;
+    int optimCompressColorBits = 8;
+    bool optimCompressAuto = false;
+    double optimCompressMaxPositionError = 0.001;
+    double optimCompressMaxNormalError = 1.0;
+    double optimCompressTargetRatio = 0.25;
+    bool optimCompressVerify = false;
+    bool optimSplit = false;
+    size_t optimSplitMaxVertices = 65536;
+    size_t optimSplitMaxTriangles = 0;
+    bool optimMeshlets = false;
+    int optimMeshletMaxVertices = 64;
+    int optimMeshletMaxTriangles = 124;
+    float optimMeshletConeWeight = 0.25f;
+    bool optimBvh = false;
+    bool optimSkipTriangulate = false;
+    bool optimSkipDedupe = false;
+    bool optimSkipFlatten = false;
+    bool optimSkipJoin = false;
+    bool optimSkipWeld = false;
+    bool optimSkipPrune = false;
+    bool optimVerbose = false;
+    bool optimEmbedImages = false;
+    bool optimEmbedBuffers = false;
+    bool optimPrettyPrint = true;
+    bool optimWriteBinary = false;
+    std::string optimCacheDir;
+    bool optimCacheLink = false;
+    
+    optimCmd->add_option("input", optimInputs, "Input GLTF file(s) to optimize")
+        ->required()
+        ->check(CLI::ExistingFile);
+    
+    optimCmd->add_option("-o,--output", optimOutput, "Output GLTF file")
+        ->required();
+    
+    optimCmd->add_option("-j,--jobs", optimJobs,
+                        "Loader threads parsing inputs ahead of the merge (default: 0 = all cores, 1 = serial)")
+        ->check(CLI::NonNegativeNumber);
+    
+    optimCmd->add_option("--prefetch", optimPrefetch,
+                        "Parsed inputs held ahead of the merge (default: 0 = twice the jobs)")
+        ->check(CLI::NonNegativeNumber);
+    
+    optimCmd->add_flag("--presize", optimPresize,
+                       "Scan every input's header first and allocate the merged model once");
+    
+    optimCmd->add_option("--spill-dir", optimSpillDir,
+                        "Append merged binary data to a temporary file in this directory instead of memory");
+    
+    optimCmd->add_flag("--tree", optimTree,
+                       "Merge groups of inputs in parallel and combine them pairwise (not with --spill-dir)");
+    
+    optimCmd->add_flag("--merge-dedup", optimMergeDedup,
+                       "Reuse identical accessors, images, samplers, textures and materials while merging");
+    
+    optimCmd->add_flag("--simplify", optimSimplify, 
+                      "Apply mesh simplification");
+    
+    optimCmd->add_option("--simplify-ratio", optimSimplifyRatio, 
+                        "Target ratio for simplification (default: 0.75)")
+        ->check(CLI::Range(0.0, 1.0));
+    
+    optimCmd->add_option("--simplify-error", optimSimplifyError, 
+                        "Error threshold for simplification (default: 0.01)")
+        ->check(CLI::PositiveNumber);
+    
+    optimCmd->add_flag("--simplify-lock-border", optimLockBorder, 
+                      "Lock border vertices during simplification");
+    
+    optimCmd->add_option("--simplify-error-mode", optimSimplifyErrorMode, 
+                        "How --simplify-error is measured: relative, world or pixels (default: relative)")
+        ->check(CLI::IsMember({"relative", "world", "pixels"}));
+    
+    optimCmd->add_option("--simplify-view-distance", optimSimplifyViewDistance, 
+                        "Camera distance for pixel error mode (default: 10)")
+        ->check(CLI::PositiveNumber);
+    
+    optimCmd->add_option("--simplify-fov", optimSimplifyFieldOfView, 
+                        "Vertical field of view in degrees for pixel error mode (default: 60)")
+        ->check(CLI::Range(1.0, 179.0));
+    
+    optimCmd->add_option("--simplify-viewport-height", optimSimplifyViewportHeight, 
+                        "Viewport height in pixels for pixel error mode (default: 1080)")
+        ->check(CLI::PositiveNumber);
+    
+    optimCmd->add_option("--simplify-triangle-budget", optimSimplifyTriangleBudget, 
+                        "Scene-wide triangle budget for simplification (default: 0 = off)")
+        ->check(CLI::NonNegativeNumber);
+    
+    optimCmd->add_option("--simplify-budget-objective", optimSimplifyBudgetObjective, 
+                        "Triangle budget objective: minmax or minsum (default: minmax)")
+        ->check(CLI::IsMember({"minmax", "minsum"}));
+    
+    optimCmd->add_option("--simplify-normal-weight", optimSimplifyNormalWeight, 
+                        "Weight of NORMAL deviation during simplification (default: 0)")
+        ->check(CLI::NonNegativeNumber);
+    
+    optimCmd->add_option("--simplify-uv-weight", optimSimplifyTexCoordWeight, 
+                        "Weight of TEXCOORD_0 deviation during simplification (default: 0)")
+        ->check(CLI::NonNegativeNumber);
+    
+    optimCmd->add_option("--simplify-color-weight", optimSimplifyColorWeight, 
+                        "Weight of COLOR_0 deviation during simplification (default: 0)")
+        ->check(CLI::NonNegativeNumber);
+    
+    optimCmd->add_flag("--split", optimSplit, 
+                      "Split oversized primitives into spatial chunks after simplification");
+    
+    optimCmd->add_option("--split-max-vertices", optimSplitMaxVertices, 
+                        "Maximum vertices per split chunk (default: 65536)")
+        ->check(CLI::PositiveNumber);
+    
+    optimCmd->add_option("--split-max-triangles", optimSplitMaxTriangles, 
+                        "Maximum triangles per split chunk, 0 for no limit (default: 0)")
+        ->check(CLI::NonNegativeNumber);
+    
+    optimCmd->add_flag("--meshlets", optimMeshlets, 
+                      "Build meshlets after simplification (skips Draco on those primitives)");
+    
+    optimCmd->add_option("--meshlet-max-vertices", optimMeshletMaxVertices, 
+                        "Maximum vertices per meshlet (default: 64)")
+        ->check(CLI::Range(3, 255));
+    
+    optimCmd->add_option("--meshlet-max-triangles", optimMeshletMaxTriangles, 
+                        "Maximum triangles per meshlet, multiple of 4 (default: 124)")
+        ->check(CLI::Range(4, 512));
+    
+    optimCmd->add_option("--meshlet-cone-weight", optimMeshletConeWeight, 
+                        "Meshlet normal cone weight, 0-1 (default: 0.25)")
+        ->check(CLI::Range(0.0, 1.0));
+    
+    optimCmd->add_flag("--bvh", optimBvh, 
+                      "Store a SAH BVH over scene node bounds (built after all other stages)");
+    
+    optimCmd->add_flag("--decompress", optimDecompress, 
+                      "Decode Draco-compressed inputs first so every stage can process them");
+    
+#ifdef GLTFU_ENABLE_DRACO
+    optimCmd->add_flag("--compress", optimCompress, 
+                      "Apply Draco mesh compression");
+    
+    optimCmd->add_option("--compress-position-bits", optimCompressPositionBits, 
+                        "Quantization bits for positions (default: 14)")
+        ->check(CLI::Range(10, 16));
+    
+    optimCmd->add_option("--compress-normal-bits", optimCompressNormalBits, 
+                        "Quantization bits for normals (default: 10)")
+        ->check(CLI::Range(8, 12));
+    
+    optimCmd->add_option("--compress-texcoord-bits", optimCompressTexcoordBits, 
+                        "Quantization bits for texture coordinates (default: 12)")
+        ->check(CLI::Range(10, 14));
+    
+    optimCmd->add_option("--compress-color-bits", optimCompressColorBits, 
+                        "Quantization bits for colors (default: 8)")
+        ->check(CLI::Range(6, 10));
+    
+    optimCmd->add_flag("--compress-auto", optimCompressAuto, 
+                      "Pick position/normal bits and speed per primitive from error and size targets");
+    
+    optimCmd->add_option("--compress-max-position-error", optimCompressMaxPositionError, 
+                        "Auto: largest position error in world units (default: 0.001)")
+        ->check(CLI::PositiveNumber);
+    
+    optimCmd->add_option("--compress-max-normal-error", optimCompressMaxNormalError, 
+                        "Auto: largest normal error in degrees (default: 1.0)")
+        ->check(CLI::PositiveNumber);
+    
+    optimCmd->add_option("--compress-target-ratio", optimCompressTargetRatio, 
+                        "Auto: compressed size target as a fraction of the original (default: 0.25)")
+        ->check(CLI::Range(0.0, 1.0));
+    
+    optimCmd->add_flag("--compress-verify", optimCompressVerify, 
+                      "Decode the compressed meshes and report round-trip error and decode speed");
+#endif
+    
+    optimCmd->add_flag("--skip-triangulate", optimSkipTriangulate, 
+                      "Skip strip/fan to triangle list conversion");
+    
+    optimCmd->add_flag("--skip-dedupe", optimSkipDedupe, 
+                      "Skip deduplication pass");
+    
+    optimCmd->add_flag("--skip-flatten", optimSkipFlatten, 
+                      "Skip scene flattening pass");
+    
+    optimCmd->add_flag("--skip-join", optimSkipJoin, 
+                      "Skip primitive joining pass");
+    
+    optimCmd->add_flag("--skip-weld", optimSkipWeld, 
+                      "Skip vertex welding pass");
+    
+    optimCmd->add_flag("--skip-prune", optimSkipPrune, 
+                      "Skip unused resource pruning pass");
     
     optimCmd->add_flag("-v,--verbose", optimVerbose, 
                       "Show detailed optimization statistics");
@@ -1038,6 +2039,12 @@ int main(int argc, char** argv) {
     
     optimCmd->add_flag("-b,--binary", optimWriteBinary, 
                        "Write binary GLTF (.glb) format (auto-detected from .glb extension)");
+
+    optimCmd->add_option("--cache-dir", optimCacheDir,
+                        "Reuse whole-file and per-primitive results from a content-addressed cache directory");
+
+    optimCmd->add_flag("--cache-link", optimCacheLink,
+                      "Hard-link cache hits into place instead of copying them");
     
     optimCmd->callback([&]() {
         gltfu::ProgressReporter progress(
@@ -1049,29 +2056,180 @@ int main(int argc, char** argv) {
             optimWriteBinary = true;
         }
         
+#ifndef GLTFU_ENABLE_DRACO
+        // Fail up front instead of silently running the pipeline on still-compressed inputs
+        if (optimDecompress) {
+            progress.error("optim", "--decompress requires Draco support. Rebuild with Draco enabled.");
+            return 1;
+        }
+#endif
+        
         progress.report("optim", "Starting optimization pipeline", 0.0);
+
+        // Stage options are assembled up front so the cache key covers all of them
+        gltfu::DedupOptions dedupOpts;
+        dedupOpts.dedupAccessors = true;
+        dedupOpts.dedupMeshes = true;
+        dedupOpts.dedupMaterials = true;
+        dedupOpts.dedupTextures = true;
+        dedupOpts.keepUniqueNames = false;
+        dedupOpts.verbose = optimVerbose;
+        dedupOpts.progressReporter = &progress;
+
+        gltfu::JoinOptions joinOpts;
+        joinOpts.keepMeshes = false;
+        joinOpts.keepNamed = false;
+        joinOpts.verbose = optimVerbose;
+
+        gltfu::WeldOptions weldOpts;
+        weldOpts.overwrite = true;
+        weldOpts.verbose = optimVerbose;
+
+        gltfu::SimplifyOptions simplifyOpts;
+        simplifyOpts.ratio = optimSimplifyRatio;
+        simplifyOpts.error = optimSimplifyError;
+        simplifyOpts.lockBorder = optimLockBorder;
+        simplifyOpts.errorMode = parseErrorMode(optimSimplifyErrorMode);
+        simplifyOpts.viewDistance = optimSimplifyViewDistance;
+        simplifyOpts.fieldOfView = optimSimplifyFieldOfView;
+        simplifyOpts.viewportHeight = optimSimplifyViewportHeight;
+        simplifyOpts.triangleBudget = optimSimplifyTriangleBudget;
+        simplifyOpts.budgetObjective = parseBudgetObjective(optimSimplifyBudgetObjective);
+        simplifyOpts.normalWeight = optimSimplifyNormalWeight;
+        simplifyOpts.texCoordWeight = optimSimplifyTexCoordWeight;
+        simplifyOpts.colorWeight = optimSimplifyColorWeight;
+        simplifyOpts.verbose = optimVerbose;
+
+        gltfu::SplitOptions splitOpts;
+        splitOpts.maxVertices = optimSplitMaxVertices;
+        splitOpts.maxTriangles = optimSplitMaxTriangles;
+        splitOpts.verbose = optimVerbose;
+
+        gltfu::MeshletOptions meshletOpts;
+        meshletOpts.maxVertices = optimMeshletMaxVertices;
+        meshletOpts.maxTriangles = optimMeshletMaxTriangles;
+        meshletOpts.coneWeight = optimMeshletConeWeight;
+        meshletOpts.verbose = optimVerbose;
+
+#ifdef GLTFU_ENABLE_DRACO
+        gltfu::CompressOptions compressOpts;
+        compressOpts.positionQuantizationBits = optimCompressPositionBits;
+        compressOpts.normalQuantizationBits = optimCompressNormalBits;
+        compressOpts.texCoordQuantizationBits = optimCompressTexcoordBits;
+        compressOpts.colorQuantizationBits = optimCompressColorBits;
+        compressOpts.autoTune = optimCompressAuto;
+        compressOpts.autoMaxPositionError = optimCompressMaxPositionError;
+        compressOpts.autoMaxNormalError = optimCompressMaxNormalError;
+        compressOpts.autoTargetRatio = optimCompressTargetRatio;
+        compressOpts.verify = optimCompressVerify;
+        compressOpts.verbose = optimVerbose;
+#endif
+
+        gltfu::PruneOptions pruneOpts;
+        pruneOpts.keepLeaves = false;
+        pruneOpts.keepAttributes = false;
+        pruneOpts.verbose = optimVerbose;
+
+        // Per-primitive results live next to whole-file entries and survive input changes
+        if (!optimCacheDir.empty()) {
+            simplifyOpts.cacheDirectory = optimCacheDir + "/primitives";
+#ifdef GLTFU_ENABLE_DRACO
+            compressOpts.cacheDirectory = optimCacheDir + "/primitives";
+#endif
+        }
+
+        // Look up a previous result before doing any work
+        std::unique_ptr<gltfu::GltfCache> cache;
+        std::string cacheKey;
+        if (!optimCacheDir.empty()) {
+            gltfu::CacheFingerprint fingerprint;
+            fingerprint.add("command", "optim")
+                .add("binary", optimWriteBinary)
+                .add("embedImages", optimEmbedImages)
+                .add("embedBuffers", optimEmbedBuffers)
+                .add("prettyPrint", optimPrettyPrint);
+            fingerprint.add("mergeDedup", optimMergeDedup && optimInputs.size() > 1);
+            fingerprint.add("decompress", optimDecompress);
+            fingerprint.add("triangulate", !optimSkipTriangulate);
+            if (!optimSkipDedupe) {
+                fingerprint.add(dedupOpts);
+            }
+            fingerprint.add("flatten", !optimSkipFlatten);
+            if (!optimSkipJoin) {
+                fingerprint.add(joinOpts);
+            }
+            if (!optimSkipWeld) {
+                fingerprint.add(weldOpts);
+            }
+            if (optimSimplify) {
+                fingerprint.add(simplifyOpts);
+            }
+            if (optimSplit) {
+                fingerprint.add(splitOpts);
+            }
+            if (optimMeshlets) {
+                fingerprint.add(meshletOpts);
+            }
+#ifdef GLTFU_ENABLE_DRACO
+            if (optimCompress) {
+                fingerprint.add(compressOpts);
+            }
+#endif
+            if (!optimSkipPrune) {
+                fingerprint.add(pruneOpts);
+            }
+            if (optimBvh) {
+                fingerprint.add(gltfu::BvhOptions());
+            }
+
+            cache = std::make_unique<gltfu::GltfCache>(optimCacheDir);
+            if (!cache->computeKey(optimInputs, fingerprint, cacheKey)) {
+                if (!jsonProgress) {
+                    std::cerr << "Warning: cache disabled: " << cache->getError() << std::endl;
+                }
+                cache.reset();
+            } else if (cache->fetch(cacheKey, optimOutput, optimCacheLink)) {
+                progress.success("optim", "Cache hit (" + cacheKey + "): " + optimOutput);
+                return 0;
+            }
+        }
         
         tinygltf::TinyGLTF loader;
         tinygltf::Model model;
+        gltfu::PipelineProfiler profiler(progress, "optim");
         
         // Step 1: Load and merge input files
         if (optimInputs.size() > 1) {
             progress.report("optim", "Step 1: Merging " + std::to_string(optimInputs.size()) + " files", 0.05);
+            profiler.begin("merge", model);
             
             gltfu::GltfMerger merger;
-            for (size_t i = 0; i < optimInputs.size(); ++i) {
+            gltfu::MergeOptions mergeOptions;
+            mergeOptions.jobs = optimJobs;
+            mergeOptions.prefetch = optimPrefetch;
+            mergeOptions.presize = optimPresize;
+            mergeOptions.spillDirectory = optimSpillDir;
+            mergeOptions.tree = optimTree;
+            mergeOptions.dedup = optimMergeDedup;
+            const bool merged = merger.mergeFiles(optimInputs, mergeOptions, [&](size_t i) {
                 double fileProgress = 0.05 + (0.05 * i / optimInputs.size());
                 progress.report("optim", "Merging file " + std::to_string(i + 1) + "/" + std::to_string(optimInputs.size()), fileProgress);
-                if (!merger.loadAndMergeFile(optimInputs[i], false, false)) {
-                    progress.error("optim", "Merge failed: " + merger.getError());
-                    return 1;
-                }
+            });
+            if (!merged) {
+                progress.error("optim", "Merge failed: " + merger.getError());
+                return 1;
+            }
+            
+            if (optimVerbose && !merger.getStats().empty()) {
+                std::cout << "  " << merger.getStats() << std::endl;
             }
             
             progress.report("optim", "Extracting merged model", 0.10);
             model = merger.getMergedModel();
+            profiler.end(model);
         } else {
             progress.report("optim", "Loading input file", 0.05);
+            profiler.begin("load", model);
             std::string err, warn;
             bool ret = false;
             if (isGlbFile(optimInputs[0])) {
@@ -1086,22 +2244,52 @@ int main(int argc, char** argv) {
                 progress.error("optim", "Failed to load file: " + err);
                 return 1;
             }
+            profiler.end(model);
+        }
+        
+#ifdef GLTFU_ENABLE_DRACO
+        // Decode Draco primitives before any stage reads their accessors
+        if (optimDecompress) {
+            progress.report("optim", "Decompressing Draco primitives", 0.11);
+            profiler.begin("decompress", model);
+            
+            gltfu::GltfDecompress decompressor;
+            gltfu::DecompressOptions decompressOpts;
+            decompressOpts.jobs = optimJobs;
+            decompressOpts.verbose = optimVerbose;
+            if (!decompressor.process(model, decompressOpts)) {
+                progress.error("optim", "Decompression failed: " + decompressor.getError());
+                return 1;
+            }
+            
+            if (optimVerbose) {
+                std::cout << "  " << decompressor.getStats() << std::endl;
+            }
+            profiler.end(model);
+        }
+#endif
+        
+        // Expand strips and fans so every later stage sees triangle lists
+        if (!optimSkipTriangulate) {
+            progress.report("optim", "Triangulating strips and fans", 0.12);
+            profiler.begin("triangulate", model);
+            
+            gltfu::GltfTriangulate triangulator;
+            gltfu::TriangulateOptions triangulateOpts;
+            triangulateOpts.verbose = optimVerbose;
+            if (!triangulator.process(model, triangulateOpts)) {
+                progress.error("optim", "Triangulation failed: " + triangulator.getError());
+                return 1;
+            }
+            profiler.end(model);
         }
         
         // Step 2: Deduplicate (in-place)
         if (!optimSkipDedupe) {
             progress.report("optim", "Step 2: Deduplicating resources", 0.15);
+            profiler.begin("dedupe", model);
             
             gltfu::GltfDedup deduper;
-            gltfu::DedupOptions dedupOpts;
-            dedupOpts.dedupAccessors = true;
-            dedupOpts.dedupMeshes = true;
-            dedupOpts.dedupMaterials = true;
-            dedupOpts.dedupTextures = true;
-            dedupOpts.keepUniqueNames = false;
-            dedupOpts.verbose = optimVerbose;
-            dedupOpts.progressReporter = &progress;
-            
             if (!deduper.process(model, dedupOpts)) {
                 progress.error("optim", "Deduplication failed: " + deduper.getError());
                 return 1;
@@ -1110,29 +2298,28 @@ int main(int argc, char** argv) {
             if (optimVerbose && !deduper.getStats().empty()) {
                 std::cout << "  " << deduper.getStats() << std::endl;
             }
+            profiler.end(model);
         }
         
         // Step 3: Flatten scene graph (in-place)
         if (!optimSkipFlatten) {
             progress.report("optim", "Step 3: Flattening scene graph", 0.30);
+            profiler.begin("flatten", model);
             
             int flattenedCount = gltfu::GltfFlatten::process(model, true);
             
             if (optimVerbose) {
                 std::cout << "  Flattened " << flattenedCount << " nodes" << std::endl;
             }
+            profiler.end(model);
         }
         
         // Step 4: Join primitives (in-place)
         if (!optimSkipJoin) {
             progress.report("optim", "Step 4: Joining compatible primitives", 0.45);
+            profiler.begin("join", model);
             
             gltfu::GltfJoin joiner;
-            gltfu::JoinOptions joinOpts;
-            joinOpts.keepMeshes = false;
-            joinOpts.keepNamed = false;
-            joinOpts.verbose = optimVerbose;
-            
             if (!joiner.process(model, joinOpts)) {
                 progress.error("optim", "Join operation failed");
                 return 1;
@@ -1144,34 +2331,28 @@ int main(int argc, char** argv) {
                     std::cout << "  " << stats << std::endl;
                 }
             }
+            profiler.end(model);
         }
         
         // Step 5: Weld vertices (in-place)
         if (!optimSkipWeld) {
             progress.report("optim", "Step 5: Welding identical vertices", 0.60);
+            profiler.begin("weld", model);
             
             gltfu::GltfWeld welder;
-            gltfu::WeldOptions weldOpts;
-            weldOpts.overwrite = true;
-            weldOpts.verbose = optimVerbose;
-            
             if (!welder.process(model, weldOpts)) {
                 progress.error("optim", "Weld operation failed");
                 return 1;
             }
+            profiler.end(model);
         }
         
         // Step 6: Simplify (in-place, optional)
         if (optimSimplify) {
             progress.report("optim", "Step 6: Simplifying meshes", 0.75);
+            profiler.begin("simplify", model);
             
             gltfu::GltfSimplify simplifier;
-            gltfu::SimplifyOptions simplifyOpts;
-            simplifyOpts.ratio = optimSimplifyRatio;
-            simplifyOpts.error = optimSimplifyError;
-            simplifyOpts.lockBorder = optimLockBorder;
-            simplifyOpts.verbose = optimVerbose;
-            
             if (!simplifier.process(model, simplifyOpts)) {
                 progress.error("optim", "Simplify operation failed");
                 return 1;
@@ -1183,21 +2364,50 @@ int main(int argc, char** argv) {
                     std::cout << "  " << stats << std::endl;
                 }
             }
+            profiler.end(model);
+        }
+        
+        // Split after join and simplify so the chunks are not merged back together
+        if (optimSplit) {
+            progress.report("optim", "Splitting oversized primitives", 0.78);
+            profiler.begin("split", model);
+            
+            gltfu::GltfSplit splitter;
+            if (!splitter.process(model, splitOpts)) {
+                progress.error("optim", "Split operation failed: " + splitter.getError());
+                return 1;
+            }
+            
+            if (optimVerbose) {
+                std::cout << splitter.getStats() << std::endl;
+            }
+            profiler.end(model);
+        }
+        
+        // Meshlets must see the final vertex order, so they follow simplification
+        if (optimMeshlets) {
+            progress.report("optim", "Building meshlets", 0.80);
+            profiler.begin("meshlets", model);
+            
+            gltfu::GltfMeshlets builder;
+            if (!builder.process(model, meshletOpts)) {
+                progress.error("optim", "Meshlet generation failed: " + builder.getError());
+                return 1;
+            }
+            
+            if (optimVerbose) {
+                std::cout << builder.getStats() << std::endl;
+            }
+            profiler.end(model);
         }
         
 #ifdef GLTFU_ENABLE_DRACO
         // Step 6.5: Compress meshes with Draco (in-place)
         if (optimCompress) {
             progress.report("optim", "Step 6.5: Compressing meshes with Draco", 0.84);
+            profiler.begin("compress", model);
             
             gltfu::GltfCompress compressor;
-            gltfu::CompressOptions compressOpts;
-            compressOpts.positionQuantizationBits = optimCompressPositionBits;
-            compressOpts.normalQuantizationBits = optimCompressNormalBits;
-            compressOpts.texCoordQuantizationBits = optimCompressTexcoordBits;
-            compressOpts.colorQuantizationBits = optimCompressColorBits;
-            compressOpts.verbose = optimVerbose;
-            
             if (!compressor.process(model, compressOpts)) {
                 progress.error("optim", "Compression operation failed: " + compressor.getError());
                 return 1;
@@ -1206,19 +2416,34 @@ int main(int argc, char** argv) {
             if (optimVerbose) {
                 std::cout << compressor.getStats() << std::endl;
             }
+            if (optimCompressVerify) {
+                const gltfu::CompressVerification& verification = compressor.getVerification();
+                const double seconds = std::max(verification.decodeSeconds, 1e-9);
+                std::ostringstream message;
+                message << "Round trip: position max " << verification.maxPositionError << ", normal max "
+                        << verification.maxNormalError << " deg, UV max " << verification.maxTexCoordError;
+                progress.metrics("compress-verify", message.str(),
+                                 {{"primitives", static_cast<double>(verification.primitives)},
+                                  {"maxPositionError", verification.maxPositionError},
+                                  {"rmsPositionError", verification.rmsPositionError},
+                                  {"maxNormalError", verification.maxNormalError},
+                                  {"rmsNormalError", verification.rmsNormalError},
+                                  {"maxTexCoordError", verification.maxTexCoordError},
+                                  {"rmsTexCoordError", verification.rmsTexCoordError},
+                                  {"decodeSeconds", verification.decodeSeconds},
+                                  {"decodeBytesPerSecond", verification.bytes / seconds},
+                                  {"decodeVerticesPerSecond", verification.vertices / seconds}});
+            }
+            profiler.end(model);
         }
 #endif
         
         // Step 7: Prune unused resources (in-place)
         if (!optimSkipPrune) {
             progress.report("optim", "Step 7: Pruning unused resources", 0.87);
+            profiler.begin("prune", model);
             
             gltfu::GltfPrune pruner;
-            gltfu::PruneOptions pruneOpts;
-            pruneOpts.keepLeaves = false;
-            pruneOpts.keepAttributes = false;
-            pruneOpts.verbose = optimVerbose;
-            
             if (!pruner.process(model, pruneOpts)) {
                 progress.error("optim", "Prune operation failed");
                 return 1;
@@ -1230,17 +2455,41 @@ int main(int argc, char** argv) {
                     std::cout << "  " << stats << std::endl;
                 }
             }
+            profiler.end(model);
         }
         
         // Step 8: Compute bounds for all POSITION accessors (required by spec)
         progress.report("optim", "Computing accessor bounds", 0.93);
+        profiler.begin("bounds", model);
         int boundsComputed = gltfu::GltfBounds::computeAllBounds(model);
         if (optimVerbose && boundsComputed > 0) {
             std::cout << "  Computed bounds for " << boundsComputed << " accessors" << std::endl;
         }
+        profiler.end(model);
+        
+        // The BVH indexes final node indices, so nothing may touch nodes after it
+        if (optimBvh) {
+            progress.report("optim", "Building scene BVH", 0.94);
+            profiler.begin("bvh", model);
+            
+            gltfu::GltfBvh builder;
+            gltfu::BvhOptions bvhOpts;
+            bvhOpts.verbose = optimVerbose;
+            if (!builder.process(model, bvhOpts)) {
+                progress.error("optim", "BVH build failed: " + builder.getError());
+                return 1;
+            }
+            profiler.end(model);
+        }
         
         // Final step: Write output with proper settings
         progress.report("optim", "Writing optimized output", 0.95);
+        profiler.begin("write", model);
+        
+        // A previous --cache-link hit may have left the output linked to a cache entry
+        if (cache) {
+            gltfu::GltfCache::releaseOutput(optimOutput);
+        }
         
         bool writeRet;
         if (optimWriteBinary) {
@@ -1258,7 +2507,20 @@ int main(int argc, char** argv) {
             progress.error("optim", "Failed to write final output");
             return 1;
         }
+        profiler.end(model);
+
+        // Only single-file outputs can be restored from the cache as-is
+        if (cache) {
+            if (!gltfu::GltfCache::isSelfContained(model, optimEmbedImages, optimEmbedBuffers, optimWriteBinary)) {
+                if (optimVerbose) {
+                    std::cout << "  Output references external files; not cached" << std::endl;
+                }
+            } else if (!cache->store(cacheKey, optimOutput) && !jsonProgress) {
+                std::cerr << "Warning: " << cache->getError() << std::endl;
+            }
+        }
         
+        profiler.summary();
         progress.success("optim", "Optimization complete: " + optimOutput);
         return 0;
     });
@@ -1269,6 +2531,14 @@ int main(int argc, char** argv) {
     } catch (const CLI::ParseError& e) {
         return app.exit(e);
     }
+
+    if (!tracePath.empty()) {
+        std::string traceError;
+        if (!gltfu::Tracer::write(tracePath, traceError)) {
+            std::cerr << "Error: " << traceError << std::endl;
+            return 1;
+        }
+    }
     
     return 0;
 }
@@ -1,6 +1,7 @@
 #ifndef GLTFU_MATH_UTILS_H
 #define GLTFU_MATH_UTILS_H
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 
@@ -29,6 +30,23 @@ inline Matrix4 multiply(const Matrix4& lhs, const Matrix4& rhs) {
     return result;
 }
 
+using Vector3 = std::array<double, 3>;
+
+// Axis-aligned bounds of a transformed box (Arvo's method, exact for affine matrices).
+inline void transformBounds(const Matrix4& matrix, const Vector3& min, const Vector3& max,
+                            Vector3& outMin, Vector3& outMax) {
+    for (std::size_t row = 0; row < 3; ++row) {
+        outMin[row] = matrix[row + 12];
+        outMax[row] = matrix[row + 12];
+        for (std::size_t col = 0; col < 3; ++col) {
+            const double a = matrix[row + col * 4] * min[col];
+            const double b = matrix[row + col * 4] * max[col];
+            outMin[row] += std::min(a, b);
+            outMax[row] += std::max(a, b);
+        }
+    }
+}
+
 } // namespace gltfu
 
 #endif // GLTFU_MATH_UTILS_H
@@ -0,0 +1,246 @@
+#include "pipeline_profiler.h"
+
+#include "trace.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <sys/time.h>
+#endif
+
+namespace gltfu {
+namespace {
+
+std::string formatBytes(size_t bytes) {
+    std::ostringstream stream;
+    stream << std::fixed << std::setprecision(1);
+    if (bytes >= (size_t(1) << 30)) {
+        stream << static_cast<double>(bytes) / (1 << 30) << " GiB";
+    } else if (bytes >= (size_t(1) << 20)) {
+        stream << static_cast<double>(bytes) / (1 << 20) << " MiB";
+    } else {
+        stream << static_cast<double>(bytes) / (1 << 10) << " KiB";
+    }
+    return stream.str();
+}
+
+void appendCounts(ProgressReporter::Metrics& values, const char* prefix, const ModelCounts& counts) {
+    const std::string p(prefix);
+    values.emplace_back(p + "nodes", static_cast<double>(counts.nodes));
+    values.emplace_back(p + "meshes", static_cast<double>(counts.meshes));
+    values.emplace_back(p + "primitives", static_cast<double>(counts.primitives));
+    values.emplace_back(p + "accessors", static_cast<double>(counts.accessors));
+    values.emplace_back(p + "bufferViews", static_cast<double>(counts.bufferViews));
+    values.emplace_back(p + "materials", static_cast<double>(counts.materials));
+    values.emplace_back(p + "textures", static_cast<double>(counts.textures));
+    values.emplace_back(p + "images", static_cast<double>(counts.images));
+    values.emplace_back(p + "vertices", static_cast<double>(counts.vertices));
+    values.emplace_back(p + "triangles", static_cast<double>(counts.triangles));
+    values.emplace_back(p + "bufferBytes", static_cast<double>(counts.bufferBytes));
+}
+
+// Only mention the counts a stage actually changed to keep text output short.
+void describeChanges(std::ostringstream& stream, const ModelCounts& in, const ModelCounts& out) {
+    const struct {
+        const char* name;
+        size_t before;
+        size_t after;
+    } fields[] = {
+        {"nodes", in.nodes, out.nodes},
+        {"meshes", in.meshes, out.meshes},
+        {"primitives", in.primitives, out.primitives},
+        {"accessors", in.accessors, out.accessors},
+        {"materials", in.materials, out.materials},
+        {"textures", in.textures, out.textures},
+        {"vertices", in.vertices, out.vertices},
+        {"triangles", in.triangles, out.triangles},
+    };
+
+    const char* separator = "; ";
+    for (const auto& field : fields) {
+        if (field.before != field.after) {
+            stream << separator << field.name << ' ' << field.before << " → " << field.after;
+            separator = ", ";
+        }
+    }
+}
+
+} // namespace
+
+ModelCounts ModelCounts::from(const tinygltf::Model& model) {
+    ModelCounts counts;
+    counts.nodes = model.nodes.size();
+    counts.meshes = model.meshes.size();
+    counts.accessors = model.accessors.size();
+    counts.bufferViews = model.bufferViews.size();
+    counts.materials = model.materials.size();
+    counts.textures = model.textures.size();
+    counts.images = model.images.size();
+
+    for (const auto& buffer : model.buffers) {
+        counts.bufferBytes += buffer.data.size();
+    }
+
+    const auto accessorCount = [&model](int index) -> size_t {
+        if (index < 0 || index >= static_cast<int>(model.accessors.size())) {
+            return 0;
+        }
+        return model.accessors[index].count;
+    };
+
+    for (const auto& mesh : model.meshes) {
+        counts.primitives += mesh.primitives.size();
+        for (const auto& primitive : mesh.primitives) {
+            const auto position = primitive.attributes.find("POSITION");
+            const size_t vertexCount = position != primitive.attributes.end() ? accessorCount(position->second) : 0;
+            counts.vertices += vertexCount;
+
+            const size_t elements = primitive.indices >= 0 ? accessorCount(primitive.indices) : vertexCount;
+            if (primitive.mode == TINYGLTF_MODE_TRIANGLES) {
+                counts.triangles += elements / 3;
+            } else if ((primitive.mode == TINYGLTF_MODE_TRIANGLE_STRIP ||
+                        primitive.mode == TINYGLTF_MODE_TRIANGLE_FAN) && elements >= 3) {
+                counts.triangles += elements - 2;
+            }
+        }
+    }
+    return counts;
+}
+
+PipelineProfiler::PipelineProfiler(ProgressReporter& progress, std::string operation)
+    : progress_(progress), operation_(std::move(operation)) {}
+
+double PipelineProfiler::processCpuMs() {
+#ifdef _WIN32
+    FILETIME creation, exitTime, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exitTime, &kernel, &user)) {
+        return 0.0;
+    }
+    const auto toMs = [](const FILETIME& time) {
+        const ULONGLONG ticks = (static_cast<ULONGLONG>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+        return static_cast<double>(ticks) / 10000.0;
+    };
+    return toMs(kernel) + toMs(user);
+#else
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0.0;
+    }
+    const auto toMs = [](const timeval& time) {
+        return static_cast<double>(time.tv_sec) * 1000.0 + static_cast<double>(time.tv_usec) / 1000.0;
+    };
+    return toMs(usage.ru_utime) + toMs(usage.ru_stime);
+#endif
+}
+
+size_t PipelineProfiler::peakRssBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return static_cast<size_t>(counters.PeakWorkingSetSize);
+#else
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss);          // bytes
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;   // kilobytes
+#endif
+#endif
+}
+
+void PipelineProfiler::begin(const std::string& stage, const tinygltf::Model& model) {
+    if (open_) {
+        end(model);
+    }
+
+    current_ = StageMetrics{};
+    current_.name = stage;
+    current_.in = ModelCounts::from(model);
+    open_ = true;
+
+    rssStart_ = peakRssBytes();
+    cpuStart_ = processCpuMs();
+    traceStart_ = Tracer::now();
+    wallStart_ = std::chrono::steady_clock::now();
+}
+
+void PipelineProfiler::end(const tinygltf::Model& model) {
+    if (!open_) {
+        return;
+    }
+    open_ = false;
+
+    const auto wallEnd = std::chrono::steady_clock::now();
+    Tracer::record("stage", current_.name.c_str(), traceStart_, Tracer::now());
+    current_.wallMs = std::chrono::duration<double, std::milli>(wallEnd - wallStart_).count();
+    current_.cpuMs = processCpuMs() - cpuStart_;
+    current_.peakRssBytes = peakRssBytes();
+    current_.peakRssDeltaBytes = current_.peakRssBytes > rssStart_ ? current_.peakRssBytes - rssStart_ : 0;
+    current_.out = ModelCounts::from(model);
+
+    std::ostringstream message;
+    message << std::fixed << std::setprecision(1)
+            << current_.name << ": " << current_.wallMs << " ms wall, "
+            << current_.cpuMs << " ms cpu, peak RSS +" << formatBytes(current_.peakRssDeltaBytes);
+    describeChanges(message, current_.in, current_.out);
+
+    ProgressReporter::Metrics values;
+    values.emplace_back("wallMs", current_.wallMs);
+    values.emplace_back("cpuMs", current_.cpuMs);
+    values.emplace_back("peakRssBytes", static_cast<double>(current_.peakRssBytes));
+    values.emplace_back("peakRssDeltaBytes", static_cast<double>(current_.peakRssDeltaBytes));
+    appendCounts(values, "in.", current_.in);
+    appendCounts(values, "out.", current_.out);
+
+    progress_.metrics(operation_, message.str(), values);
+    stages_.push_back(std::move(current_));
+}
+
+void PipelineProfiler::summary() {
+    if (stages_.empty()) {
+        return;
+    }
+
+    double totalWall = 0.0;
+    double totalCpu = 0.0;
+    const StageMetrics* slowest = &stages_.front();
+    for (const auto& stage : stages_) {
+        totalWall += stage.wallMs;
+        totalCpu += stage.cpuMs;
+        if (stage.wallMs > slowest->wallMs) {
+            slowest = &stage;
+        }
+    }
+
+    std::ostringstream message;
+    message << std::fixed << std::setprecision(1)
+            << "Summary: " << totalWall << " ms wall, " << totalCpu << " ms cpu, peak RSS "
+            << formatBytes(peakRssBytes()) << "; slowest stage " << slowest->name
+            << " (" << (totalWall > 0.0 ? slowest->wallMs * 100.0 / totalWall : 0.0) << "%)";
+
+    ProgressReporter::Metrics values;
+    values.emplace_back("wallMs", totalWall);
+    values.emplace_back("cpuMs", totalCpu);
+    values.emplace_back("peakRssBytes", static_cast<double>(peakRssBytes()));
+    for (const auto& stage : stages_) {
+        values.emplace_back(stage.name + ".wallMs", stage.wallMs);
+    }
+
+    progress_.metrics(operation_, message.str(), values);
+}
+
+} // namespace gltfu
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "progress_reporter.h"
+#include "tiny_gltf.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gltfu {
+
+/**
+ * Element counts used to describe what a stage consumed and produced.
+ */
+struct ModelCounts {
+    size_t nodes = 0;
+    size_t meshes = 0;
+    size_t primitives = 0;
+    size_t accessors = 0;
+    size_t bufferViews = 0;
+    size_t materials = 0;
+    size_t textures = 0;
+    size_t images = 0;
+    size_t vertices = 0;      // Sum of POSITION counts over all primitives
+    size_t triangles = 0;     // Triangles across triangle, strip and fan primitives
+    size_t bufferBytes = 0;
+
+    static ModelCounts from(const tinygltf::Model& model);
+};
+
+/**
+ * Measurements for a single pipeline stage.
+ */
+struct StageMetrics {
+    std::string name;
+    double wallMs = 0.0;
+    double cpuMs = 0.0;
+    size_t peakRssBytes = 0;       // Process peak RSS after the stage
+    size_t peakRssDeltaBytes = 0;  // Growth of the process peak during the stage
+    ModelCounts in;
+    ModelCounts out;
+};
+
+/**
+ * Records wall time, CPU time, peak RSS growth and element counts for each
+ * stage of a pipeline, reporting them through a ProgressReporter as they
+ * complete and in an end-of-run summary. Stages also appear on the trace
+ * timeline when tracing is enabled.
+ */
+class PipelineProfiler {
+public:
+    PipelineProfiler(ProgressReporter& progress, std::string operation);
+
+    /**
+     * Start timing a stage. Any stage still open is closed first.
+     */
+    void begin(const std::string& stage, const tinygltf::Model& model);
+
+    /**
+     * Finish the open stage and report its metrics.
+     */
+    void end(const tinygltf::Model& model);
+
+    /**
+     * Report totals for all finished stages.
+     */
+    void summary();
+
+    const std::vector<StageMetrics>& getStages() const { return stages_; }
+
+    /** Process CPU time (user + system) in milliseconds */
+    static double processCpuMs();
+
+    /** Process peak resident set size in bytes (0 if unavailable) */
+    static size_t peakRssBytes();
+
+private:
+    ProgressReporter& progress_;
+    std::string operation_;
+    std::vector<StageMetrics> stages_;
+
+    bool open_ = false;
+    StageMetrics current_;
+    std::chrono::steady_clock::time_point wallStart_;
+    double cpuStart_ = 0.0;
+    uint64_t traceStart_ = 0;
+    size_t rssStart_ = 0;
+};
+
+} // namespace gltfu
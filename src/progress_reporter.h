@@ -2,7 +2,10 @@
 #define PROGRESS_REPORTER_H
 
 #include <string>
+#include <cmath>
 #include <functional>
+#include <utility>
+#include <vector>
 #include <iostream>
 #include <sstream>
 #include <iomanip>
@@ -25,6 +28,7 @@ public:
     };
 
     using ProgressCallback = std::function<void(const std::string&)>;
+    using Metrics = std::vector<std::pair<std::string, double>>;
 
     ProgressReporter(Format format = Format::Text, std::ostream& out = std::cout)
         : format_(format), out_(out) {}
@@ -79,7 +83,43 @@ public:
         }
     }
 
+    /**
+     * @brief Report measurements for an operation
+     * @param message Human-readable summary (the only part shown in text mode)
+     * @param values Named measurements, emitted as a JSON object in JSON mode
+     */
+    void metrics(const std::string& operation,
+                 const std::string& message,
+                 const Metrics& values) {
+        if (format_ == Format::Silent) {
+            return;
+        } else if (format_ == Format::JSON) {
+            out_ << "{\"type\":\"metrics\",\"operation\":\"" << escapeJSON(operation) << "\"";
+            out_ << ",\"message\":\"" << escapeJSON(message) << "\"";
+            out_ << ",\"values\":{";
+            for (size_t i = 0; i < values.size(); ++i) {
+                out_ << (i ? "," : "") << "\"" << escapeJSON(values[i].first) << "\":"
+                     << formatNumber(values[i].second);
+            }
+            out_ << "}}" << std::endl;
+        } else {
+            out_ << "[" << operation << "] " << message << std::endl;
+        }
+    }
+
 private:
+    static std::string formatNumber(double value) {
+        std::ostringstream ss;
+        if (!std::isfinite(value)) {
+            ss << "null";
+        } else if (value == std::floor(value) && std::fabs(value) < 1e15) {
+            ss << static_cast<long long>(value);
+        } else {
+            ss << std::fixed << std::setprecision(3) << value;
+        }
+        return ss.str();
+    }
+
     void reportJSON(const std::string& operation, 
                     const std::string& message,
                     double progress,
@@ -128,7 +168,7 @@ private:
                 case '\r': ss << "\\r"; break;
                 case '\t': ss << "\\t"; break;
                 default:
-                    if (c < 0x20) {
+                    if (static_cast<unsigned char>(c) < 0x20) {
                         ss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c);
                     } else {
                         ss << c;
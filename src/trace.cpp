@@ -0,0 +1,209 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace gltfu {
+namespace {
+
+constexpr size_t kNameLength = 64;
+
+struct TraceEvent {
+    const char* category = nullptr;
+    char name[kNameLength] = {};
+    uint64_t startNs = 0;
+    uint64_t endNs = 0;
+};
+
+// Written only by its owning thread; read by write() once recording is done.
+struct ThreadBuffer {
+    ThreadBuffer(size_t capacity, uint32_t id) : events(capacity), tid(id) {}
+
+    std::vector<TraceEvent> events;
+    std::atomic<uint64_t> written{0};
+    uint32_t tid;
+    std::string name;
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    std::atomic<bool> enabled{false};
+    size_t capacity = 0;
+    const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+// The registry lock is only taken the first time a thread records an event.
+ThreadBuffer& threadBuffer() {
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (!buffer) {
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.buffers.push_back(std::make_unique<ThreadBuffer>(reg.capacity, static_cast<uint32_t>(reg.buffers.size() + 1)));
+        buffer = reg.buffers.back().get();
+    }
+    return *buffer;
+}
+
+void copyName(char (&dst)[kNameLength], const char* src) {
+    std::strncpy(dst, src, kNameLength - 1);
+    dst[kNameLength - 1] = '\0';
+}
+
+void writeEscaped(std::ostream& out, const char* text) {
+    for (const char* c = text; *c; ++c) {
+        switch (*c) {
+            case '"': out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\n': out << "\\n"; break;
+            case '\t': out << "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(*c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(*c));
+                    out << escaped;
+                } else {
+                    out << *c;
+                }
+        }
+    }
+}
+
+void writeMicroseconds(std::ostream& out, uint64_t ns) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%llu.%03llu",
+                  static_cast<unsigned long long>(ns / 1000),
+                  static_cast<unsigned long long>(ns % 1000));
+    out << text;
+}
+
+} // namespace
+
+void Tracer::enable(size_t eventsPerThread) {
+    auto& reg = registry();
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.capacity = std::max<size_t>(eventsPerThread, 1);
+        reg.enabled.store(true, std::memory_order_release);
+    }
+    setThreadName("main");
+}
+
+bool Tracer::isEnabled() {
+    return registry().enabled.load(std::memory_order_relaxed);
+}
+
+uint64_t Tracer::now() {
+    const auto elapsed = std::chrono::steady_clock::now() - registry().epoch;
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+void Tracer::record(const char* category, const char* name, uint64_t startNs, uint64_t endNs) {
+    if (!isEnabled()) {
+        return;
+    }
+
+    ThreadBuffer& buffer = threadBuffer();
+    const uint64_t index = buffer.written.load(std::memory_order_relaxed);
+    TraceEvent& event = buffer.events[index % buffer.events.size()];
+    event.category = category;
+    copyName(event.name, name);
+    event.startNs = startNs;
+    event.endNs = endNs;
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+void Tracer::setThreadName(const std::string& name) {
+    if (!isEnabled()) {
+        return;
+    }
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    buffer.name = name;
+}
+
+bool Tracer::write(const std::string& path, std::string& error) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        error = "Failed to open trace file: " + path;
+        return false;
+    }
+
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    uint64_t dropped = 0;
+    const char* separator = "\n";
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for (const auto& buffer : reg.buffers) {
+        const std::string threadName = buffer->name.empty()
+            ? "thread " + std::to_string(buffer->tid)
+            : buffer->name;
+        out << separator << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+            << ",\"args\":{\"name\":\"";
+        writeEscaped(out, threadName.c_str());
+        out << "\"}}";
+        separator = ",\n";
+
+        const uint64_t written = buffer->written.load(std::memory_order_acquire);
+        const uint64_t capacity = buffer->events.size();
+        const uint64_t first = written > capacity ? written - capacity : 0;
+        dropped += first;
+
+        for (uint64_t i = first; i < written; ++i) {
+            const TraceEvent& event = buffer->events[i % capacity];
+            out << separator << "{\"name\":\"";
+            writeEscaped(out, event.name);
+            out << "\",\"cat\":\"" << event.category << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid
+                << ",\"ts\":";
+            writeMicroseconds(out, event.startNs);
+            out << ",\"dur\":";
+            writeMicroseconds(out, event.endNs > event.startNs ? event.endNs - event.startNs : 0);
+            out << "}";
+        }
+    }
+    out << "\n],\"otherData\":{\"droppedEvents\":" << dropped << "}}\n";
+
+    if (!out) {
+        error = "Failed to write trace file: " + path;
+        return false;
+    }
+    return true;
+}
+
+TraceScope::TraceScope(const char* category, const char* name, long long first, long long second) {
+    if (!Tracer::isEnabled()) {
+        return;
+    }
+    category_ = category;
+    if (first >= 0 && second >= 0) {
+        std::snprintf(name_, sizeof(name_), "%s %lld:%lld", name, first, second);
+    } else if (first >= 0) {
+        std::snprintf(name_, sizeof(name_), "%s %lld", name, first);
+    } else {
+        copyName(name_, name);
+    }
+    start_ = Tracer::now();
+}
+
+TraceScope::TraceScope(const char* category, const std::string& name)
+    : TraceScope(category, name.c_str()) {}
+
+TraceScope::~TraceScope() {
+    if (category_) {
+        Tracer::record(category_, name_, start_, Tracer::now());
+    }
+}
+
+} // namespace gltfu
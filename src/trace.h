@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace gltfu {
+
+/**
+ * Process-wide timeline recorder that exports Chrome Trace Event JSON,
+ * viewable in Perfetto (ui.perfetto.dev) or chrome://tracing.
+ *
+ * Every thread appends complete events to its own fixed-size ring buffer, so
+ * recording never takes a lock; once a buffer is full the oldest events are
+ * overwritten. Recording is a no-op until enable() is called.
+ */
+class Tracer {
+public:
+    /**
+     * Start recording.
+     * @param eventsPerThread Ring buffer capacity for each thread
+     */
+    static void enable(size_t eventsPerThread = size_t(1) << 16);
+
+    static bool isEnabled();
+
+    /** Nanoseconds since the tracer's epoch */
+    static uint64_t now();
+
+    /**
+     * Record a finished event on the calling thread's buffer.
+     * The category must be a string literal; the name is copied (and truncated).
+     */
+    static void record(const char* category, const char* name, uint64_t startNs, uint64_t endNs);
+
+    /** Name the calling thread in the exported timeline */
+    static void setThreadName(const std::string& name);
+
+    /**
+     * Write all recorded events to path in Chrome Trace Event format.
+     * Must not race with threads that are still recording.
+     */
+    static bool write(const std::string& path, std::string& error);
+};
+
+/**
+ * RAII helper recording the lifetime of a scope as a single trace event.
+ *
+ * The optional indices are appended to the name ("simplify 3:1") and are only
+ * formatted when tracing is enabled.
+ */
+class TraceScope {
+public:
+    TraceScope(const char* category, const char* name, long long first = -1, long long second = -1);
+    TraceScope(const char* category, const std::string& name);
+    ~TraceScope();
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* category_ = nullptr;
+    char name_[64] = {};
+    uint64_t start_ = 0;
+};
+
+} // namespace gltfu